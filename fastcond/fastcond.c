@@ -174,6 +174,10 @@
  *   allowed, but threads waiting before signal() must eventually wake.
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* sem_clockwait */
+#endif
+
 #include "fastcond.h"
 
 #include <assert.h>
@@ -231,11 +235,12 @@ fastcond_get_test_callback(void)
 #define SEM_INIT(sem) (((sem) = CreateSemaphoreW(NULL, 0, LONG_MAX, NULL)) ? 0 : ENOMEM)
 #define SEM_DESTROY(sem) (CloseHandle(sem) ? 0 : EINVAL)
 #define SEM_WAIT(sem) (WaitForSingleObject((sem), INFINITE) == WAIT_OBJECT_0 ? 0 : EINVAL)
-#define SEM_TIMEDWAIT(sem, abstime) _sem_timedwait_windows((sem), (abstime))
+#define SEM_TIMEDWAIT(sem, abstime, mono) _sem_timedwait_windows((sem), (abstime), (mono))
 #define SEM_POST(sem) (ReleaseSemaphore((sem), 1, NULL) ? 0 : EINVAL)
 
-/* Helper function to convert absolute timespec to relative timeout and wait */
-static int _sem_timedwait_windows(HANDLE sem, const struct timespec *abstime)
+/* Helper function to convert absolute timespec to relative timeout and wait.
+ * mono: abstime is on native_monotonic_ns()'s clock rather than TIME_UTC. */
+static int _sem_timedwait_windows(HANDLE sem, const struct timespec *abstime, int mono)
 {
     DWORD timeout_ms;
 
@@ -246,7 +251,13 @@ static int _sem_timedwait_windows(HANDLE sem, const struct timespec *abstime)
 
     /* Convert absolute timespec to relative timeout in milliseconds */
     struct timespec now;
-    timespec_get(&now, TIME_UTC); /* C11 standard, widely supported */
+    if (mono) {
+        long long ns = native_monotonic_ns();
+        now.tv_sec = (time_t) (ns / 1000000000LL);
+        now.tv_nsec = (long) (ns % 1000000000LL);
+    } else {
+        timespec_get(&now, TIME_UTC); /* C11 standard, widely supported */
+    }
 
     long long ns_diff =
         (abstime->tv_sec - now.tv_sec) * 1000000000LL + (abstime->tv_nsec - now.tv_nsec);
@@ -278,11 +289,12 @@ static int _sem_timedwait_windows(HANDLE sem, const struct timespec *abstime)
 #define SEM_INIT(sem) ((sem) = dispatch_semaphore_create(0), (sem) ? 0 : ENOMEM)
 #define SEM_DESTROY(sem) (dispatch_release(sem), 0)
 #define SEM_WAIT(sem) (dispatch_semaphore_wait((sem), DISPATCH_TIME_FOREVER))
-#define SEM_TIMEDWAIT(sem, abstime) _sem_timedwait_gcd((sem), (abstime))
+#define SEM_TIMEDWAIT(sem, abstime, mono) _sem_timedwait_gcd((sem), (abstime), (mono))
 #define SEM_POST(sem) (dispatch_semaphore_signal(sem), 0)
 
-/* Helper function to convert absolute timespec to dispatch_time_t and wait */
-static int _sem_timedwait_gcd(dispatch_semaphore_t sem, const struct timespec *abstime)
+/* Helper function to convert absolute timespec to dispatch_time_t and wait.
+ * mono: abstime is on CLOCK_MONOTONIC rather than CLOCK_REALTIME. */
+static int _sem_timedwait_gcd(dispatch_semaphore_t sem, const struct timespec *abstime, int mono)
 {
     dispatch_time_t timeout;
 
@@ -293,7 +305,7 @@ static int _sem_timedwait_gcd(dispatch_semaphore_t sem, const struct timespec *a
 
     /* Convert absolute timespec to dispatch_time_t */
     struct timespec now;
-    clock_gettime(CLOCK_REALTIME, &now);
+    clock_gettime(mono ? CLOCK_MONOTONIC : CLOCK_REALTIME, &now);
 
     long long ns_diff =
         (abstime->tv_sec - now.tv_sec) * 1000000000LL + (abstime->tv_nsec - now.tv_nsec);
@@ -314,9 +326,33 @@ static int _sem_timedwait_gcd(dispatch_semaphore_t sem, const struct timespec *a
 #define SEM_INIT(sem) (sem_init(&(sem), 0, 0) ? errno : 0)
 #define SEM_DESTROY(sem) (sem_destroy(&(sem)) ? errno : 0)
 #define SEM_WAIT(sem) (sem_wait(&(sem)) ? errno : 0)
-#define SEM_TIMEDWAIT(sem, abstime)                                                                \
-    ((abstime) ? (sem_timedwait(&(sem), (abstime)) ? errno : 0) : SEM_WAIT(sem))
+#define SEM_TIMEDWAIT(sem, abstime, mono)                                                          \
+    ((abstime) ? (_sem_timedwait_posix(&(sem), (abstime), (mono)) ? errno : 0) : SEM_WAIT(sem))
 #define SEM_POST(sem) (sem_post(&(sem)) ? errno : 0)
+
+/* sem_timedwait() for an abstime on CLOCK_REALTIME, and with mono set, on CLOCK_MONOTONIC.
+ * glibc 2.30 and later waits on CLOCK_MONOTONIC directly; elsewhere the deadline becomes
+ * the CLOCK_REALTIME one that is as far away now.  Returns -1 with errno set, as they do. */
+static int _sem_timedwait_posix(sem_t *sem, const struct timespec *abstime, int mono)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 30))
+    return mono ? sem_clockwait(sem, CLOCK_MONOTONIC, abstime) : sem_timedwait(sem, abstime);
+#else
+    struct timespec deadline;
+    long long ns;
+
+    if (!mono)
+        return sem_timedwait(sem, abstime);
+    ns = (long long) abstime->tv_sec * 1000000000LL + abstime->tv_nsec - native_monotonic_ns();
+    native_deadline_us(&deadline, 0);
+    if (ns > 0) {
+        ns += deadline.tv_nsec;
+        deadline.tv_sec += (time_t) (ns / 1000000000LL);
+        deadline.tv_nsec = (long) (ns % 1000000000LL);
+    }
+    return sem_timedwait(sem, &deadline);
+#endif
+}
 #endif
 
 /* Platform-specific thread yield */
@@ -339,6 +375,176 @@ static int _sem_timedwait_gcd(dispatch_semaphore_t sem, const struct timespec *a
 #define MAYBE_YIELD() ((void) 0) /* No-op */
 #endif
 
+/* fastcond_mutex_t implementation
+ *
+ * Linux: Drepper's three-state futex mutex ("Futexes Are Tricky", mutex3), with two
+ * additions.  A waiters count, kept exactly by the slow path, lets a contended unlock
+ * skip the wake-up when every waiter has already gone, since state 2 only says there
+ * may be waiters.  And state 3, "handed off", which FASTCOND_MUTEX_HANDOFF unlocks
+ * store instead of 0: only threads in the slow path's wait loop may take it, and a
+ * thread that has not yet slept first yields a few times to let the woken one in.
+ * A waiter always takes the lock as state 2, as it cannot know whether it was last.
+ */
+
+/* Upper bound for the adaptive spin before sleeping, in NATIVE_CPU_RELAX() rounds */
+#ifndef FASTCOND_MUTEX_SPIN_MAX
+#define FASTCOND_MUTEX_SPIN_MAX 100
+#endif
+
+/* Yields a thread that has not slept makes before taking a handed-off lock itself */
+#ifndef FASTCOND_MUTEX_HANDOFF_GRACE
+#define FASTCOND_MUTEX_HANDOFF_GRACE 2
+#endif
+
+#if NATIVE_HAVE_FUTEX
+FASTCOND_API(int)
+fastcond_mutex_init(fastcond_mutex_t *mutex, int flags)
+{
+    mutex->state = 0;
+    mutex->waiters = 0;
+    mutex->spins = 0;
+    mutex->spin_max = native_cpu_count() > 1 ? FASTCOND_MUTEX_SPIN_MAX : 0;
+    mutex->flags = flags;
+    return 0;
+}
+
+FASTCOND_API(int)
+fastcond_mutex_fini(fastcond_mutex_t *mutex)
+{
+    return mutex->state ? EBUSY : 0;
+}
+
+/* Spin for a while, taking the lock only if it is free.  The limit adapts as in glibc:
+ * twice the running average plus a little, so it can grow when spinning pays off.
+ * The average is updated without synchronization; it is only a heuristic.
+ */
+static int _mutex_spin(fastcond_mutex_t *mutex)
+{
+    int limit = mutex->spins * 2 + 10;
+    int i;
+
+    if (limit > mutex->spin_max)
+        limit = mutex->spin_max;
+    for (i = 0; i < limit; i++) {
+        if (native_atomic_load(&mutex->state) == 0 && native_atomic_cas(&mutex->state, 0, 1)) {
+            mutex->spins += (i - mutex->spins) / 8;
+            return 1;
+        }
+        NATIVE_CPU_RELAX();
+    }
+    mutex->spins += (limit - mutex->spins) / 8;
+    return 0;
+}
+
+FASTCOND_API(int)
+fastcond_mutex_lock(fastcond_mutex_t *mutex)
+{
+    int slept = 0, grace = 0;
+
+    if (native_atomic_cas(&mutex->state, 0, 1))
+        return 0;
+    if (mutex->spin_max && _mutex_spin(mutex))
+        return 0;
+
+    native_atomic_add(&mutex->waiters, 1);
+    for (;;) {
+        int c = native_atomic_load(&mutex->state);
+        if (c == 3 && !slept && grace < FASTCOND_MUTEX_HANDOFF_GRACE) {
+            /* handed off while a woken waiter may be on its way; give it the chance */
+            grace++;
+            YIELD();
+            continue;
+        }
+        if (c == 0 || c == 3) {
+            if (native_atomic_cas(&mutex->state, c, 2))
+                break;
+            continue;
+        }
+        if (c == 1 && !native_atomic_cas(&mutex->state, 1, 2))
+            continue;
+        native_futex_wait(&mutex->state, 2, NULL);
+        slept = 1;
+    }
+    native_atomic_add(&mutex->waiters, -1);
+    return 0;
+}
+
+FASTCOND_API(int)
+fastcond_mutex_trylock(fastcond_mutex_t *mutex)
+{
+    return native_atomic_cas(&mutex->state, 0, 1) ? 0 : EBUSY;
+}
+
+FASTCOND_API(int)
+fastcond_mutex_unlock(fastcond_mutex_t *mutex)
+{
+    if (native_atomic_cas(&mutex->state, 1, 0))
+        return 0;
+
+    /* Contended.  A waiter only leaves the count by taking the lock, which we still hold,
+     * so a nonzero count here means someone will take a handed-off lock.
+     */
+    if ((mutex->flags & FASTCOND_MUTEX_HANDOFF) && native_atomic_load(&mutex->waiters) > 0) {
+        native_atomic_store(&mutex->state, 3);
+        native_futex_wake(&mutex->state, 1);
+        return 0;
+    }
+    /* Both the exchange and the waiters increment are sequentially consistent, so either
+     * we see the new waiter, or it sees the lock free and does not sleep.
+     */
+    native_atomic_exchange(&mutex->state, 0);
+    if (native_atomic_load(&mutex->waiters) > 0)
+        native_futex_wake(&mutex->state, 1);
+    return 0;
+}
+#else
+FASTCOND_API(int)
+fastcond_mutex_init(fastcond_mutex_t *mutex, int flags)
+{
+    mutex->flags = flags;
+    return native_mutex_init_kind(&mutex->mutex, NATIVE_MUTEX_KIND);
+}
+
+FASTCOND_API(int)
+fastcond_mutex_fini(fastcond_mutex_t *mutex)
+{
+#ifdef FASTCOND_USE_WINDOWS
+    NATIVE_MUTEX_DESTROY(&mutex->mutex);
+    return 0;
+#else
+    return NATIVE_MUTEX_DESTROY(&mutex->mutex);
+#endif
+}
+
+FASTCOND_API(int)
+fastcond_mutex_lock(fastcond_mutex_t *mutex)
+{
+    return NATIVE_MUTEX_LOCK(&mutex->mutex);
+}
+
+FASTCOND_API(int)
+fastcond_mutex_trylock(fastcond_mutex_t *mutex)
+{
+    return NATIVE_MUTEX_TRYLOCK(&mutex->mutex);
+}
+
+FASTCOND_API(int)
+fastcond_mutex_unlock(fastcond_mutex_t *mutex)
+{
+    return NATIVE_MUTEX_UNLOCK(&mutex->mutex);
+}
+#endif /* NATIVE_HAVE_FUTEX */
+
+/* The condition variable works with either kind of mutex.  fm says which one mutex
+ * points to; it is a constant at every call site, so the test folds away.
+ */
+#define COND_MUTEX_LOCK(mutex, fm)                                                                 \
+    ((fm) ? fastcond_mutex_lock((fastcond_mutex_t *) (mutex))                                      \
+          : NATIVE_MUTEX_LOCK((native_mutex_t *) (mutex)))
+#define COND_MUTEX_UNLOCK(mutex, fm)                                                               \
+    ((fm) ? fastcond_mutex_unlock((fastcond_mutex_t *) (mutex))                                    \
+          : NATIVE_MUTEX_UNLOCK((native_mutex_t *) (mutex)))
+
 /*  fastcond_cond_t implementation - Unified strong condition variable
 
     Historical Note:
@@ -403,17 +609,17 @@ static inline int _weak_fini(fastcond_cond_t *cond)
     return SEM_DESTROY(cond->sem);
 }
 
-static inline int _weak_timedwait(fastcond_cond_t *cond, native_mutex_t *restrict mutex,
-                                  const struct timespec *restrict abstime)
+static inline int _weak_timedwait(fastcond_cond_t *cond, void *restrict mutex, int fm,
+                                  const struct timespec *restrict abstime, int mono)
 {
     int err1, err2;
     cond->w_waiting++;
-    err1 = NATIVE_MUTEX_UNLOCK(mutex);
+    err1 = COND_MUTEX_UNLOCK(mutex, fm);
     if (err1)
         return err1;
 
-    err1 = SEM_TIMEDWAIT(cond->sem, abstime);
-    err2 = NATIVE_MUTEX_LOCK(mutex);
+    err1 = SEM_TIMEDWAIT(cond->sem, abstime, mono);
+    err2 = COND_MUTEX_LOCK(mutex, fm);
 
     if (err1)
         /* wakeup did not adjust counter, must do it ourselves */
@@ -482,9 +688,10 @@ fastcond_cond_wait(fastcond_cond_t *restrict cond, native_mutex_t *restrict mute
     return fastcond_cond_timedwait(cond, mutex, 0);
 }
 
-FASTCOND_API(int)
-fastcond_cond_timedwait(fastcond_cond_t *restrict cond, native_mutex_t *restrict mutex,
-                        const struct timespec *restrict abstime)
+/* The strong wait, for either kind of mutex (fm nonzero for fastcond_mutex_t), with abstime
+ * on the wall clock or, with mono set, the monotonic one */
+static inline int _strong_timedwait(fastcond_cond_t *restrict cond, void *restrict mutex, int fm,
+                                    const struct timespec *restrict abstime, int mono)
 {
     int err;
     assert(cond->n_wakeup <= cond->n_waiting);
@@ -496,18 +703,18 @@ fastcond_cond_timedwait(fastcond_cond_t *restrict cond, native_mutex_t *restrict
          * Instead, perform spurious wakeup (allowed by CV protocol) while
          * yielding lock to let signalled threads complete their wakeup.
          */
-        err = NATIVE_MUTEX_UNLOCK(mutex);
+        err = COND_MUTEX_UNLOCK(mutex, fm);
         if (err)
             return err;
         MAYBE_YIELD();
-        return NATIVE_MUTEX_LOCK(mutex);
+        return COND_MUTEX_LOCK(mutex, fm);
     }
 
     /* No pending wakeups - safe to wait using weak primitive.
      * Track at strong layer (n_waiting) separately from weak layer (waiting).
      */
     cond->n_waiting++;
-    err = _weak_timedwait(cond, mutex, abstime);
+    err = _weak_timedwait(cond, mutex, fm, abstime, mono);
     cond->n_waiting--;
 
     /* If we were woken by signal/broadcast, consume the pending wakeup marker */
@@ -517,6 +724,41 @@ fastcond_cond_timedwait(fastcond_cond_t *restrict cond, native_mutex_t *restrict
     return err;
 }
 
+FASTCOND_API(int)
+fastcond_cond_timedwait(fastcond_cond_t *restrict cond, native_mutex_t *restrict mutex,
+                        const struct timespec *restrict abstime)
+{
+    return _strong_timedwait(cond, mutex, 0, abstime, 0);
+}
+
+FASTCOND_API(int)
+fastcond_cond_wait_fm(fastcond_cond_t *restrict cond, fastcond_mutex_t *restrict mutex)
+{
+    TEST_CALLBACK("fastcond_cond_wait_fm");
+    return _strong_timedwait(cond, mutex, 1, 0, 0);
+}
+
+FASTCOND_API(int)
+fastcond_cond_timedwait_fm(fastcond_cond_t *restrict cond, fastcond_mutex_t *restrict mutex,
+                           const struct timespec *restrict abstime)
+{
+    return _strong_timedwait(cond, mutex, 1, abstime, 0);
+}
+
+FASTCOND_API(int)
+fastcond_cond_clockwait(fastcond_cond_t *restrict cond, native_mutex_t *restrict mutex,
+                        const struct timespec *restrict abstime)
+{
+    return _strong_timedwait(cond, mutex, 0, abstime, 1);
+}
+
+FASTCOND_API(int)
+fastcond_cond_clockwait_fm(fastcond_cond_t *restrict cond, fastcond_mutex_t *restrict mutex,
+                           const struct timespec *restrict abstime)
+{
+    return _strong_timedwait(cond, mutex, 1, abstime, 1);
+}
+
 static int _fastcond_cond_signal_n(fastcond_cond_t *cond, int n)
 {
     int err = 0;
@@ -66,6 +66,60 @@
 
 #define FASTCOND_API(v) v
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The fastcond mutex - a lock designed to go with fastcond_cond_t
+ *
+ * native_mutex_t is whatever the platform provides.  fastcond_mutex_t is owned by
+ * the library, so its wake-up behaviour can be tuned together with the condition
+ * variable's.  On Linux it is a futex word with three states (0 free, 1 locked,
+ * 2 locked with possible waiters), so an uncontended lock and unlock are one atomic
+ * operation each and only a contended unlock makes a system call.  Before sleeping,
+ * a contended lock spins for an adaptive number of rounds (a running average of how
+ * long past spins needed, as glibc's PTHREAD_MUTEX_ADAPTIVE_NP), on multi-core
+ * machines only.
+ *
+ * With FASTCOND_MUTEX_HANDOFF, a contended unlock reserves the lock for a thread
+ * already queued on it (state 3) instead of freeing it, so the unlocking thread and
+ * newly arriving ones cannot barge ahead of a waiter that has just been woken.  That
+ * trades throughput for shorter tail latency under contention.
+ *
+ * Elsewhere it wraps native_mutex_t and the flags are ignored.  Not recursive, not
+ * process-shared.  Use it with fastcond_cond_wait_fm() and fastcond_cond_timedwait_fm().
+ */
+#define FASTCOND_MUTEX_HANDOFF 1 /* hand a contended lock to a waiter on unlock */
+
+typedef struct _fastcond_mutex_t {
+#if NATIVE_HAVE_FUTEX
+    volatile int state;   /* 0 free, 1 locked, 2 locked and contended, 3 handed off */
+    volatile int waiters; /* threads in the slow path of fastcond_mutex_lock() */
+    int spins;            /* running average of spin rounds that paid off */
+    int spin_max;         /* spin limit; 0 on a single CPU */
+#else
+    native_mutex_t mutex;
+#endif
+    int flags;
+} fastcond_mutex_t;
+
+/* flags: 0 or FASTCOND_MUTEX_HANDOFF.  Returns 0 or an errno value. */
+FASTCOND_API(int)
+fastcond_mutex_init(fastcond_mutex_t *mutex, int flags);
+
+FASTCOND_API(int)
+fastcond_mutex_fini(fastcond_mutex_t *mutex);
+
+FASTCOND_API(int)
+fastcond_mutex_lock(fastcond_mutex_t *mutex);
+
+/* Returns 0, or EBUSY if the mutex is locked (or handed off to a waiter) */
+FASTCOND_API(int)
+fastcond_mutex_trylock(fastcond_mutex_t *mutex);
+
+FASTCOND_API(int)
+fastcond_mutex_unlock(fastcond_mutex_t *mutex);
+
 /* The strong condition variable - primary implementation with full POSIX semantics
  * This is the main condition variable type with correct wakeup guarantees.
  */
@@ -96,6 +150,25 @@ FASTCOND_API(int)
 fastcond_cond_timedwait(fastcond_cond_t *restrict cond, native_mutex_t *restrict mutex,
                         const struct timespec *restrict abstime);
 
+/* Wait with a fastcond_mutex_t instead of a native_mutex_t */
+FASTCOND_API(int)
+fastcond_cond_wait_fm(fastcond_cond_t *restrict cond, fastcond_mutex_t *restrict mutex);
+
+FASTCOND_API(int)
+fastcond_cond_timedwait_fm(fastcond_cond_t *restrict cond, fastcond_mutex_t *restrict mutex,
+                           const struct timespec *restrict abstime);
+
+/* Timed waits with abstime on the monotonic clock that native_monotonic_ns() reads
+ * (CLOCK_MONOTONIC on POSIX) instead of the wall clock, so setting the system time does
+ * not move the deadline.  Returns 0, ETIMEDOUT or an errno value, as the waits above. */
+FASTCOND_API(int)
+fastcond_cond_clockwait(fastcond_cond_t *restrict cond, native_mutex_t *restrict mutex,
+                        const struct timespec *restrict abstime);
+
+FASTCOND_API(int)
+fastcond_cond_clockwait_fm(fastcond_cond_t *restrict cond, fastcond_mutex_t *restrict mutex,
+                           const struct timespec *restrict abstime);
+
 /* Signal one waiting thread. CRITICAL: The associated mutex MUST be held.
  * Calling without the mutex produces undefined behavior. */
 FASTCOND_API(int)
@@ -192,4 +265,8 @@ fastcond_cond_wait_ms(fastcond_cond_t *restrict cond, native_mutex_t *restrict m
                       DWORD timeout_ms);
 #endif /* FASTCOND_USE_WINDOWS */
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* ! defined _FASTCOND_H_ */
@@ -0,0 +1,631 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#ifndef _FASTCOND_HPP_
+#define _FASTCOND_HPP_
+
+// C++ support: RAII wrappers in the style of the standard library, and a condition variable
+// and a queue that C++20 coroutines can co_await.
+//
+// fastcond::mutex wraps fastcond_mutex_t and is Lockable, for std::unique_lock,
+// std::lock_guard and std::scoped_lock.  fastcond::condition_variable wraps fastcond_cond_t
+// with the interface of std::condition_variable, waiting on a std::unique_lock<fastcond::mutex>.
+// Switching from the standard pair is a matter of the type names, with one difference: as
+// with fastcond_cond_t, notify_one() and notify_all() must be called with the mutex held.
+// Timed waits sleep until a deadline on the monotonic clock, so a steady_clock deadline is
+// never converted to the wall clock, and setting the system time does not move it.
+//
+// A coroutine that awaits fastcond::async_cond does not park a thread.  It links a wait node
+// kept in its own coroutine frame into the condition's waiter list and releases the mutex;
+// a signal that reaches the node posts the coroutine to the executor it named, where it
+// takes the mutex again and carries on.  Thousands of coroutines can wait this way on a
+// handful of executor threads.
+//
+// Threads can wait on the same condition and block as on a fastcond_cond_t.  Blocked threads
+// and coroutines share one waiter list, oldest first, and a signal goes to its head of either
+// kind, so the two mix with the strong semantics of fastcond_cond_t: a signal or broadcast
+// wakes only waiters already waiting when it is sent, and a waiter arriving while wakeups
+// are pending cannot take one.  Blocked threads sleep on a fastcond_cond_t, whose n_waiting
+// and n_wakeup counters cover them exactly as before.
+//
+// As with fastcond_cond_t, the mutex must be held to wait, signal and broadcast.
+//
+// fastcond::async_queue<T> is an unbounded MPMC queue on an async_cond, with a blocking
+// pop() for threads and a co_await-able async_pop() for coroutines.
+//
+// The executor is anything derived from fastcond::executor.  fastcond::thread_executor runs
+// coroutines on a fixed set of threads.  fastcond::task<T> is a lazily started coroutine to
+// co_await, and fastcond::detached a fire-and-forget one.
+
+#include "native_primitives.h"
+
+// The C API is declared with C99 restrict, which C++ spells __restrict
+#define restrict __restrict
+#include "fastcond.h"
+#undef restrict
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fastcond {
+
+// A non-recursive mutex.  flags: 0 or FASTCOND_MUTEX_HANDOFF, see fastcond_mutex_t.
+class mutex {
+  public:
+    using native_handle_type = fastcond_mutex_t *;
+
+    explicit mutex(int flags = 0)
+    {
+        int err = fastcond_mutex_init(&mutex_, flags);
+
+        if (err)
+            throw std::system_error(err, std::generic_category(), "fastcond_mutex_init");
+    }
+    ~mutex() { fastcond_mutex_fini(&mutex_); }
+    mutex(const mutex &) = delete;
+    mutex &operator=(const mutex &) = delete;
+
+    void lock()
+    {
+        int err = fastcond_mutex_lock(&mutex_);
+
+        if (err)
+            throw std::system_error(err, std::generic_category(), "fastcond_mutex_lock");
+    }
+    bool try_lock() noexcept { return fastcond_mutex_trylock(&mutex_) == 0; }
+    void unlock() noexcept { fastcond_mutex_unlock(&mutex_); }
+    native_handle_type native_handle() noexcept { return &mutex_; }
+
+  private:
+    fastcond_mutex_t mutex_;
+};
+
+// std::condition_variable for fastcond::mutex.  The mutex must be held to notify.
+//
+// The predicate overloads work out their deadline once and loop on the C wait directly,
+// where the standard ones go back through wait_until(), reading the clocks again, after
+// every spurious return.  Errors from the C wait count as spurious returns.
+class condition_variable {
+  public:
+    using native_handle_type = fastcond_cond_t *;
+
+    condition_variable()
+    {
+        int err = fastcond_cond_init(&cond_, nullptr);
+
+        if (err)
+            throw std::system_error(err, std::generic_category(), "fastcond_cond_init");
+    }
+    ~condition_variable() { fastcond_cond_fini(&cond_); }
+    condition_variable(const condition_variable &) = delete;
+    condition_variable &operator=(const condition_variable &) = delete;
+
+    void notify_one() noexcept { fastcond_cond_signal(&cond_); }
+    void notify_all() noexcept { fastcond_cond_broadcast(&cond_); }
+
+    void wait(std::unique_lock<mutex> &lock)
+    {
+        fastcond_cond_wait_fm(&cond_, lock.mutex()->native_handle());
+    }
+    template <class Predicate> void wait(std::unique_lock<mutex> &lock, Predicate pred)
+    {
+        fastcond_mutex_t *m = lock.mutex()->native_handle();
+
+        while (!pred())
+            fastcond_cond_wait_fm(&cond_, m);
+    }
+
+    template <class Clock, class Duration>
+    std::cv_status wait_until(std::unique_lock<mutex> &lock,
+                              const std::chrono::time_point<Clock, Duration> &t)
+    {
+        return timed_wait(lock, deadline_at(t));
+    }
+    template <class Clock, class Duration, class Predicate>
+    bool wait_until(std::unique_lock<mutex> &lock,
+                    const std::chrono::time_point<Clock, Duration> &t, Predicate pred)
+    {
+        return timed_wait(lock, deadline_at(t), pred);
+    }
+
+    template <class Rep, class Period>
+    std::cv_status wait_for(std::unique_lock<mutex> &lock,
+                            const std::chrono::duration<Rep, Period> &d)
+    {
+        return timed_wait(lock, deadline_after(d));
+    }
+    template <class Rep, class Period, class Predicate>
+    bool wait_for(std::unique_lock<mutex> &lock, const std::chrono::duration<Rep, Period> &d,
+                  Predicate pred)
+    {
+        return timed_wait(lock, deadline_after(d), pred);
+    }
+
+    native_handle_type native_handle() noexcept { return &cond_; }
+
+  private:
+    // Nanoseconds in d, clamped to [0, 100 years] so the sums below cannot overflow
+    template <class Rep, class Period>
+    static long long clamp_ns(const std::chrono::duration<Rep, Period> &d)
+    {
+        if (d <= d.zero())
+            return 0;
+        if (d >= std::chrono::hours(24 * 365 * 100))
+            return 3153600000000000000LL;
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    }
+
+    static struct timespec to_timespec(long long ns) noexcept
+    {
+        struct timespec ts;
+
+        ts.tv_sec = (time_t) (ns / 1000000000LL);
+        ts.tv_nsec = (long) (ns % 1000000000LL);
+        return ts;
+    }
+
+    // A monotonic deadline d from now
+    template <class Rep, class Period>
+    static struct timespec deadline_after(const std::chrono::duration<Rep, Period> &d)
+    {
+        return to_timespec(native_monotonic_ns() + clamp_ns(d));
+    }
+
+    // The monotonic deadline for t.  On Linux steady_clock is CLOCK_MONOTONIC itself; other
+    // clocks, and steady_clock elsewhere, go by the time left until t.
+    template <class Clock, class Duration>
+    static struct timespec deadline_at(const std::chrono::time_point<Clock, Duration> &t)
+    {
+#if defined(__linux__)
+        if constexpr (std::is_same_v<Clock, std::chrono::steady_clock>)
+            return to_timespec(clamp_ns(t.time_since_epoch()));
+#endif
+        return deadline_after(t - Clock::now());
+    }
+
+    std::cv_status timed_wait(std::unique_lock<mutex> &lock, const struct timespec &abstime)
+    {
+        int err = fastcond_cond_clockwait_fm(&cond_, lock.mutex()->native_handle(), &abstime);
+
+        return err == ETIMEDOUT ? std::cv_status::timeout : std::cv_status::no_timeout;
+    }
+    template <class Predicate>
+    bool timed_wait(std::unique_lock<mutex> &lock, const struct timespec &abstime,
+                    Predicate &pred)
+    {
+        fastcond_mutex_t *m = lock.mutex()->native_handle();
+
+        while (!pred())
+            if (fastcond_cond_clockwait_fm(&cond_, m, &abstime) == ETIMEDOUT)
+                return pred();
+        return true;
+    }
+
+    fastcond_cond_t cond_;
+};
+
+// Where a resumed coroutine runs.  post() may be called with a mutex held, so it must not
+// block for long, and must not resume the coroutine before it returns.
+class executor {
+  public:
+    virtual ~executor() = default;
+    virtual void post(std::coroutine_handle<> handle) = 0;
+};
+
+// Runs posted coroutines on n_threads threads, oldest first.  The destructor runs whatever
+// has been posted, then joins the threads.
+class thread_executor final : public executor {
+  public:
+    explicit thread_executor(int n_threads = 1)
+    {
+        int err = fastcond_cond_init(&cond_, nullptr);
+
+        if (err)
+            throw std::system_error(err, std::generic_category(), "fastcond_cond_init");
+        NATIVE_MUTEX_INIT(&mutex_);
+        for (int i = 0; i < n_threads; i++)
+            threads_.emplace_back([this] { run(); });
+    }
+
+    ~thread_executor() override
+    {
+        NATIVE_MUTEX_LOCK(&mutex_);
+        stopping_ = true;
+        if (n_idle_)
+            fastcond_cond_broadcast(&cond_);
+        NATIVE_MUTEX_UNLOCK(&mutex_);
+        for (auto &thread : threads_)
+            thread.join();
+        fastcond_cond_fini(&cond_);
+        NATIVE_MUTEX_DESTROY(&mutex_);
+    }
+
+    thread_executor(const thread_executor &) = delete;
+    thread_executor &operator=(const thread_executor &) = delete;
+
+    void post(std::coroutine_handle<> handle) override
+    {
+        NATIVE_MUTEX_LOCK(&mutex_);
+        ready_.push_back(handle);
+        if (n_idle_)
+            fastcond_cond_signal(&cond_);
+        NATIVE_MUTEX_UNLOCK(&mutex_);
+    }
+
+  private:
+    void run()
+    {
+        NATIVE_MUTEX_LOCK(&mutex_);
+        for (;;) {
+            while (ready_.empty() && !stopping_) {
+                n_idle_++;
+                fastcond_cond_wait(&cond_, &mutex_);
+                n_idle_--;
+            }
+            if (ready_.empty())
+                break;
+            std::coroutine_handle<> handle = ready_.front();
+            ready_.pop_front();
+            NATIVE_MUTEX_UNLOCK(&mutex_);
+            handle.resume();
+            NATIVE_MUTEX_LOCK(&mutex_);
+        }
+        NATIVE_MUTEX_UNLOCK(&mutex_);
+    }
+
+    native_mutex_t mutex_;
+    fastcond_cond_t cond_;
+    std::deque<std::coroutine_handle<>> ready_;
+    int n_idle_ = 0;
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+};
+
+// co_await resume_on(ex) moves the coroutine onto ex
+class resume_on {
+  public:
+    explicit resume_on(executor &ex) noexcept : ex_(ex) {}
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) { ex_.post(handle); }
+    void await_resume() const noexcept {}
+
+  private:
+    executor &ex_;
+};
+
+// A coroutine that starts running when called and destroys itself when done.  An exception
+// escaping it terminates the program.
+struct detached {
+    struct promise_type {
+        detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+// A coroutine that starts when awaited and resumes its awaiter when done
+template <class T> class task {
+  public:
+    struct promise_type {
+        std::optional<T> value;
+        std::exception_ptr error;
+        std::coroutine_handle<> continuation;
+
+        task get_return_object() noexcept
+        {
+            return task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        auto final_suspend() noexcept
+        {
+            struct final_awaiter {
+                bool await_ready() const noexcept { return false; }
+                std::coroutine_handle<>
+                await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+                {
+                    return handle.promise().continuation;
+                }
+                void await_resume() const noexcept {}
+            };
+            return final_awaiter{};
+        }
+        template <class U> void return_value(U &&v) { value.emplace(std::forward<U>(v)); }
+        void unhandled_exception() noexcept { error = std::current_exception(); }
+    };
+
+    task(task &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    task(const task &) = delete;
+    task &operator=(const task &) = delete;
+    ~task()
+    {
+        if (handle_)
+            handle_.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept
+    {
+        handle_.promise().continuation = awaiter;
+        return handle_;
+    }
+    T await_resume()
+    {
+        if (handle_.promise().error)
+            std::rethrow_exception(handle_.promise().error);
+        return std::move(*handle_.promise().value);
+    }
+
+  private:
+    explicit task(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+    std::coroutine_handle<promise_type> handle_;
+};
+
+// A condition variable for blocked threads and suspended coroutines together
+class async_cond {
+    // A waiter: a coroutine (handle set) or a blocked thread.  Each lives in its waiter's
+    // coroutine frame or stack.
+    struct node {
+        node *prev = nullptr;
+        node *next = nullptr;
+        std::coroutine_handle<> handle;
+        executor *ex = nullptr;
+        bool signalled = false; // a blocked thread, on signalled_
+    };
+
+    struct node_list {
+        node *head = nullptr;
+        node *tail = nullptr;
+
+        void push_back(node *n) noexcept
+        {
+            n->next = nullptr;
+            n->prev = tail;
+            if (tail)
+                tail->next = n;
+            else
+                head = n;
+            tail = n;
+        }
+        void remove(node *n) noexcept
+        {
+            if (n->prev)
+                n->prev->next = n->next;
+            else
+                head = n->next;
+            if (n->next)
+                n->next->prev = n->prev;
+            else
+                tail = n->prev;
+        }
+        // Put n in the place of old, which leaves the list
+        void replace(node *old, node *n) noexcept
+        {
+            n->prev = old->prev;
+            n->next = old->next;
+            if (n->prev)
+                n->prev->next = n;
+            else
+                head = n;
+            if (n->next)
+                n->next->prev = n;
+            else
+                tail = n;
+        }
+    };
+
+  public:
+    class awaiter {
+      public:
+        awaiter(async_cond &cond, native_mutex_t &mutex, executor &ex) noexcept
+            : cond_(cond), mutex_(mutex)
+        {
+            node_.ex = &ex;
+        }
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) noexcept
+        {
+            native_mutex_t *mutex = &mutex_;
+
+            node_.handle = handle;
+            cond_.waiters_.push_back(&node_);
+            // Once the mutex is released a signal may resume us elsewhere: touch nothing here
+            NATIVE_MUTEX_UNLOCK(mutex);
+        }
+        void await_resume() noexcept { NATIVE_MUTEX_LOCK(&mutex_); }
+
+      private:
+        async_cond &cond_;
+        native_mutex_t &mutex_;
+        node node_;
+    };
+
+    async_cond()
+    {
+        int err = fastcond_cond_init(&cond_, nullptr);
+
+        if (err)
+            throw std::system_error(err, std::generic_category(), "fastcond_cond_init");
+    }
+    ~async_cond() { fastcond_cond_fini(&cond_); }
+    async_cond(const async_cond &) = delete;
+    async_cond &operator=(const async_cond &) = delete;
+
+    // co_await cond.async_wait(mutex, ex): release mutex until signalled, then resume on ex
+    // holding it again.  Like any condition wait, re-check the predicate afterwards.
+    awaiter async_wait(native_mutex_t &mutex, executor &ex) noexcept
+    {
+        return awaiter(*this, mutex, ex);
+    }
+
+    // Block the calling thread
+    void wait(native_mutex_t &mutex) { blocking_wait(mutex, nullptr); }
+    // Returns 0, or ETIMEDOUT at abstime (CLOCK_REALTIME)
+    int wait_until(native_mutex_t &mutex, const struct timespec &abstime)
+    {
+        return blocking_wait(mutex, &abstime);
+    }
+
+    void signal()
+    {
+        node *n = waiters_.head;
+
+        if (!n)
+            return;
+        waiters_.remove(n);
+        if (wake(n))
+            fastcond_cond_signal(&cond_);
+    }
+
+    void broadcast()
+    {
+        bool blocked = false;
+
+        while (node *n = waiters_.head) {
+            waiters_.remove(n);
+            blocked |= wake(n);
+        }
+        if (blocked)
+            fastcond_cond_broadcast(&cond_);
+    }
+
+  private:
+    // Post a coroutine, or mark a blocked thread signalled.  Returns true for a thread, which
+    // the caller must wake through cond_.
+    bool wake(node *n)
+    {
+        if (n->handle) {
+            std::coroutine_handle<> handle = n->handle;
+
+            n->ex->post(handle);
+            return false;
+        }
+        n->signalled = true;
+        signalled_.push_back(n);
+        return true;
+    }
+
+    int blocking_wait(native_mutex_t &mutex, const struct timespec *abstime)
+    {
+        node self;
+        int err;
+
+        if (signalled_.head) {
+            // Wakeups are pending for threads already waiting; like fastcond_cond_t, return
+            // spuriously rather than take one of theirs
+            NATIVE_MUTEX_UNLOCK(&mutex);
+            NATIVE_THREAD_YIELD();
+            NATIVE_MUTEX_LOCK(&mutex);
+            return 0;
+        }
+        waiters_.push_back(&self);
+        if (abstime)
+            err = fastcond_cond_timedwait(&cond_, &mutex, abstime);
+        else
+            err = fastcond_cond_wait(&cond_, &mutex);
+
+        // cond_ wakes whichever blocked thread it likes.  There is one signalled node per
+        // wakeup cond_ owes, and it counts each return as one paid, so a thread that returns
+        // while signals are pending takes one: its own node, or another's, whose thread then
+        // takes this one's place in the waiter list.
+        if (self.signalled) {
+            signalled_.remove(&self);
+            return 0;
+        }
+        if (node *other = signalled_.head) {
+            signalled_.remove(other);
+            other->signalled = false;
+            waiters_.replace(&self, other);
+            return 0;
+        }
+        waiters_.remove(&self);
+        return err;
+    }
+
+    fastcond_cond_t cond_; // blocked threads sleep here
+    node_list waiters_;    // coroutines and blocked threads, oldest first
+    node_list signalled_;  // blocked threads signalled but not yet returned
+};
+
+// An unbounded multi-producer, multi-consumer FIFO for threads and coroutines
+template <class T> class async_queue {
+  public:
+    async_queue() { NATIVE_MUTEX_INIT(&mutex_); }
+    ~async_queue() { NATIVE_MUTEX_DESTROY(&mutex_); }
+    async_queue(const async_queue &) = delete;
+    async_queue &operator=(const async_queue &) = delete;
+
+    // Returns false once the queue is closed
+    bool push(T item)
+    {
+        NATIVE_MUTEX_LOCK(&mutex_);
+        if (closed_) {
+            NATIVE_MUTEX_UNLOCK(&mutex_);
+            return false;
+        }
+        items_.push_back(std::move(item));
+        not_empty_.signal();
+        NATIVE_MUTEX_UNLOCK(&mutex_);
+        return true;
+    }
+
+    // Block for an item.  Returns std::nullopt once the queue is closed and empty.
+    std::optional<T> pop()
+    {
+        NATIVE_MUTEX_LOCK(&mutex_);
+        while (items_.empty() && !closed_)
+            not_empty_.wait(mutex_);
+        std::optional<T> item = take();
+        NATIVE_MUTEX_UNLOCK(&mutex_);
+        return item;
+    }
+
+    // co_await queue.async_pop(ex): as pop(), suspending instead of blocking, resuming on ex
+    task<std::optional<T>> async_pop(executor &ex)
+    {
+        NATIVE_MUTEX_LOCK(&mutex_);
+        while (items_.empty() && !closed_)
+            co_await not_empty_.async_wait(mutex_, ex);
+        std::optional<T> item = take();
+        NATIVE_MUTEX_UNLOCK(&mutex_);
+        co_return item;
+    }
+
+    // Pushes fail from now on; pops drain what is left, then return std::nullopt
+    void close()
+    {
+        NATIVE_MUTEX_LOCK(&mutex_);
+        closed_ = true;
+        not_empty_.broadcast();
+        NATIVE_MUTEX_UNLOCK(&mutex_);
+    }
+
+  private:
+    std::optional<T> take()
+    {
+        if (items_.empty())
+            return std::nullopt;
+        std::optional<T> item(std::move(items_.front()));
+        items_.pop_front();
+        return item;
+    }
+
+    native_mutex_t mutex_;
+    async_cond not_empty_;
+    std::deque<T> items_;
+    bool closed_ = false;
+};
+
+} // namespace fastcond
+
+#endif /* ! defined _FASTCOND_HPP_ */
@@ -0,0 +1,328 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#include "fastcond_chan.h"
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// One per blocked send, receive or select, shared by its wait nodes
+struct _fastcond_chan_parker {
+    volatile int selected; // index of the case completed for us; -1 until one is
+    int done;              // under mutex: the completing thread is finished with us
+    native_mutex_t mutex;
+    fastcond_cond_t cond;
+};
+
+// One per case of a blocked select, queued on the case's channel
+struct _fastcond_chan_waiter {
+    struct _fastcond_chan_waiter *next;
+    struct _fastcond_chan_waiter *prev;
+    struct _fastcond_chan_parker *parker;
+    struct fastcond_chan_case *c;
+    int index;  // of c among the select's cases
+    int queued; // on the channel's queue.  Under the channel mutex.
+};
+
+static void _waitq_push(struct fastcond_chan_waitq *q, struct _fastcond_chan_waiter *w)
+{
+    w->next = NULL;
+    w->prev = q->tail;
+    if (q->tail)
+        q->tail->next = w;
+    else
+        q->head = w;
+    q->tail = w;
+    w->queued = 1;
+}
+
+static void _waitq_remove(struct fastcond_chan_waitq *q, struct _fastcond_chan_waiter *w)
+{
+    if (w->prev)
+        w->prev->next = w->next;
+    else
+        q->head = w->next;
+    if (w->next)
+        w->next->prev = w->prev;
+    else
+        q->tail = w->prev;
+    w->queued = 0;
+}
+
+// Dequeue the oldest waiter we can claim.  Nodes of selects already completed through another
+// channel are dropped on the way.  Caller holds the channel mutex.
+static struct _fastcond_chan_waiter *_waitq_claim(struct fastcond_chan_waitq *q)
+{
+    struct _fastcond_chan_waiter *w;
+
+    while ((w = q->head) != NULL) {
+        _waitq_remove(q, w);
+        if (native_atomic_cas(&w->parker->selected, -1, w->index))
+            return w;
+    }
+    return NULL;
+}
+
+// Wake a claimed waiter.  Its nodes and parker are on its stack: once the parker's mutex is
+// released here they may be gone.
+static void _chan_wake(struct _fastcond_chan_parker *parker)
+{
+    NATIVE_MUTEX_LOCK(&parker->mutex);
+    parker->done = 1;
+    fastcond_cond_signal(&parker->cond);
+    NATIVE_MUTEX_UNLOCK(&parker->mutex);
+}
+
+static void _chan_put(fastcond_chan_t *chan, void *value)
+{
+    int tail = chan->head + chan->count;
+
+    if (tail >= chan->capacity)
+        tail -= chan->capacity;
+    chan->items[tail] = value;
+    chan->count++;
+}
+
+static void *_chan_take(fastcond_chan_t *chan)
+{
+    void *value = chan->items[chan->head];
+
+    if (++chan->head == chan->capacity)
+        chan->head = 0;
+    chan->count--;
+    return value;
+}
+
+// Complete case c if it needs no wait.  Returns 1 if it was completed, with *wake set to a
+// claimed waiter to wake once the channel is unlocked, or to NULL.
+// Caller holds c->chan->mutex.
+static int _chan_try(struct fastcond_chan_case *c, struct _fastcond_chan_waiter **wake)
+{
+    fastcond_chan_t *chan = c->chan;
+    struct _fastcond_chan_waiter *w;
+
+    *wake = NULL;
+    c->err = 0;
+    if (c->op == FASTCOND_CHAN_SEND) {
+        if (chan->closed) {
+            c->err = EPIPE;
+        } else if ((w = _waitq_claim(&chan->recvq)) != NULL) {
+            // Receivers park only on an empty buffer: hand the value over directly
+            w->c->value = c->value;
+            w->c->err = 0;
+            *wake = w;
+        } else if (chan->count < chan->capacity) {
+            _chan_put(chan, c->value);
+        } else {
+            return 0;
+        }
+        return 1;
+    }
+
+    if ((w = _waitq_claim(&chan->sendq)) != NULL) {
+        // Senders park only on a full buffer: take the oldest value and append theirs
+        if (chan->count > 0) {
+            c->value = _chan_take(chan);
+            _chan_put(chan, w->c->value);
+        } else {
+            c->value = w->c->value;
+        }
+        w->c->err = 0;
+        *wake = w;
+    } else if (chan->count > 0) {
+        c->value = _chan_take(chan); // a closed channel is drained first
+    } else if (chan->closed) {
+        c->value = NULL;
+        c->err = EPIPE;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+// Lock the distinct channels of the cases in address order.  Returns their number, with the
+// channels in chans[].
+static int _chan_lock_all(struct fastcond_chan_case *cases, int n, fastcond_chan_t **chans)
+{
+    int i, j, m = 0;
+
+    for (i = 0; i < n; i++) {
+        fastcond_chan_t *chan = cases[i].chan;
+
+        for (j = m; j > 0 && (uintptr_t) chans[j - 1] > (uintptr_t) chan; j--)
+            ;
+        if (j > 0 && chans[j - 1] == chan)
+            continue;
+        memmove(&chans[j + 1], &chans[j], sizeof(chans[0]) * (size_t) (m - j));
+        chans[j] = chan;
+        m++;
+    }
+    for (i = 0; i < m; i++)
+        NATIVE_MUTEX_LOCK(&chans[i]->mutex);
+    return m;
+}
+
+static void _chan_unlock_all(fastcond_chan_t **chans, int m)
+{
+    while (m-- > 0)
+        NATIVE_MUTEX_UNLOCK(&chans[m]->mutex);
+}
+
+int fastcond_chan_init(fastcond_chan_t *chan, int capacity)
+{
+    if (capacity < 0)
+        return EINVAL;
+    chan->items = NULL;
+    if (capacity > 0) {
+        chan->items = malloc(sizeof(void *) * (size_t) capacity);
+        if (!chan->items)
+            return ENOMEM;
+    }
+    NATIVE_MUTEX_INIT(&chan->mutex);
+    chan->capacity = capacity;
+    chan->head = 0;
+    chan->count = 0;
+    chan->closed = 0;
+    chan->recvq.head = chan->recvq.tail = NULL;
+    chan->sendq.head = chan->sendq.tail = NULL;
+    return 0;
+}
+
+int fastcond_chan_fini(fastcond_chan_t *chan)
+{
+    NATIVE_MUTEX_DESTROY(&chan->mutex);
+    free(chan->items);
+    chan->items = NULL;
+    return 0;
+}
+
+int fastcond_chan_select(struct fastcond_chan_case *cases, int n, int block)
+{
+    static volatile int rotor;
+    fastcond_chan_t *chans[FASTCOND_CHAN_SELECT_MAX];
+    struct _fastcond_chan_waiter nodes[FASTCOND_CHAN_SELECT_MAX];
+    struct _fastcond_chan_parker parker;
+    struct _fastcond_chan_waiter *wake;
+    int i, k, m, start, err;
+
+    if (n < 1 || n > FASTCOND_CHAN_SELECT_MAX)
+        return -1;
+    start = n > 1 ? (int) ((unsigned) native_atomic_add(&rotor, 1) % (unsigned) n) : 0;
+    m = _chan_lock_all(cases, n, chans);
+    for (i = 0; i < n; i++) {
+        k = start + i < n ? start + i : start + i - n;
+        if (_chan_try(&cases[k], &wake)) {
+            _chan_unlock_all(chans, m);
+            if (wake)
+                _chan_wake(wake->parker);
+            return k;
+        }
+    }
+    if (!block) {
+        _chan_unlock_all(chans, m);
+        return -1;
+    }
+
+    err = fastcond_cond_init(&parker.cond, NULL);
+    if (err) {
+        _chan_unlock_all(chans, m);
+        for (i = 0; i < n; i++)
+            cases[i].err = err;
+        return -1;
+    }
+    NATIVE_MUTEX_INIT(&parker.mutex);
+    parker.selected = -1;
+    parker.done = 0;
+    for (i = 0; i < n; i++) {
+        fastcond_chan_t *chan = cases[i].chan;
+
+        nodes[i].parker = &parker;
+        nodes[i].c = &cases[i];
+        nodes[i].index = i;
+        _waitq_push(cases[i].op == FASTCOND_CHAN_SEND ? &chan->sendq : &chan->recvq, &nodes[i]);
+    }
+    _chan_unlock_all(chans, m);
+
+    NATIVE_MUTEX_LOCK(&parker.mutex);
+    while (!parker.done)
+        fastcond_cond_wait(&parker.cond, &parker.mutex);
+    NATIVE_MUTEX_UNLOCK(&parker.mutex);
+
+    // The completing thread dequeued its node; take ours off the other channels
+    k = parker.selected;
+    for (i = 0; i < n; i++) {
+        fastcond_chan_t *chan = cases[i].chan;
+
+        if (i == k)
+            continue;
+        NATIVE_MUTEX_LOCK(&chan->mutex);
+        if (nodes[i].queued)
+            _waitq_remove(cases[i].op == FASTCOND_CHAN_SEND ? &chan->sendq : &chan->recvq,
+                          &nodes[i]);
+        NATIVE_MUTEX_UNLOCK(&chan->mutex);
+    }
+    fastcond_cond_fini(&parker.cond);
+    NATIVE_MUTEX_DESTROY(&parker.mutex);
+    return k;
+}
+
+int fastcond_chan_send(fastcond_chan_t *chan, void *value)
+{
+    struct fastcond_chan_case c = {chan, FASTCOND_CHAN_SEND, value, 0};
+
+    fastcond_chan_select(&c, 1, 1);
+    return c.err;
+}
+
+int fastcond_chan_trysend(fastcond_chan_t *chan, void *value)
+{
+    struct fastcond_chan_case c = {chan, FASTCOND_CHAN_SEND, value, 0};
+
+    return fastcond_chan_select(&c, 1, 0) < 0 ? EAGAIN : c.err;
+}
+
+int fastcond_chan_recv(fastcond_chan_t *chan, void **value)
+{
+    struct fastcond_chan_case c = {chan, FASTCOND_CHAN_RECV, NULL, 0};
+
+    fastcond_chan_select(&c, 1, 1);
+    *value = c.value;
+    return c.err;
+}
+
+int fastcond_chan_tryrecv(fastcond_chan_t *chan, void **value)
+{
+    struct fastcond_chan_case c = {chan, FASTCOND_CHAN_RECV, NULL, 0};
+
+    if (fastcond_chan_select(&c, 1, 0) < 0)
+        return EAGAIN;
+    *value = c.value;
+    return c.err;
+}
+
+int fastcond_chan_close(fastcond_chan_t *chan)
+{
+    struct _fastcond_chan_waiter *woken = NULL, *w;
+
+    NATIVE_MUTEX_LOCK(&chan->mutex);
+    chan->closed = 1;
+    while ((w = _waitq_claim(&chan->recvq)) != NULL) {
+        w->c->value = NULL;
+        w->c->err = EPIPE;
+        w->next = woken;
+        woken = w;
+    }
+    while ((w = _waitq_claim(&chan->sendq)) != NULL) {
+        w->c->err = EPIPE;
+        w->next = woken;
+        woken = w;
+    }
+    NATIVE_MUTEX_UNLOCK(&chan->mutex);
+
+    while (woken) {
+        w = woken;
+        woken = w->next; // before the wake, after which the node may be gone
+        _chan_wake(w->parker);
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#ifndef _FASTCOND_CHAN_H_
+#define _FASTCOND_CHAN_H_
+
+#include "fastcond.h"
+#include "native_primitives.h"
+
+// Go-style channels of void pointers, and select over several of them.
+//
+// A channel has a capacity: 0 for an unbuffered channel, where each send meets a receive,
+// or N for a ring buffer of N values.  A thread that cannot complete its operation parks on
+// a wait node of its own, queued on the channel, and the thread that completes it copies the
+// value straight into or out of that node and wakes it.  An unbuffered send to a parked
+// receiver thus costs the sender no wait of its own, and the receiver one wakeup, with no
+// buffer in between.
+//
+// fastcond_chan_select() waits on any number of send and receive cases at once: it queues a
+// node on every channel involved, and the first thread to claim one of them completes that
+// case; the nodes on the other channels are skipped by anyone who finds them, and removed by
+// the selecting thread once it wakes.  Channels are locked in address order, so selects over
+// overlapping channel sets cannot deadlock.
+//
+// After fastcond_chan_close() sends fail with EPIPE, receives drain what is buffered and
+// then fail with EPIPE, and parked threads are woken with EPIPE.
+
+#define FASTCOND_CHAN_SEND 0
+#define FASTCOND_CHAN_RECV 1
+
+// Cases per fastcond_chan_select() call
+#define FASTCOND_CHAN_SELECT_MAX 64
+
+struct _fastcond_chan_waiter;
+
+struct fastcond_chan_waitq {
+    struct _fastcond_chan_waiter *head;
+    struct _fastcond_chan_waiter *tail;
+};
+
+typedef struct _fastcond_chan_t {
+    native_mutex_t mutex;
+    void **items; // ring buffer; NULL when unbuffered
+    int capacity;
+    int head;  // index of the oldest value
+    int count; // values in the buffer
+    int closed;
+    struct fastcond_chan_waitq recvq; // parked receivers, oldest first
+    struct fastcond_chan_waitq sendq; // parked senders, oldest first
+} fastcond_chan_t;
+
+struct fastcond_chan_case {
+    fastcond_chan_t *chan;
+    int op;      // FASTCOND_CHAN_SEND or FASTCOND_CHAN_RECV
+    void *value; // the value to send, or the value received
+    int err;     // for the completed case: 0, or EPIPE if the channel was closed
+};
+
+// Returns 0, EINVAL for a negative capacity, or ENOMEM
+int fastcond_chan_init(fastcond_chan_t *chan, int capacity);
+
+// No thread may be using the channel.  Buffered values are dropped.
+int fastcond_chan_fini(fastcond_chan_t *chan);
+
+// Returns 0, or EPIPE once the channel is closed
+int fastcond_chan_send(fastcond_chan_t *chan, void *value);
+// Returns 0, EAGAIN if no receiver is parked and the buffer is full, or EPIPE
+int fastcond_chan_trysend(fastcond_chan_t *chan, void *value);
+
+// Returns 0, or EPIPE once the channel is closed and drained
+int fastcond_chan_recv(fastcond_chan_t *chan, void **value);
+// Returns 0, EAGAIN if no sender is parked and the buffer is empty, or EPIPE
+int fastcond_chan_tryrecv(fastcond_chan_t *chan, void **value);
+
+int fastcond_chan_close(fastcond_chan_t *chan);
+
+// Complete one of n cases, 1 <= n <= FASTCOND_CHAN_SELECT_MAX, and return its index.  Of
+// several ready cases, one is picked starting from a rotating position.  With block 0, returns
+// -1 if no case is ready; otherwise waits for one.  A case on a closed channel is ready, and
+// completes with err EPIPE.  Also returns -1 if n is out of range, or if the wait could not
+// be set up, with that error in the err of every case.
+int fastcond_chan_select(struct fastcond_chan_case *cases, int n, int block);
+
+#endif /* ! defined _FASTCOND_CHAN_H_ */
@@ -0,0 +1,416 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#include "fastcond_delay.h"
+#include <errno.h>
+#include <limits.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#define SLOT_BITS 6
+#define SLOT_MASK (FASTCOND_DELAY_SLOTS - 1)
+#define WHEEL_SPAN (1LL << (SLOT_BITS * FASTCOND_DELAY_LEVELS)) // ticks
+
+// item->where outside the wheel
+#define WHERE_NOWHERE -1
+#define WHERE_DUE (FASTCOND_DELAY_LEVELS * FASTCOND_DELAY_SLOTS)
+
+static int _ctz64(unsigned long long x)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(_WIN64)
+    unsigned long i;
+    _BitScanForward64(&i, x);
+    return (int) i;
+#else
+    int i = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+static long long _delay_clock_us(void)
+{
+    struct timespec ts;
+
+    native_deadline_us(&ts, 0);
+    return (long long) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// The tick at or after abstime
+static long long _delay_tick(fastcond_delay_queue_t *queue, const struct timespec *abstime)
+{
+    long long us = (long long) abstime->tv_sec * 1000000 + (abstime->tv_nsec + 999) / 1000;
+
+    us -= queue->base_us;
+    return us <= 0 ? 0 : (us + queue->tick_us - 1) / queue->tick_us;
+}
+
+static void _delay_timespec(fastcond_delay_queue_t *queue, long long tick, struct timespec *ts)
+{
+    long long us = queue->base_us + tick * queue->tick_us;
+
+    ts->tv_sec = (time_t) (us / 1000000);
+    ts->tv_nsec = (long) (us % 1000000) * 1000;
+}
+
+static void _due_append(fastcond_delay_queue_t *queue, fastcond_delay_item_t *item)
+{
+    item->next = NULL;
+    item->prev = queue->due_tail;
+    if (queue->due_tail)
+        queue->due_tail->next = item;
+    else
+        queue->due_head = item;
+    queue->due_tail = item;
+    item->where = WHERE_DUE;
+}
+
+// Put item in the wheel slot for its deadline, or on the due list if that has passed
+static void _delay_place(fastcond_delay_queue_t *queue, fastcond_delay_item_t *item)
+{
+    fastcond_delay_item_t **head;
+    long long delta = item->tick - queue->now;
+    long long tick = item->tick;
+    int level = 0, slot;
+
+    if (delta <= 0) {
+        _due_append(queue, item);
+        return;
+    }
+    if (delta >= WHEEL_SPAN) {
+        // Beyond the top level: park in its furthest slot, to be placed again from there
+        delta = WHEEL_SPAN - 1;
+        tick = queue->now + delta;
+    }
+    while (delta >> (SLOT_BITS * (level + 1)))
+        level++;
+    slot = (int) (tick >> (SLOT_BITS * level)) & SLOT_MASK;
+    head = &queue->slots[level][slot];
+    item->prev = NULL;
+    item->next = *head;
+    if (*head)
+        (*head)->prev = item;
+    *head = item;
+    queue->occupied[level] |= 1ULL << slot;
+    item->where = level * FASTCOND_DELAY_SLOTS + slot;
+}
+
+static void _delay_remove(fastcond_delay_queue_t *queue, fastcond_delay_item_t *item)
+{
+    if (item->where == WHERE_DUE) {
+        if (item->prev)
+            item->prev->next = item->next;
+        else
+            queue->due_head = item->next;
+        if (item->next)
+            item->next->prev = item->prev;
+        else
+            queue->due_tail = item->prev;
+    } else {
+        int level = item->where / FASTCOND_DELAY_SLOTS;
+        int slot = item->where % FASTCOND_DELAY_SLOTS;
+
+        if (item->prev)
+            item->prev->next = item->next;
+        else
+            queue->slots[level][slot] = item->next;
+        if (item->next)
+            item->next->prev = item->prev;
+        if (!queue->slots[level][slot])
+            queue->occupied[level] &= ~(1ULL << slot);
+    }
+    item->where = WHERE_NOWHERE;
+}
+
+// Distance, 1 to 64, from slot cur to the next occupied slot after it, going round.
+// occupied must not be 0.
+static int _delay_next_slot(unsigned long long occupied, int cur)
+{
+    int from = (cur + 1) & SLOT_MASK;
+
+    if (from)
+        occupied = (occupied >> from) | (occupied << (FASTCOND_DELAY_SLOTS - from));
+    return _ctz64(occupied) + 1;
+}
+
+// The first tick of the next occupied slot of level.  A level-0 slot is one tick, so there
+// this is the deadline of its items; above that it is a lower bound.
+static long long _delay_slot_start(fastcond_delay_queue_t *queue, int level)
+{
+    int shift = SLOT_BITS * level;
+    long long block = queue->now >> shift;
+
+    block += _delay_next_slot(queue->occupied[level], (int) block & SLOT_MASK);
+    return block << shift;
+}
+
+// The next tick at which the wheel has work: a level-0 slot to make due, or a higher slot to
+// spread over the levels below.  LLONG_MAX if the wheel is empty.
+static long long _delay_next_event(fastcond_delay_queue_t *queue)
+{
+    long long next = LLONG_MAX, start;
+    int level;
+
+    for (level = 0; level < FASTCOND_DELAY_LEVELS; level++) {
+        if (!queue->occupied[level])
+            continue;
+        start = _delay_slot_start(queue, level);
+        if (start < next)
+            next = start;
+    }
+    return next;
+}
+
+// The earliest deadline in the wheel, or LLONG_MAX if it is empty.  Above level 0 only the
+// first occupied slot of a level can hold it, and only if that slot starts early enough to
+// be worth scanning.
+static long long _delay_earliest(fastcond_delay_queue_t *queue)
+{
+    long long earliest = LLONG_MAX, start;
+    fastcond_delay_item_t *item;
+    int level, shift;
+
+    for (level = 0; level < FASTCOND_DELAY_LEVELS; level++) {
+        if (!queue->occupied[level])
+            continue;
+        start = _delay_slot_start(queue, level);
+        if (start >= earliest)
+            continue;
+        if (level == 0) {
+            earliest = start;
+            continue;
+        }
+        shift = SLOT_BITS * level;
+        item = queue->slots[level][(int) (start >> shift) & SLOT_MASK];
+        for (; item != NULL; item = item->next) {
+            if (item->tick < earliest)
+                earliest = item->tick;
+        }
+    }
+    return earliest;
+}
+
+// Turn the wheel to the current time, jumping between the ticks where it has work
+static void _delay_advance(fastcond_delay_queue_t *queue)
+{
+    long long target = (_delay_clock_us() - queue->base_us) / queue->tick_us;
+    fastcond_delay_item_t *item, *next;
+    int level, slot;
+
+    while (queue->now < target) {
+        long long tick = _delay_next_event(queue);
+
+        if (tick > target) {
+            queue->now = target;
+            break;
+        }
+        queue->now = tick;
+        // Spread the slots that start now over the levels below, top level first
+        for (level = FASTCOND_DELAY_LEVELS - 1; level > 0; level--) {
+            int shift = SLOT_BITS * level;
+
+            if (tick & ((1LL << shift) - 1))
+                continue;
+            slot = (int) (tick >> shift) & SLOT_MASK;
+            item = queue->slots[level][slot];
+            queue->slots[level][slot] = NULL;
+            queue->occupied[level] &= ~(1ULL << slot);
+            for (; item != NULL; item = next) {
+                next = item->next;
+                _delay_place(queue, item);
+            }
+        }
+        slot = (int) tick & SLOT_MASK;
+        item = queue->slots[0][slot];
+        queue->slots[0][slot] = NULL;
+        queue->occupied[0] &= ~(1ULL << slot);
+        for (; item != NULL; item = next) {
+            next = item->next;
+            _due_append(queue, item);
+        }
+    }
+}
+
+static int _delay_pop(fastcond_delay_queue_t *queue, fastcond_delay_item_t **item,
+                      const struct timespec *abstime, int block)
+{
+    struct timespec lead_deadline;
+    int timed_out = 0, err;
+
+    NATIVE_MUTEX_LOCK(&queue->mutex);
+    for (;;) {
+        long long earliest;
+
+        _delay_advance(queue);
+        if (queue->due_head) {
+            *item = queue->due_head;
+            _delay_remove(queue, *item);
+            queue->count--;
+            err = 0;
+            break;
+        }
+        if (queue->closed) {
+            err = EPIPE;
+            break;
+        }
+        if (!block) {
+            err = EAGAIN;
+            break;
+        }
+        if (timed_out) {
+            err = ETIMEDOUT;
+            break;
+        }
+
+        earliest = queue->count ? _delay_earliest(queue) : LLONG_MAX;
+        queue->n_waiting++;
+        if (!queue->leader && earliest != LLONG_MAX) {
+            // Lead: sleep until the earliest deadline, or our own if that comes first
+            const struct timespec *deadline = &lead_deadline;
+
+            queue->leader = &lead_deadline;
+            queue->lead_tick = earliest;
+            _delay_timespec(queue, earliest, &lead_deadline);
+            if (abstime && (abstime->tv_sec < lead_deadline.tv_sec ||
+                            (abstime->tv_sec == lead_deadline.tv_sec &&
+                             abstime->tv_nsec < lead_deadline.tv_nsec)))
+                deadline = abstime;
+            err = fastcond_cond_timedwait(&queue->cond, &queue->mutex, deadline);
+            timed_out = err == ETIMEDOUT && deadline == abstime;
+            if (queue->leader == &lead_deadline)
+                queue->leader = NULL;
+        } else if (abstime) {
+            timed_out = fastcond_cond_timedwait(&queue->cond, &queue->mutex, abstime) == ETIMEDOUT;
+        } else {
+            fastcond_cond_wait(&queue->cond, &queue->mutex);
+        }
+        queue->n_waiting--;
+    }
+    // Hand over to a follower: to take the next due item, or to lead in our place
+    if (queue->n_waiting && (queue->due_head || (!queue->leader && queue->count)))
+        fastcond_cond_signal(&queue->cond);
+    NATIVE_MUTEX_UNLOCK(&queue->mutex);
+    return err;
+}
+
+int fastcond_delay_item_init(fastcond_delay_item_t *item, void *value)
+{
+    if (!item)
+        return EINVAL;
+    item->value = value;
+    item->next = item->prev = NULL;
+    item->tick = 0;
+    item->where = WHERE_NOWHERE;
+    return 0;
+}
+
+int fastcond_delay_queue_init(fastcond_delay_queue_t *queue, long long tick_us)
+{
+    int err, level, slot;
+
+    if (tick_us < 0)
+        return EINVAL;
+    err = fastcond_cond_init(&queue->cond, NULL);
+    if (err)
+        return err;
+    NATIVE_MUTEX_INIT(&queue->mutex);
+    queue->tick_us = tick_us ? tick_us : FASTCOND_DELAY_TICK_US;
+    queue->base_us = _delay_clock_us();
+    queue->now = 0;
+    for (level = 0; level < FASTCOND_DELAY_LEVELS; level++) {
+        queue->occupied[level] = 0;
+        for (slot = 0; slot < FASTCOND_DELAY_SLOTS; slot++)
+            queue->slots[level][slot] = NULL;
+    }
+    queue->due_head = queue->due_tail = NULL;
+    queue->count = 0;
+    queue->n_waiting = 0;
+    queue->leader = NULL;
+    queue->lead_tick = 0;
+    queue->closed = 0;
+    return 0;
+}
+
+int fastcond_delay_queue_fini(fastcond_delay_queue_t *queue)
+{
+    fastcond_cond_fini(&queue->cond);
+    NATIVE_MUTEX_DESTROY(&queue->mutex);
+    return 0;
+}
+
+int fastcond_delay_queue_push(fastcond_delay_queue_t *queue, fastcond_delay_item_t *item,
+                              const struct timespec *abstime)
+{
+    NATIVE_MUTEX_LOCK(&queue->mutex);
+    if (queue->closed) {
+        NATIVE_MUTEX_UNLOCK(&queue->mutex);
+        return EPIPE;
+    }
+    item->tick = _delay_tick(queue, abstime);
+    _delay_place(queue, item);
+    queue->count++;
+    // Wake a consumer only if the item changes what the blocked ones are waiting for.  A
+    // leader about to be overtaken gives up the lead to whichever consumer wakes.
+    if (queue->n_waiting &&
+        (item->where == WHERE_DUE || !queue->leader || item->tick < queue->lead_tick)) {
+        queue->leader = NULL;
+        fastcond_cond_signal(&queue->cond);
+    }
+    NATIVE_MUTEX_UNLOCK(&queue->mutex);
+    return 0;
+}
+
+int fastcond_delay_queue_cancel(fastcond_delay_queue_t *queue, fastcond_delay_item_t *item)
+{
+    int err = ENOENT;
+
+    NATIVE_MUTEX_LOCK(&queue->mutex);
+    if (item->where != WHERE_NOWHERE) {
+        _delay_remove(queue, item);
+        queue->count--;
+        err = 0;
+    }
+    NATIVE_MUTEX_UNLOCK(&queue->mutex);
+    return err;
+}
+
+int fastcond_delay_queue_pop(fastcond_delay_queue_t *queue, fastcond_delay_item_t **item)
+{
+    return _delay_pop(queue, item, NULL, 1);
+}
+
+int fastcond_delay_queue_timedpop(fastcond_delay_queue_t *queue, fastcond_delay_item_t **item,
+                                  const struct timespec *abstime)
+{
+    return _delay_pop(queue, item, abstime, 1);
+}
+
+int fastcond_delay_queue_trypop(fastcond_delay_queue_t *queue, fastcond_delay_item_t **item)
+{
+    return _delay_pop(queue, item, NULL, 0);
+}
+
+int fastcond_delay_queue_size(fastcond_delay_queue_t *queue)
+{
+    int count;
+
+    NATIVE_MUTEX_LOCK(&queue->mutex);
+    count = queue->count;
+    NATIVE_MUTEX_UNLOCK(&queue->mutex);
+    return count;
+}
+
+int fastcond_delay_queue_close(fastcond_delay_queue_t *queue)
+{
+    NATIVE_MUTEX_LOCK(&queue->mutex);
+    queue->closed = 1;
+    if (queue->n_waiting)
+        fastcond_cond_broadcast(&queue->cond);
+    NATIVE_MUTEX_UNLOCK(&queue->mutex);
+    return 0;
+}
@@ -0,0 +1,101 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#ifndef _FASTCOND_DELAY_H_
+#define _FASTCOND_DELAY_H_
+
+#include "fastcond.h"
+#include "native_primitives.h"
+
+// A delay queue: items pushed with a deadline are popped once it has passed.
+//
+// Pending items sit in a hierarchical timing wheel of FASTCOND_DELAY_LEVELS levels of 64
+// slots, one tick per level-0 slot and 64 times the span of the level below per slot
+// above that.  Insertion and cancellation are O(1) whatever the number of items, and an
+// item moves down a level only when the wheel reaches its slot; items beyond the top level
+// wait in its furthest slot and are placed again from there.  Deadlines are rounded up to
+// whole ticks, FASTCOND_DELAY_TICK_US unless fastcond_delay_queue_init() is given another.
+//
+// Consumers work as leader and followers.  One blocked consumer, the leader, sleeps with a
+// timeout of exactly the earliest deadline in the wheel; the others sleep without one.  A
+// push signals only when it makes an item due, or earlier than the leader's timeout, or
+// when no consumer is leading, so items queued behind the earliest cause no wakeups at all.
+// A consumer that takes an item while more are due, or that leaves no leader behind, hands
+// over to one follower.
+//
+// Items are owned by the caller and linked into the queue, so a push allocates nothing; an
+// item must stay valid, and must not be pushed again, until it is popped or cancelled.
+//
+// After fastcond_delay_queue_close() pushes fail with EPIPE and pops return items already
+// due, then fail with EPIPE too; blocked threads are woken.  Items not yet due stay in the
+// queue.  Deadlines are absolute CLOCK_REALTIME times, as for fastcond_cond_timedwait().
+
+#ifndef FASTCOND_DELAY_TICK_US
+#define FASTCOND_DELAY_TICK_US 1000
+#endif
+
+// 4 levels of 64 slots span 2^24 ticks, about 4.7 hours at the default tick
+#ifndef FASTCOND_DELAY_LEVELS
+#define FASTCOND_DELAY_LEVELS 4
+#endif
+
+#define FASTCOND_DELAY_SLOTS 64
+
+typedef struct _fastcond_delay_item_t {
+    void *value; // for the caller
+    struct _fastcond_delay_item_t *next;
+    struct _fastcond_delay_item_t *prev;
+    long long tick; // deadline
+    int where;      // wheel slot, the due list, or nowhere.  Under the queue mutex.
+} fastcond_delay_item_t;
+
+typedef struct _fastcond_delay_queue_t {
+    native_mutex_t mutex;
+    fastcond_cond_t cond;
+    long long base_us; // CLOCK_REALTIME of tick 0
+    long long tick_us;
+    long long now; // the wheel has moved every item with a deadline up to now to due
+    unsigned long long occupied[FASTCOND_DELAY_LEVELS]; // non-empty slots
+    fastcond_delay_item_t *slots[FASTCOND_DELAY_LEVELS][FASTCOND_DELAY_SLOTS];
+    fastcond_delay_item_t *due_head; // items past their deadline, in the order they came due
+    fastcond_delay_item_t *due_tail;
+    int count;     // items in the wheel and on the due list
+    int n_waiting; // consumers blocked on cond
+    void *leader;  // identifies the consumer blocked until lead_tick, or NULL
+    long long lead_tick;
+    int closed;
+} fastcond_delay_queue_t;
+
+// Returns 0, or EINVAL if item is NULL
+int fastcond_delay_item_init(fastcond_delay_item_t *item, void *value);
+
+// tick_us of 0 means FASTCOND_DELAY_TICK_US.  Returns 0, EINVAL for a negative tick_us, or
+// an error from fastcond_cond_init().
+int fastcond_delay_queue_init(fastcond_delay_queue_t *queue, long long tick_us);
+
+// No thread may be using the queue.  Items still in it are dropped.
+int fastcond_delay_queue_fini(fastcond_delay_queue_t *queue);
+
+// Queue an initialised item until abstime.  Returns 0, or EPIPE once the queue is closed.
+int fastcond_delay_queue_push(fastcond_delay_queue_t *queue, fastcond_delay_item_t *item,
+                              const struct timespec *abstime);
+
+// Take an initialised item back out.  Returns 0, or ENOENT if it is not in the queue.
+int fastcond_delay_queue_cancel(fastcond_delay_queue_t *queue, fastcond_delay_item_t *item);
+
+// Wait for an item to come due and take it.  Returns 0, or EPIPE once the queue is closed
+// and no item is due.
+int fastcond_delay_queue_pop(fastcond_delay_queue_t *queue, fastcond_delay_item_t **item);
+
+// Returns 0, EPIPE, or ETIMEDOUT if no item came due before abstime
+int fastcond_delay_queue_timedpop(fastcond_delay_queue_t *queue, fastcond_delay_item_t **item,
+                                  const struct timespec *abstime);
+
+// Returns 0, EPIPE, or EAGAIN if no item is due
+int fastcond_delay_queue_trypop(fastcond_delay_queue_t *queue, fastcond_delay_item_t **item);
+
+// Items queued, due or not
+int fastcond_delay_queue_size(fastcond_delay_queue_t *queue);
+
+int fastcond_delay_queue_close(fastcond_delay_queue_t *queue);
+
+#endif /* ! defined _FASTCOND_DELAY_H_ */
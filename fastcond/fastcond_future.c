@@ -0,0 +1,322 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#include "fastcond_future.h"
+#include <errno.h>
+#include <stdlib.h>
+
+// Polling rounds before a waiter blocks, on multi-core machines
+#ifndef FASTCOND_FUTURE_SPIN
+#define FASTCOND_FUTURE_SPIN 100
+#endif
+
+// Spinlock rounds before a thread waiting for a future's lock yields its time slice
+#define FUTURE_LOCK_SPIN 64
+
+// Wait nodes kept on the stack; waits on more futures allocate them
+#define FUTURE_STACK_NODES 16
+
+#define FUTURE_PENDING 0
+#define FUTURE_READY 1
+
+#define CLAIM_NONE -1
+#define CLAIM_CANCELLED -2 // the waiter timed out
+
+// One per blocking wait, shared by its wait nodes
+struct _fastcond_future_parker {
+    volatile int selected;  // index claimed by the waking promise, or CLAIM_*
+    volatile int remaining; // when_all: futures still pending, plus one while registering
+    int all;
+    int done; // under mutex: the waking promise is finished with us
+    native_mutex_t mutex;
+    fastcond_cond_t cond;
+};
+
+// One per future of a blocking wait, on that future's waiter list
+struct _fastcond_future_waiter {
+    struct _fastcond_future_waiter *next;
+    struct _fastcond_future_waiter *prev;
+    struct _fastcond_future_parker *parker;
+    int index;  // of the future among those waited on
+    int linked; // on the future's list.  Under the future's lock.
+};
+
+static int _future_spin = -1;
+
+static int _future_spin_rounds(void)
+{
+    if (_future_spin < 0)
+        _future_spin = native_cpu_count() > 1 ? FASTCOND_FUTURE_SPIN : 0;
+    return _future_spin;
+}
+
+// The lock is held for a few pointer updates at a time, but its holder may be preempted
+static void _future_lock(fastcond_future_t *future)
+{
+    int spins = 0;
+
+    while (!native_atomic_cas(&future->lock, 0, 1)) {
+        while (native_atomic_load(&future->lock)) {
+            if (++spins < FUTURE_LOCK_SPIN) {
+                NATIVE_CPU_RELAX();
+            } else {
+                NATIVE_THREAD_YIELD();
+                spins = 0;
+            }
+        }
+    }
+}
+
+static void _future_unlock(fastcond_future_t *future)
+{
+    native_atomic_store(&future->lock, 0);
+}
+
+// Count a completed future against the node's wait.  Returns 1 if that satisfied the wait and
+// the caller must wake it.  Caller holds the future's lock.
+static int _future_claim(struct _fastcond_future_waiter *w)
+{
+    struct _fastcond_future_parker *parker = w->parker;
+
+    if (parker->all && native_atomic_add(&parker->remaining, -1) != 0)
+        return 0;
+    return native_atomic_cas(&parker->selected, CLAIM_NONE, w->index);
+}
+
+// Wake a claimed waiter.  Its nodes and parker are on its stack: once the parker's mutex is
+// released here they may be gone.
+static void _future_wake(struct _fastcond_future_parker *parker)
+{
+    NATIVE_MUTEX_LOCK(&parker->mutex);
+    parker->done = 1;
+    fastcond_cond_signal(&parker->cond);
+    NATIVE_MUTEX_UNLOCK(&parker->mutex);
+}
+
+static int _future_complete(fastcond_future_t *future, void *value, int err)
+{
+    struct _fastcond_future_waiter *w, *next, *wake = NULL;
+
+    _future_lock(future);
+    if (future->state != FUTURE_PENDING) {
+        _future_unlock(future);
+        return EBUSY;
+    }
+    future->value = value;
+    future->err = err;
+    native_atomic_store(&future->state, FUTURE_READY);
+    // Claim under the lock, so that a waiter taking its nodes off this list waits for us
+    for (w = future->waiters; w != NULL; w = next) {
+        next = w->next;
+        w->linked = 0;
+        if (_future_claim(w)) {
+            w->next = wake;
+            wake = w;
+        }
+    }
+    future->waiters = NULL;
+    _future_unlock(future);
+
+    while (wake != NULL) {
+        next = wake->next;
+        _future_wake(wake->parker);
+        wake = next;
+    }
+    return 0;
+}
+
+// Poll until every (all) or any future is ready.  Returns 1 with *index set to a ready one
+// for any, or 0 if the spin ran out.
+static int _future_poll(fastcond_future_t *const *futures, int n, int all, int *index)
+{
+    int spin = _future_spin_rounds();
+    int first = 0; // when_all: futures before it are ready
+    int i;
+
+    for (;;) {
+        if (all) {
+            while (first < n && native_atomic_load(&futures[first]->state) != FUTURE_PENDING)
+                first++;
+            if (first == n)
+                return 1;
+        } else {
+            for (i = 0; i < n; i++) {
+                if (native_atomic_load(&futures[i]->state) != FUTURE_PENDING) {
+                    *index = i;
+                    return 1;
+                }
+            }
+        }
+        if (spin-- <= 0)
+            return 0;
+        NATIVE_CPU_RELAX();
+    }
+}
+
+// Block until every (all) or any future is ready, with one wait node per future
+static int _future_wait(fastcond_future_t *const *futures, int n, int all,
+                        const struct timespec *abstime, int *index)
+{
+    struct _fastcond_future_waiter stack_nodes[FUTURE_STACK_NODES];
+    struct _fastcond_future_waiter *nodes = stack_nodes;
+    struct _fastcond_future_parker parker;
+    int i, registered, claimed = 0, err;
+
+    if (n > FUTURE_STACK_NODES) {
+        nodes = malloc(sizeof(struct _fastcond_future_waiter) * (size_t) n);
+        if (!nodes)
+            return ENOMEM;
+    }
+    err = fastcond_cond_init(&parker.cond, NULL);
+    if (err)
+        goto out;
+    NATIVE_MUTEX_INIT(&parker.mutex);
+    parker.selected = CLAIM_NONE;
+    parker.remaining = 1;
+    parker.all = all;
+    parker.done = 0;
+
+    for (registered = 0; registered < n && !claimed; registered++) {
+        fastcond_future_t *future = futures[registered];
+        struct _fastcond_future_waiter *w = &nodes[registered];
+
+        w->parker = &parker;
+        w->index = registered;
+        w->linked = 0;
+        _future_lock(future);
+        if (future->state == FUTURE_PENDING) {
+            w->prev = NULL;
+            w->next = future->waiters;
+            if (future->waiters)
+                future->waiters->prev = w;
+            future->waiters = w;
+            w->linked = 1;
+            if (all)
+                native_atomic_add(&parker.remaining, 1);
+        } else if (!all) {
+            // Ready since we polled.  If the claim fails, an earlier future's promise has
+            // claimed us and will wake us; either way there is no need to go on.
+            claimed = native_atomic_cas(&parker.selected, CLAIM_NONE, registered);
+            if (!claimed)
+                claimed = -1;
+        }
+        _future_unlock(future);
+    }
+    // when_all: drop the registration count.  Reaching zero here means no promise will.
+    if (all && native_atomic_add(&parker.remaining, -1) == 0)
+        claimed = native_atomic_cas(&parker.selected, CLAIM_NONE, 0);
+
+    if (claimed <= 0) {
+        const struct timespec *deadline = abstime;
+
+        NATIVE_MUTEX_LOCK(&parker.mutex);
+        while (!parker.done) {
+            if (!deadline) {
+                fastcond_cond_wait(&parker.cond, &parker.mutex);
+            } else if (fastcond_cond_timedwait(&parker.cond, &parker.mutex, deadline) ==
+                       ETIMEDOUT) {
+                if (native_atomic_cas(&parker.selected, CLAIM_NONE, CLAIM_CANCELLED)) {
+                    err = ETIMEDOUT;
+                    break;
+                }
+                deadline = NULL; // claimed just now; the wake is on its way
+            }
+        }
+        NATIVE_MUTEX_UNLOCK(&parker.mutex);
+    }
+
+    // Take our nodes off the futures still pending.  Taking each lock also waits out a
+    // promise that is looking at our node while it completes.
+    for (i = 0; i < registered; i++) {
+        fastcond_future_t *future = futures[i];
+        struct _fastcond_future_waiter *w = &nodes[i];
+
+        _future_lock(future);
+        if (w->linked) {
+            if (w->prev)
+                w->prev->next = w->next;
+            else
+                future->waiters = w->next;
+            if (w->next)
+                w->next->prev = w->prev;
+        }
+        _future_unlock(future);
+    }
+    if (!err && index)
+        *index = parker.selected;
+    fastcond_cond_fini(&parker.cond);
+    NATIVE_MUTEX_DESTROY(&parker.mutex);
+out:
+    if (nodes != stack_nodes)
+        free(nodes);
+    return err;
+}
+
+int fastcond_promise_init(fastcond_promise_t *promise, fastcond_future_t *future)
+{
+    future->state = FUTURE_PENDING;
+    future->lock = 0;
+    future->value = NULL;
+    future->err = 0;
+    future->waiters = NULL;
+    promise->future = future;
+    return 0;
+}
+
+int fastcond_promise_set_value(fastcond_promise_t *promise, void *value)
+{
+    return _future_complete(promise->future, value, 0);
+}
+
+int fastcond_promise_set_error(fastcond_promise_t *promise, int err)
+{
+    if (err == 0)
+        return EINVAL;
+    return _future_complete(promise->future, NULL, err);
+}
+
+int fastcond_future_ready(fastcond_future_t *future)
+{
+    return native_atomic_load(&future->state) != FUTURE_PENDING;
+}
+
+int fastcond_future_get(fastcond_future_t *future, void **value)
+{
+    return fastcond_future_timedget(future, value, NULL);
+}
+
+int fastcond_future_timedget(fastcond_future_t *future, void **value,
+                             const struct timespec *abstime)
+{
+    int index, err;
+
+    if (!_future_poll(&future, 1, 0, &index)) {
+        err = _future_wait(&future, 1, 0, abstime, &index);
+        if (err)
+            return err;
+    }
+    if (future->err)
+        return future->err;
+    if (value)
+        *value = future->value;
+    return 0;
+}
+
+int fastcond_future_when_all(fastcond_future_t *const *futures, int n,
+                             const struct timespec *abstime)
+{
+    if (n < 0)
+        return EINVAL;
+    if (_future_poll(futures, n, 1, NULL))
+        return 0;
+    return _future_wait(futures, n, 1, abstime, NULL);
+}
+
+int fastcond_future_when_any(fastcond_future_t *const *futures, int n,
+                             const struct timespec *abstime, int *index)
+{
+    if (n < 1)
+        return EINVAL;
+    if (_future_poll(futures, n, 0, index))
+        return 0;
+    return _future_wait(futures, n, 0, abstime, index);
+}
@@ -0,0 +1,66 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#ifndef _FASTCOND_FUTURE_H_
+#define _FASTCOND_FUTURE_H_
+
+#include "fastcond.h"
+#include "native_primitives.h"
+
+// One-shot futures and promises.
+//
+// A fastcond_future_t holds a result, a void * or an error code, that a fastcond_promise_t
+// sets once.  The future owns no mutex and no condition variable: it is a state word, the
+// result and a list of waiters guarded by a spinlock word, and needs no fini.  Looking at a
+// completed future is one atomic load, and a waiter spins briefly on multi-core machines
+// before it blocks, so a result that is ready, or nearly so, costs no mutex and no syscall.
+//
+// A thread that must block brings its own wait node: a mutex and a fastcond_cond_t on its
+// stack, linked into the waiter list of every future it waits on.  The promise detaches the
+// list when it completes the future and wakes only the waiters it satisfied.
+// fastcond_future_when_all() and fastcond_future_when_any() wait on many futures with the
+// one node, so a thread waiting for dozens of completions sleeps and wakes once.
+//
+// Deadlines are absolute CLOCK_REALTIME times, as for fastcond_cond_timedwait(); NULL waits
+// without one.
+
+struct _fastcond_future_waiter;
+
+typedef struct _fastcond_future_t {
+    volatile int state; // pending or ready
+    volatile int lock;  // spinlock over the waiter list and completion
+    void *value;
+    int err;
+    struct _fastcond_future_waiter *waiters;
+} fastcond_future_t;
+
+// The completing side of a future
+typedef struct _fastcond_promise_t {
+    fastcond_future_t *future;
+} fastcond_promise_t;
+
+// Reset future to pending and bind promise to it.  The future must have no waiters.
+int fastcond_promise_init(fastcond_promise_t *promise, fastcond_future_t *future);
+// Complete the future with a value, or with a nonzero error code.  Returns 0, EBUSY if the
+// future is already complete, or EINVAL for an error code of 0.
+int fastcond_promise_set_value(fastcond_promise_t *promise, void *value);
+int fastcond_promise_set_error(fastcond_promise_t *promise, int err);
+
+// Nonzero once the future is complete
+int fastcond_future_ready(fastcond_future_t *future);
+// Wait for the future.  Returns 0 and stores its value in *value (if value is not NULL), or
+// returns the error it was completed with, or ENOMEM or an error from fastcond_cond_init().
+int fastcond_future_get(fastcond_future_t *future, void **value);
+// As fastcond_future_get(), or ETIMEDOUT if the future is still pending at abstime
+int fastcond_future_timedget(fastcond_future_t *future, void **value,
+                             const struct timespec *abstime);
+
+// Wait until every one of n futures is complete.  Returns 0, EINVAL for n < 0, ETIMEDOUT,
+// ENOMEM or an error from fastcond_cond_init().
+int fastcond_future_when_all(fastcond_future_t *const *futures, int n,
+                             const struct timespec *abstime);
+// Wait until at least one of n futures is complete and store its position in *index.
+// Returns 0, EINVAL for n < 1, ETIMEDOUT, ENOMEM or an error from fastcond_cond_init().
+int fastcond_future_when_any(fastcond_future_t *const *futures, int n,
+                             const struct timespec *abstime, int *index);
+
+#endif /* ! defined _FASTCOND_FUTURE_H_ */
@@ -0,0 +1,425 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#include "fastcond_pool.h"
+#include <errno.h>
+#include <stdlib.h>
+
+// Search rounds before an idle worker parks, on multi-core machines
+#ifndef FASTCOND_POOL_SPIN
+#define FASTCOND_POOL_SPIN 64
+#endif
+
+#define DEQUE_MASK (FASTCOND_POOL_DEQUE_SIZE - 1)
+#define POOL_CACHE_LINE 64
+
+// fastcond_task_t.state
+#define TASK_PENDING 0
+#define TASK_WAITED 1 // a thread is blocked on done_cond for it
+#define TASK_DONE 2
+
+#ifdef NATIVE_USE_WINDOWS
+typedef HANDLE pool_thread_t;
+#else
+typedef pthread_t pool_thread_t;
+#endif
+
+struct _fastcond_pool_worker {
+    volatile int top; // thieves take here
+    char pad1[POOL_CACHE_LINE - sizeof(int)];
+    volatile int bottom; // the owner pushes and takes here
+    char pad2[POOL_CACHE_LINE - sizeof(int)];
+    fastcond_task_t *volatile slots[FASTCOND_POOL_DEQUE_SIZE];
+    fastcond_pool_t *pool;
+    unsigned rng; // victim selection
+    pool_thread_t thread;
+};
+
+static NATIVE_THREAD_LOCAL struct _fastcond_pool_worker *_current_worker;
+
+// Index difference, correct across wrap-around of the indices
+static inline int _deque_diff(int a, int b)
+{
+    return (int) ((unsigned) a - (unsigned) b);
+}
+
+static inline int _deque_next(int i)
+{
+    return (int) ((unsigned) i + 1);
+}
+
+/* The Chase-Lev deque, in the formulation of Lê, Pop, Cohen and Zappa Nardelli ("Correct and
+ * Efficient Work-Stealing for Weak Memory Models", 2013), on a fixed ring.  The owner pushes
+ * and takes at the bottom; thieves take at the top.  Only the owner's take of the last task
+ * contends with thieves, and both sides settle that with a compare-and-swap on top.
+ */
+
+// Owner only.  Returns 0 if the deque is full.
+static int _deque_push(struct _fastcond_pool_worker *w, fastcond_task_t *task)
+{
+    int b = w->bottom;
+    int t = native_atomic_load(&w->top);
+
+    if (_deque_diff(b, t) >= FASTCOND_POOL_DEQUE_SIZE)
+        return 0;
+    w->slots[b & DEQUE_MASK] = task;
+    native_atomic_store(&w->bottom, _deque_next(b)); // release: publishes the slot
+    return 1;
+}
+
+// Owner only.  The newest task, or NULL.
+static fastcond_task_t *_deque_take(struct _fastcond_pool_worker *w)
+{
+    int b = _deque_diff(w->bottom, 1);
+    int t;
+    fastcond_task_t *task;
+
+    native_atomic_store(&w->bottom, b);
+    native_atomic_fence(); // thieves must see the claim on slot b before we read top
+    t = native_atomic_load(&w->top);
+    if (_deque_diff(b, t) < 0) {
+        native_atomic_store(&w->bottom, _deque_next(b));
+        return NULL;
+    }
+    task = w->slots[b & DEQUE_MASK];
+    if (b != t)
+        return task; // not the last one: out of thieves' reach
+    if (!native_atomic_cas(&w->top, t, _deque_next(t)))
+        task = NULL; // a thief got it
+    native_atomic_store(&w->bottom, _deque_next(b));
+    return task;
+}
+
+// Any thread.  The oldest task, or NULL once the deque is empty.
+static fastcond_task_t *_deque_steal(struct _fastcond_pool_worker *w)
+{
+    for (;;) {
+        int t = native_atomic_load(&w->top);
+        int b;
+        fastcond_task_t *task;
+
+        native_atomic_fence();
+        b = native_atomic_load(&w->bottom);
+        if (_deque_diff(b, t) <= 0)
+            return NULL;
+        task = w->slots[t & DEQUE_MASK];
+        if (native_atomic_cas(&w->top, t, _deque_next(t)))
+            return task;
+    }
+}
+
+// Caller holds pool->mutex
+static fastcond_task_t *_inject_pop_locked(fastcond_pool_t *pool)
+{
+    fastcond_task_t *task = pool->inject_head;
+
+    if (task) {
+        pool->inject_head = task->next;
+        if (!pool->inject_head)
+            pool->inject_tail = NULL;
+        native_atomic_add(&pool->n_injected, -1);
+    }
+    return task;
+}
+
+// A task from the injection queue or another worker's deque, or NULL.  locked: the caller
+// holds pool->mutex.
+static fastcond_task_t *_pool_find(fastcond_pool_t *pool, struct _fastcond_pool_worker *w,
+                                   int locked)
+{
+    fastcond_task_t *task = NULL;
+    int i, start, n = pool->n_workers;
+
+    if (native_atomic_load(&pool->n_injected) > 0) {
+        if (!locked)
+            NATIVE_MUTEX_LOCK(&pool->mutex);
+        task = _inject_pop_locked(pool);
+        if (!locked)
+            NATIVE_MUTEX_UNLOCK(&pool->mutex);
+        if (task)
+            return task;
+    }
+    w->rng = w->rng * 1103515245u + 12345u;
+    start = (int) ((w->rng >> 16) % (unsigned) n);
+    for (i = 0; i < n; i++) {
+        struct _fastcond_pool_worker *victim = &pool->workers[(start + i) % n];
+
+        if (victim != w && (task = _deque_steal(victim)) != NULL)
+            return task;
+    }
+    return NULL;
+}
+
+// Wake one parked worker that has not been woken yet, as a searcher
+static void _pool_wake(fastcond_pool_t *pool)
+{
+    if (native_atomic_add(&pool->n_sleeping, 0) == 0)
+        return;
+    NATIVE_MUTEX_LOCK(&pool->mutex);
+    if (pool->n_sleeping > pool->n_notified) {
+        pool->n_notified++;
+        native_atomic_add(&pool->n_searching, 1);
+        fastcond_cond_signal(&pool->cond);
+    }
+    NATIVE_MUTEX_UNLOCK(&pool->mutex);
+}
+
+/* Parking follows the semaphore handshake of fastcond_sync.c.  A worker about to park
+ * registers in n_sleeping, then looks for work once more; a submitter publishes its task,
+ * then reads n_searching and n_sleeping.  All of these are read-modify-write operations, so
+ * either the worker finds the task or the submitter finds the worker and wakes it.  The same
+ * holds between a submitter and a searcher leaving n_searching, which looks once more on its
+ * way to parking.
+ */
+
+// Look for work, counted in n_searching.  counted: a waker has already counted us.
+static fastcond_task_t *_pool_search(fastcond_pool_t *pool, struct _fastcond_pool_worker *w,
+                                     int counted)
+{
+    fastcond_task_t *task;
+    int round = 0;
+
+    if (!counted)
+        native_atomic_add(&pool->n_searching, 1);
+    while ((task = _pool_find(pool, w, 0)) == NULL && round++ < pool->spin)
+        NATIVE_CPU_RELAX();
+    // The last searcher to find work hands the search on, in case there is more
+    if (native_atomic_add(&pool->n_searching, -1) == 0 && task)
+        _pool_wake(pool);
+    return task;
+}
+
+// Park until woken.  Returns a task found at the last look, or NULL with *searching set if
+// we were woken as a searcher.
+static fastcond_task_t *_pool_park(fastcond_pool_t *pool, struct _fastcond_pool_worker *w,
+                                   int *searching)
+{
+    fastcond_task_t *task;
+
+    NATIVE_MUTEX_LOCK(&pool->mutex);
+    native_atomic_add(&pool->n_sleeping, 1);
+    task = _pool_find(pool, w, 1);
+    if (!task && !pool->shutdown) {
+        fastcond_cond_wait(&pool->cond, &pool->mutex);
+        if (pool->n_notified > 0) {
+            pool->n_notified--;
+            *searching = 1;
+        }
+    }
+    native_atomic_add(&pool->n_sleeping, -1);
+    NATIVE_MUTEX_UNLOCK(&pool->mutex);
+    return task;
+}
+
+static void _pool_run(fastcond_pool_t *pool, fastcond_task_t *task)
+{
+    task->fn(task->arg);
+    // The task may be gone as soon as it is marked done
+    if (native_atomic_exchange(&task->state, TASK_DONE) == TASK_WAITED) {
+        NATIVE_MUTEX_LOCK(&pool->done_mutex);
+        fastcond_cond_broadcast(&pool->done_cond);
+        NATIVE_MUTEX_UNLOCK(&pool->done_mutex);
+    }
+}
+
+static void _pool_worker_main(struct _fastcond_pool_worker *w)
+{
+    fastcond_pool_t *pool = w->pool;
+    fastcond_task_t *task;
+    int searching = 0;
+
+    _current_worker = w;
+    for (;;) {
+        task = _deque_take(w);
+        if (!task) {
+            task = _pool_search(pool, w, searching);
+            searching = 0;
+        }
+        if (!task && !native_atomic_load(&pool->shutdown))
+            task = _pool_park(pool, w, &searching);
+        if (task)
+            _pool_run(pool, task);
+        else if (!searching && native_atomic_load(&pool->shutdown))
+            break;
+    }
+    _current_worker = NULL;
+}
+
+#ifdef NATIVE_USE_WINDOWS
+static unsigned __stdcall _pool_thread(void *arg)
+{
+    _pool_worker_main((struct _fastcond_pool_worker *) arg);
+    return 0;
+}
+
+static int _pool_thread_start(struct _fastcond_pool_worker *w)
+{
+    w->thread = (HANDLE) _beginthreadex(NULL, 0, _pool_thread, w, 0, NULL);
+    return w->thread ? 0 : EAGAIN;
+}
+
+static void _pool_thread_join(struct _fastcond_pool_worker *w)
+{
+    WaitForSingleObject(w->thread, INFINITE);
+    CloseHandle(w->thread);
+}
+#else
+static void *_pool_thread(void *arg)
+{
+    _pool_worker_main((struct _fastcond_pool_worker *) arg);
+    return NULL;
+}
+
+static int _pool_thread_start(struct _fastcond_pool_worker *w)
+{
+    return pthread_create(&w->thread, NULL, _pool_thread, w);
+}
+
+static void _pool_thread_join(struct _fastcond_pool_worker *w)
+{
+    pthread_join(w->thread, NULL);
+}
+#endif
+
+// Stop and join the first n_started workers, and free everything
+static void _pool_stop(fastcond_pool_t *pool, int n_started)
+{
+    int i;
+
+    NATIVE_MUTEX_LOCK(&pool->mutex);
+    native_atomic_store(&pool->shutdown, 1);
+    fastcond_cond_broadcast(&pool->cond);
+    NATIVE_MUTEX_UNLOCK(&pool->mutex);
+    for (i = 0; i < n_started; i++)
+        _pool_thread_join(&pool->workers[i]);
+    fastcond_cond_fini(&pool->done_cond);
+    fastcond_cond_fini(&pool->cond);
+    NATIVE_MUTEX_DESTROY(&pool->done_mutex);
+    NATIVE_MUTEX_DESTROY(&pool->mutex);
+    free(pool->workers);
+    pool->workers = NULL;
+}
+
+int fastcond_task_init(fastcond_task_t *task, void (*fn)(void *arg), void *arg)
+{
+    if (!fn)
+        return EINVAL;
+    task->fn = fn;
+    task->arg = arg;
+    task->state = TASK_PENDING;
+    task->next = NULL;
+    return 0;
+}
+
+int fastcond_pool_init(fastcond_pool_t *pool, int n_workers)
+{
+    int i, err;
+
+    if (n_workers < 0)
+        return EINVAL;
+    if (n_workers == 0)
+        n_workers = native_cpu_count();
+    pool->workers = calloc((size_t) n_workers, sizeof(struct _fastcond_pool_worker));
+    if (!pool->workers)
+        return ENOMEM;
+    err = fastcond_cond_init(&pool->cond, NULL);
+    if (err)
+        goto fail_workers;
+    err = fastcond_cond_init(&pool->done_cond, NULL);
+    if (err)
+        goto fail_cond;
+    NATIVE_MUTEX_INIT(&pool->mutex);
+    NATIVE_MUTEX_INIT(&pool->done_mutex);
+    pool->n_workers = n_workers;
+    pool->spin = native_cpu_count() > 1 ? FASTCOND_POOL_SPIN : 0;
+    pool->n_searching = 0;
+    pool->n_sleeping = 0;
+    pool->n_notified = 0;
+    pool->shutdown = 0;
+    pool->inject_head = NULL;
+    pool->inject_tail = NULL;
+    pool->n_injected = 0;
+
+    for (i = 0; i < n_workers; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].rng = (unsigned) i * 2654435761u + 1u;
+    }
+    for (i = 0; i < n_workers; i++) {
+        err = _pool_thread_start(&pool->workers[i]);
+        if (err) {
+            _pool_stop(pool, i);
+            return err;
+        }
+    }
+    return 0;
+
+fail_cond:
+    fastcond_cond_fini(&pool->cond);
+fail_workers:
+    free(pool->workers);
+    pool->workers = NULL;
+    return err;
+}
+
+int fastcond_pool_fini(fastcond_pool_t *pool)
+{
+    _pool_stop(pool, pool->n_workers);
+    return 0;
+}
+
+int fastcond_pool_submit(fastcond_pool_t *pool, fastcond_task_t *task)
+{
+    struct _fastcond_pool_worker *w = _current_worker;
+
+    task->state = TASK_PENDING;
+    if (!w || w->pool != pool || !_deque_push(w, task)) {
+        task->next = NULL;
+        NATIVE_MUTEX_LOCK(&pool->mutex);
+        if (pool->inject_tail)
+            pool->inject_tail->next = task;
+        else
+            pool->inject_head = task;
+        pool->inject_tail = task;
+        native_atomic_add(&pool->n_injected, 1);
+        NATIVE_MUTEX_UNLOCK(&pool->mutex);
+    }
+    // A searcher will find the task; otherwise get one going
+    if (native_atomic_add(&pool->n_searching, 0) == 0)
+        _pool_wake(pool);
+    return 0;
+}
+
+int fastcond_pool_wait(fastcond_pool_t *pool, fastcond_task_t *task)
+{
+    struct _fastcond_pool_worker *w = _current_worker;
+    int s, idle = 0;
+
+    // On a worker, run other tasks meanwhile: our own first, newest first, then anyone's
+    if (w && w->pool == pool) {
+        while (native_atomic_load(&task->state) != TASK_DONE) {
+            fastcond_task_t *other = _deque_take(w);
+
+            if (!other)
+                other = _pool_find(pool, w, 0);
+            if (other) {
+                _pool_run(pool, other);
+                idle = 0;
+            } else if (idle++ >= pool->spin) {
+                break;
+            } else {
+                NATIVE_CPU_RELAX();
+            }
+        }
+    }
+
+    // The task is running elsewhere: block until it is done
+    if (native_atomic_load(&task->state) == TASK_DONE)
+        return 0;
+    NATIVE_MUTEX_LOCK(&pool->done_mutex);
+    while ((s = native_atomic_load(&task->state)) != TASK_DONE) {
+        if (s == TASK_PENDING && !native_atomic_cas(&task->state, TASK_PENDING, TASK_WAITED))
+            continue;
+        fastcond_cond_wait(&pool->done_cond, &pool->done_mutex);
+    }
+    NATIVE_MUTEX_UNLOCK(&pool->done_mutex);
+    return 0;
+}
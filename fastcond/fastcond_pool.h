@@ -0,0 +1,74 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#ifndef _FASTCOND_POOL_H_
+#define _FASTCOND_POOL_H_
+
+#include "fastcond.h"
+#include "native_primitives.h"
+
+// A work-stealing thread pool.
+//
+// Each worker owns a Chase-Lev deque: it pushes and takes tasks at the bottom without
+// locking, and idle workers steal from the top with one compare-and-swap.  Tasks submitted
+// from a worker go to its own deque; tasks from other threads, and from a worker whose deque
+// is full, go to a mutex-protected injection queue.
+//
+// A worker that runs out of work SEARCHES: it tries the injection queue and steals from the
+// other workers, for up to FASTCOND_POOL_SPIN rounds on multi-core machines and once on a
+// single CPU, before it parks on a fastcond_cond_t.  A submit wakes at most one parked
+// worker, and none while any worker is searching, since a searcher will find the task.  A
+// woken worker counts as searching from the moment it is woken, and the last searcher to find
+// work wakes one more worker, so parallelism ramps up one worker at a time as work appears.
+//
+// fastcond_pool_wait() on a worker runs other tasks while the awaited one is unfinished, for
+// fork/join; elsewhere it blocks.  Tasks are owned by the caller and must stay valid until
+// they are done.
+
+// Tasks per worker deque before submits overflow to the injection queue; a power of two
+#ifndef FASTCOND_POOL_DEQUE_SIZE
+#define FASTCOND_POOL_DEQUE_SIZE 1024
+#endif
+
+typedef struct _fastcond_task_t {
+    void (*fn)(void *arg);
+    void *arg;
+    volatile int state;            // pending, pending with a blocked waiter, or done
+    struct _fastcond_task_t *next; // in the injection queue
+} fastcond_task_t;
+
+struct _fastcond_pool_worker;
+
+typedef struct _fastcond_pool_t {
+    struct _fastcond_pool_worker *workers;
+    int n_workers;
+    int spin;                 // search rounds before parking; 0 on a single CPU
+    volatile int n_searching; // workers searching, or woken to search
+    volatile int n_sleeping;  // workers parked, or about to park, on cond
+    int n_notified;           // parked workers woken to search.  Under mutex.
+    volatile int shutdown;
+    native_mutex_t mutex; // injection queue and parking
+    fastcond_cond_t cond;
+    fastcond_task_t *inject_head;
+    fastcond_task_t *inject_tail;
+    volatile int n_injected;
+    native_mutex_t done_mutex; // threads blocked in fastcond_pool_wait()
+    fastcond_cond_t done_cond;
+} fastcond_pool_t;
+
+// Returns 0, or EINVAL for a task without fn
+int fastcond_task_init(fastcond_task_t *task, void (*fn)(void *arg), void *arg);
+
+// Start n_workers workers; 0 means one per CPU.  Returns 0, EINVAL, ENOMEM, or an error from
+// fastcond_cond_init() or thread creation.
+int fastcond_pool_init(fastcond_pool_t *pool, int n_workers);
+
+// Runs every task submitted so far, then stops the workers.  No thread may submit meanwhile.
+int fastcond_pool_fini(fastcond_pool_t *pool);
+
+// Queue an initialised task.  From a worker of this pool, the task goes to its own deque.
+int fastcond_pool_submit(fastcond_pool_t *pool, fastcond_task_t *task);
+
+// Wait until task is done.  On a worker of this pool, runs other tasks in the meantime.
+int fastcond_pool_wait(fastcond_pool_t *pool, fastcond_task_t *task);
+
+#endif /* ! defined _FASTCOND_POOL_H_ */
@@ -0,0 +1,400 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+/*
+ * LD_PRELOAD interposer for pthread_cond_*, see fastcond_preload.h.
+ *
+ * The caller's pthread_cond_t is overlaid with struct preload_slot: a tag marking it as ours
+ * and a pointer to a heap object.  Every other bit pattern is foreign, which in practice
+ * means a process-shared condition variable that pthread_cond_init() passed straight to the
+ * real implementation.  An all-zero pthread_cond_t is ours but not yet created.
+ *
+ * Real functions are found with dlsym(RTLD_NEXT) on first use.  Only glibc on Linux is
+ * supported: the mutex compatibility check reads the glibc mutex kind.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* RTLD_NEXT */
+#endif
+
+#include "fastcond_preload.h"
+#include "fastcond.h"
+#include <dlfcn.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define PRELOAD_API __attribute__((visibility("default")))
+
+#define PRELOAD_TAG 0x646e6f6374736166ULL /* "fastcond" */
+
+struct preload_cond;
+
+struct preload_slot {
+    struct preload_cond *volatile obj; /* NULL until created */
+    volatile uint64_t tag;             /* PRELOAD_TAG, stored before obj */
+};
+
+/* C99 static assert: the slot must fit in the caller's storage */
+typedef char preload_slot_fits[sizeof(struct preload_slot) <= sizeof(pthread_cond_t) ? 1 : -1];
+
+/* How a condition variable is served, decided once */
+enum { MODE_UNDECIDED, MODE_FASTCOND, MODE_REAL };
+
+struct preload_cond {
+    fastcond_mutex_t lock; /* guards cond, so signals need not hold the caller's mutex */
+    fastcond_cond_t cond;
+    volatile int mode;
+    pthread_cond_t real; /* initialised for MODE_REAL only */
+};
+
+enum { SLOT_ZERO, SLOT_OURS, SLOT_FOREIGN };
+
+/* glibc mutex kind bits that fastcond cannot stand in for: robust, priority inheritance,
+ * priority protection, process-shared (PTHREAD_MUTEX_ROBUST_NORMAL_NP, PTHREAD_MUTEX_PRIO_*
+ * and PTHREAD_MUTEX_PSHARED_BIT in nptl) */
+#define PRELOAD_MUTEX_INCOMPATIBLE (16 | 32 | 64 | 128)
+
+static struct {
+    int (*init)(pthread_cond_t *, const pthread_condattr_t *);
+    int (*destroy)(pthread_cond_t *);
+    int (*wait)(pthread_cond_t *, pthread_mutex_t *);
+    int (*timedwait)(pthread_cond_t *, pthread_mutex_t *, const struct timespec *);
+    int (*clockwait)(pthread_cond_t *, pthread_mutex_t *, clockid_t, const struct timespec *);
+    int (*signal)(pthread_cond_t *);
+    int (*broadcast)(pthread_cond_t *);
+} real;
+
+static pthread_once_t real_once = PTHREAD_ONCE_INIT;
+
+static volatile int n_fastcond;
+static volatile int n_real;
+
+/* POSIX form for storing a dlsym() result in a function pointer */
+#define RESOLVE(field, name) (*(void **) &real.field = dlsym(RTLD_NEXT, name))
+
+static void _resolve_real(void)
+{
+    RESOLVE(init, "pthread_cond_init");
+    RESOLVE(destroy, "pthread_cond_destroy");
+    RESOLVE(wait, "pthread_cond_wait");
+    RESOLVE(timedwait, "pthread_cond_timedwait");
+    RESOLVE(clockwait, "pthread_cond_clockwait"); /* glibc 2.30 and later */
+    RESOLVE(signal, "pthread_cond_signal");
+    RESOLVE(broadcast, "pthread_cond_broadcast");
+    if (!real.init || !real.destroy || !real.wait || !real.timedwait || !real.signal ||
+        !real.broadcast) {
+        fprintf(stderr, "fastcond_preload: cannot find the real pthread_cond functions\n");
+        abort();
+    }
+}
+
+static inline void _ensure_real(void)
+{
+    pthread_once(&real_once, _resolve_real);
+}
+
+static int _slot_kind(pthread_cond_t *cond)
+{
+    struct preload_slot *slot = (struct preload_slot *) cond;
+    const volatile unsigned char *p = (const volatile unsigned char *) cond;
+    size_t i;
+
+    if (__atomic_load_n(&slot->tag, __ATOMIC_ACQUIRE) == PRELOAD_TAG)
+        return SLOT_OURS;
+    for (i = 0; i < sizeof(pthread_cond_t); i++) {
+        if (p[i])
+            break;
+    }
+    if (i == sizeof(pthread_cond_t))
+        return SLOT_ZERO;
+    // A concurrent first wait may have tagged it since we looked: it stores the tag before
+    // anything else, so seeing any of its bytes means the tag is visible after a fence
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return slot->tag == PRELOAD_TAG ? SLOT_OURS : SLOT_FOREIGN;
+}
+
+static struct preload_cond *_new_cond(void)
+{
+    struct preload_cond *obj = malloc(sizeof(*obj));
+
+    if (!obj)
+        return NULL;
+    if (fastcond_mutex_init(&obj->lock, 0) != 0) {
+        free(obj);
+        return NULL;
+    }
+    if (fastcond_cond_init(&obj->cond, NULL) != 0) {
+        fastcond_mutex_fini(&obj->lock);
+        free(obj);
+        return NULL;
+    }
+    obj->mode = MODE_UNDECIDED;
+    return obj;
+}
+
+static void _free_cond(struct preload_cond *obj)
+{
+    if (obj->mode == MODE_REAL)
+        real.destroy(&obj->real);
+    fastcond_cond_fini(&obj->cond);
+    fastcond_mutex_fini(&obj->lock);
+    free(obj);
+}
+
+/* The object of an all-zero or tagged slot, created if there is none yet */
+static struct preload_cond *_get_cond(pthread_cond_t *cond)
+{
+    struct preload_slot *slot = (struct preload_slot *) cond;
+    struct preload_cond *obj = __atomic_load_n(&slot->obj, __ATOMIC_ACQUIRE);
+    struct preload_cond *expected = NULL;
+
+    if (obj)
+        return obj;
+    obj = _new_cond();
+    if (!obj)
+        return NULL;
+    __atomic_store_n(&slot->tag, PRELOAD_TAG, __ATOMIC_RELEASE);
+    if (!__atomic_compare_exchange_n(&slot->obj, &expected, obj, 0, __ATOMIC_SEQ_CST,
+                                     __ATOMIC_ACQUIRE)) {
+        _free_cond(obj); // another thread got there first
+        obj = expected;
+    }
+    return obj;
+}
+
+static inline int _get_mode(struct preload_cond *obj)
+{
+    return __atomic_load_n(&obj->mode, __ATOMIC_ACQUIRE);
+}
+
+static void _set_mode(struct preload_cond *obj, int mode)
+{
+    __atomic_add_fetch(mode == MODE_REAL ? &n_real : &n_fastcond, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&obj->mode, mode, __ATOMIC_RELEASE);
+}
+
+/* Pick the implementation at the first wait, from the mutex it uses */
+static int _decide_mode(struct preload_cond *obj, pthread_mutex_t *mutex)
+{
+    int mode = _get_mode(obj);
+
+    if (mode != MODE_UNDECIDED)
+        return mode;
+    fastcond_mutex_lock(&obj->lock);
+    mode = obj->mode;
+    if (mode == MODE_UNDECIDED) {
+        mode = MODE_FASTCOND;
+        if ((mutex->__data.__kind & PRELOAD_MUTEX_INCOMPATIBLE) &&
+            real.init(&obj->real, NULL) == 0)
+            mode = MODE_REAL;
+        _set_mode(obj, mode);
+    }
+    fastcond_mutex_unlock(&obj->lock);
+    return mode;
+}
+
+/* The internal lock is taken before the caller's mutex is released, so a signal that
+ * follows the caller's state change cannot miss this waiter */
+static int _fastcond_wait(struct preload_cond *obj, pthread_mutex_t *mutex,
+                          const struct timespec *abstime)
+{
+    int err, lock_err;
+
+    fastcond_mutex_lock(&obj->lock);
+    err = pthread_mutex_unlock(mutex);
+    if (err) {
+        fastcond_mutex_unlock(&obj->lock);
+        return err;
+    }
+    err = fastcond_cond_timedwait_fm(&obj->cond, &obj->lock, abstime);
+    fastcond_mutex_unlock(&obj->lock);
+    lock_err = pthread_mutex_lock(mutex);
+    return lock_err ? lock_err : err;
+}
+
+/* A CLOCK_MONOTONIC deadline as the CLOCK_REALTIME deadline that is as far away now */
+static void _monotonic_to_realtime(const struct timespec *abstime, struct timespec *out)
+{
+    struct timespec mono, now;
+    long long ns;
+
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    clock_gettime(CLOCK_REALTIME, &now);
+    ns = (long long) (abstime->tv_sec - mono.tv_sec) * 1000000000LL +
+         (abstime->tv_nsec - mono.tv_nsec);
+    if (ns < 0)
+        ns = 0;
+    ns += now.tv_nsec;
+    out->tv_sec = now.tv_sec + (time_t) (ns / 1000000000LL);
+    out->tv_nsec = (long) (ns % 1000000000LL);
+}
+
+enum { WAIT_PLAIN, WAIT_TIMED, WAIT_CLOCK };
+
+static int _wait(pthread_cond_t *cond, pthread_mutex_t *mutex, int how, clockid_t clock,
+                 const struct timespec *abstime)
+{
+    struct preload_cond *obj;
+    struct timespec deadline;
+
+    _ensure_real();
+    if (_slot_kind(cond) == SLOT_FOREIGN)
+        obj = NULL;
+    else if (!(obj = _get_cond(cond)))
+        return ENOMEM;
+    if (obj && _decide_mode(obj, mutex) == MODE_FASTCOND) {
+        if (how == WAIT_CLOCK && clock == CLOCK_MONOTONIC) {
+            _monotonic_to_realtime(abstime, &deadline);
+            abstime = &deadline;
+        }
+        return _fastcond_wait(obj, mutex, how == WAIT_PLAIN ? NULL : abstime);
+    }
+
+    if (obj)
+        cond = &obj->real;
+    switch (how) {
+    case WAIT_PLAIN:
+        return real.wait(cond, mutex);
+    case WAIT_TIMED:
+        return real.timedwait(cond, mutex, abstime);
+    default:
+        return real.clockwait ? real.clockwait(cond, mutex, clock, abstime) : ENOSYS;
+    }
+}
+
+PRELOAD_API int pthread_cond_init(pthread_cond_t *restrict cond,
+                                  const pthread_condattr_t *restrict attr)
+{
+    struct preload_slot *slot = (struct preload_slot *) cond;
+    struct preload_cond *obj;
+    int pshared = PTHREAD_PROCESS_PRIVATE;
+    clockid_t clock = CLOCK_REALTIME;
+    int err;
+
+    _ensure_real();
+    if (attr) {
+        pthread_condattr_getpshared(attr, &pshared);
+        pthread_condattr_getclock(attr, &clock);
+    }
+    if (pshared != PTHREAD_PROCESS_PRIVATE) {
+        // Other processes see only the caller's storage: leave it to the real thing
+        __atomic_add_fetch(&n_real, 1, __ATOMIC_RELAXED);
+        return real.init(cond, attr);
+    }
+
+    obj = _new_cond();
+    if (!obj)
+        return ENOMEM;
+    if (clock != CLOCK_REALTIME) {
+        // fastcond deadlines are CLOCK_REALTIME
+        err = real.init(&obj->real, attr);
+        if (err) {
+            _free_cond(obj);
+            return err;
+        }
+        _set_mode(obj, MODE_REAL);
+    }
+    memset(cond, 0, sizeof(*cond));
+    slot->tag = PRELOAD_TAG;
+    __atomic_store_n(&slot->obj, obj, __ATOMIC_RELEASE);
+    return 0;
+}
+
+PRELOAD_API int pthread_cond_destroy(pthread_cond_t *cond)
+{
+    struct preload_slot *slot = (struct preload_slot *) cond;
+
+    _ensure_real();
+    switch (_slot_kind(cond)) {
+    case SLOT_FOREIGN:
+        return real.destroy(cond);
+    case SLOT_OURS:
+        if (slot->obj)
+            _free_cond(slot->obj);
+        memset(cond, 0, sizeof(*cond));
+        break;
+    }
+    return 0;
+}
+
+PRELOAD_API int pthread_cond_wait(pthread_cond_t *restrict cond, pthread_mutex_t *restrict mutex)
+{
+    return _wait(cond, mutex, WAIT_PLAIN, CLOCK_REALTIME, NULL);
+}
+
+PRELOAD_API int pthread_cond_timedwait(pthread_cond_t *restrict cond,
+                                       pthread_mutex_t *restrict mutex,
+                                       const struct timespec *restrict abstime)
+{
+    return _wait(cond, mutex, WAIT_TIMED, CLOCK_REALTIME, abstime);
+}
+
+PRELOAD_API int pthread_cond_clockwait(pthread_cond_t *restrict cond,
+                                       pthread_mutex_t *restrict mutex, clockid_t clock,
+                                       const struct timespec *restrict abstime)
+{
+    if (clock != CLOCK_REALTIME && clock != CLOCK_MONOTONIC)
+        return EINVAL;
+    return _wait(cond, mutex, WAIT_CLOCK, clock, abstime);
+}
+
+/* Signal or broadcast.  No object or no decided mode means nobody has waited yet. */
+static int _wake(pthread_cond_t *cond, int all)
+{
+    struct preload_slot *slot = (struct preload_slot *) cond;
+    struct preload_cond *obj;
+
+    _ensure_real();
+    switch (_slot_kind(cond)) {
+    case SLOT_FOREIGN:
+        return all ? real.broadcast(cond) : real.signal(cond);
+    case SLOT_ZERO:
+        return 0;
+    }
+    obj = __atomic_load_n(&slot->obj, __ATOMIC_ACQUIRE);
+    if (!obj)
+        return 0;
+    switch (_get_mode(obj)) {
+    case MODE_REAL:
+        return all ? real.broadcast(&obj->real) : real.signal(&obj->real);
+    case MODE_FASTCOND:
+        fastcond_mutex_lock(&obj->lock);
+        if (all)
+            fastcond_cond_broadcast(&obj->cond);
+        else
+            fastcond_cond_signal(&obj->cond);
+        fastcond_mutex_unlock(&obj->lock);
+        break;
+    }
+    return 0;
+}
+
+PRELOAD_API int pthread_cond_signal(pthread_cond_t *cond)
+{
+    return _wake(cond, 0);
+}
+
+PRELOAD_API int pthread_cond_broadcast(pthread_cond_t *cond)
+{
+    return _wake(cond, 1);
+}
+
+PRELOAD_API void fastcond_preload_get_counts(int *n_fastcond_out, int *n_real_out)
+{
+    *n_fastcond_out = __atomic_load_n(&n_fastcond, __ATOMIC_RELAXED);
+    *n_real_out = __atomic_load_n(&n_real, __ATOMIC_RELAXED);
+}
+
+__attribute__((destructor)) static void _print_stats(void)
+{
+    const char *env = getenv("FASTCOND_PRELOAD_STATS");
+
+    if (env && *env && strcmp(env, "0") != 0)
+        fprintf(stderr, "fastcond_preload: %d condition variables on fastcond, %d on the real "
+                        "implementation\n",
+                n_fastcond, n_real);
+}
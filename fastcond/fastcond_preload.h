@@ -0,0 +1,46 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#ifndef _FASTCOND_PRELOAD_H_
+#define _FASTCOND_PRELOAD_H_
+
+/*
+ * libfastcond_preload.so: pthread_cond_* backed by fastcond, without recompiling
+ *
+ * fastcond_patch.h swaps condition variables at compile time.  The preload library does
+ * it at run time, for binaries and shared libraries that cannot be rebuilt:
+ *
+ *     LD_PRELOAD=/path/to/libfastcond_preload.so ./application
+ *
+ * It exports pthread_cond_init, _destroy, _wait, _timedwait, _clockwait, _signal and
+ * _broadcast (Linux/glibc only).  A pthread_cond_t is 48 bytes, too small for a fastcond
+ * condition variable, so the library keeps its state alongside: the caller's storage holds
+ * a tag and a pointer to a heap object with the fastcond condition variable.  An all-zero
+ * pthread_cond_t, whether from PTHREAD_COND_INITIALIZER or zero-filled memory, gets its
+ * object on first wait.
+ *
+ * Signals may come without the caller's mutex held, which plain fastcond does not allow, so
+ * each object has an internal fastcond_mutex_t that guards the fastcond bookkeeping; a
+ * waiter takes it before letting go of the caller's mutex.
+ *
+ * Falls back to the real glibc implementation for:
+ *   - process-shared condition variables (the caller's storage is used as is)
+ *   - CLOCK_MONOTONIC condition variables (pthread_condattr_setclock)
+ *   - condition variables first waited on with a robust, priority-inheriting,
+ *     priority-protected or process-shared mutex; the choice is made once per
+ *     condition variable
+ * Real-implementation conds are still kept in the heap object, so they work as usual.
+ *
+ * Limitations: fastcond waits are not cancellation points.  pthread_cond_clockwait() with
+ * CLOCK_MONOTONIC on a fastcond-backed condition variable converts its deadline to
+ * CLOCK_REALTIME at the time of the call.  A pthread_cond_t that is zero-filled again
+ * without pthread_cond_destroy() leaks its object.
+ *
+ * FASTCOND_PRELOAD_STATS=1 in the environment prints how many condition variables each
+ * implementation served to stderr at exit.  A program can read the same counts with
+ * fastcond_preload_get_counts(), looked up with dlsym() so that it runs without the library.
+ */
+
+/* Condition variables created so far that use fastcond and the real implementation */
+void fastcond_preload_get_counts(int *n_fastcond, int *n_real);
+
+#endif /* ! defined _FASTCOND_PRELOAD_H_ */
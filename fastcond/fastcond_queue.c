@@ -0,0 +1,309 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#include "fastcond_queue.h"
+#include <errno.h>
+#include <stdlib.h>
+
+// Wait on cond, counted in *n_waiting so that the other side knows to signal.
+// Caller holds queue->mutex.
+static int _queue_wait(fastcond_queue_t *queue, fastcond_cond_t *cond, int *n_waiting,
+                       const struct timespec *abstime)
+{
+    int err;
+
+    (*n_waiting)++;
+    if (abstime)
+        err = fastcond_cond_timedwait(cond, &queue->mutex, abstime);
+    else
+        err = fastcond_cond_wait(cond, &queue->mutex);
+    (*n_waiting)--;
+    if (cond == &queue->not_empty)
+        queue->n_pop_wakeups++;
+    return err;
+}
+
+// Wake as many of the n_waiting threads on cond as n items (or slots) can satisfy.
+// Caller holds queue->mutex.
+static void _queue_wake(fastcond_cond_t *cond, int n_waiting, int n)
+{
+    if (n_waiting == 0)
+        return;
+    if (n >= n_waiting) {
+        fastcond_cond_broadcast(cond);
+        return;
+    }
+    while (n-- > 0)
+        fastcond_cond_signal(cond);
+}
+
+// Append up to n items, as many as there is room for.  Returns the number appended.  No
+// consumer is woken while one is active (see fastcond_queue_drain()).
+// Caller holds queue->mutex.
+static int _queue_put(fastcond_queue_t *queue, void *const *items, int n)
+{
+    int tail = queue->head + queue->count;
+    int i;
+
+    if (n > queue->capacity - queue->count)
+        n = queue->capacity - queue->count;
+    if (tail >= queue->capacity)
+        tail -= queue->capacity;
+    for (i = 0; i < n; i++) {
+        queue->items[tail] = items[i];
+        if (++tail == queue->capacity)
+            tail = 0;
+    }
+    queue->count += n;
+    queue->n_pushed += n;
+    if (queue->n_active == 0)
+        _queue_wake(&queue->not_empty, queue->n_pop_waiting, n);
+    return n;
+}
+
+// Remove up to n items from the front.  Returns the number removed.
+// Caller holds queue->mutex.
+static int _queue_take(fastcond_queue_t *queue, void **items, int n)
+{
+    int head = queue->head;
+    int i;
+
+    if (n > queue->count)
+        n = queue->count;
+    for (i = 0; i < n; i++) {
+        items[i] = queue->items[head];
+        if (++head == queue->capacity)
+            head = 0;
+    }
+    queue->head = head;
+    queue->count -= n;
+    queue->n_popped += n;
+    _queue_wake(&queue->not_full, queue->n_push_waiting, n);
+    return n;
+}
+
+// Push one item.  block: wait for room, until abstime if given; otherwise EAGAIN.
+static int _queue_push(fastcond_queue_t *queue, void *item, int block,
+                       const struct timespec *abstime)
+{
+    int err = 0;
+
+    NATIVE_MUTEX_LOCK(&queue->mutex);
+    while (!queue->closed && queue->count == queue->capacity) {
+        if (!block) {
+            err = EAGAIN;
+            break;
+        }
+        err = _queue_wait(queue, &queue->not_full, &queue->n_push_waiting, abstime);
+        if (err && !queue->closed && queue->count == queue->capacity)
+            break; // timed out (or bad abstime) with the queue still full
+        err = 0;
+    }
+    if (queue->closed)
+        err = EPIPE;
+    else if (!err)
+        _queue_put(queue, &item, 1);
+    NATIVE_MUTEX_UNLOCK(&queue->mutex);
+    return err;
+}
+
+// Pop one item, as _queue_push()
+static int _queue_pop(fastcond_queue_t *queue, void **item, int block,
+                      const struct timespec *abstime)
+{
+    int err = 0;
+
+    NATIVE_MUTEX_LOCK(&queue->mutex);
+    while (!queue->closed && queue->count == 0) {
+        if (!block) {
+            err = EAGAIN;
+            break;
+        }
+        err = _queue_wait(queue, &queue->not_empty, &queue->n_pop_waiting, abstime);
+        if (err && !queue->closed && queue->count == 0)
+            break;
+        err = 0;
+    }
+    if (queue->count > 0)
+        _queue_take(queue, item, 1); // a closed queue is drained first
+    else if (queue->closed)
+        err = EPIPE;
+    NATIVE_MUTEX_UNLOCK(&queue->mutex);
+    return err;
+}
+
+int fastcond_queue_init(fastcond_queue_t *queue, int capacity)
+{
+    int err;
+
+    if (capacity < 1)
+        return EINVAL;
+    queue->items = malloc(sizeof(void *) * (size_t) capacity);
+    if (!queue->items)
+        return ENOMEM;
+    err = fastcond_cond_init(&queue->not_empty, NULL);
+    if (err)
+        goto fail_items;
+    err = fastcond_cond_init(&queue->not_full, NULL);
+    if (err)
+        goto fail_not_empty;
+    NATIVE_MUTEX_INIT(&queue->mutex);
+    queue->capacity = capacity;
+    queue->head = 0;
+    queue->count = 0;
+    queue->n_pop_waiting = 0;
+    queue->n_push_waiting = 0;
+    queue->n_active = 0;
+    queue->closed = 0;
+    queue->n_pushed = 0;
+    queue->n_popped = 0;
+    queue->n_pop_wakeups = 0;
+    return 0;
+
+fail_not_empty:
+    fastcond_cond_fini(&queue->not_empty);
+fail_items:
+    free(queue->items);
+    return err;
+}
+
+int fastcond_queue_fini(fastcond_queue_t *queue)
+{
+    fastcond_cond_fini(&queue->not_full);
+    fastcond_cond_fini(&queue->not_empty);
+    NATIVE_MUTEX_DESTROY(&queue->mutex);
+    free(queue->items);
+    queue->items = NULL;
+    return 0;
+}
+
+int fastcond_queue_push(fastcond_queue_t *queue, void *item)
+{
+    return _queue_push(queue, item, 1, NULL);
+}
+
+int fastcond_queue_timedpush(fastcond_queue_t *queue, void *item, const struct timespec *abstime)
+{
+    return _queue_push(queue, item, 1, abstime);
+}
+
+int fastcond_queue_trypush(fastcond_queue_t *queue, void *item)
+{
+    return _queue_push(queue, item, 0, NULL);
+}
+
+int fastcond_queue_pop(fastcond_queue_t *queue, void **item)
+{
+    return _queue_pop(queue, item, 1, NULL);
+}
+
+int fastcond_queue_timedpop(fastcond_queue_t *queue, void **item, const struct timespec *abstime)
+{
+    return _queue_pop(queue, item, 1, abstime);
+}
+
+int fastcond_queue_trypop(fastcond_queue_t *queue, void **item)
+{
+    return _queue_pop(queue, item, 0, NULL);
+}
+
+int fastcond_queue_push_n(fastcond_queue_t *queue, void *const *items, int n)
+{
+    int done = 0;
+
+    NATIVE_MUTEX_LOCK(&queue->mutex);
+    while (done < n && !queue->closed) {
+        if (queue->count == queue->capacity)
+            _queue_wait(queue, &queue->not_full, &queue->n_push_waiting, NULL);
+        else
+            done += _queue_put(queue, items + done, n - done);
+    }
+    NATIVE_MUTEX_UNLOCK(&queue->mutex);
+    return done;
+}
+
+int fastcond_queue_pop_n(fastcond_queue_t *queue, void **items, int n)
+{
+    int got;
+
+    if (n <= 0)
+        return 0;
+    NATIVE_MUTEX_LOCK(&queue->mutex);
+    while (queue->count == 0 && !queue->closed)
+        _queue_wait(queue, &queue->not_empty, &queue->n_pop_waiting, NULL);
+    got = _queue_take(queue, items, n);
+    NATIVE_MUTEX_UNLOCK(&queue->mutex);
+    return got;
+}
+
+int fastcond_queue_drain(fastcond_queue_t *queue, void **items, int n, int *active)
+{
+    int got = 0;
+
+    NATIVE_MUTEX_LOCK(&queue->mutex);
+    // No wakeups for items pushed while we were away: we are about to take them ourselves
+    if (*active) {
+        *active = 0;
+        queue->n_active--;
+    }
+    if (n > 0) {
+        while (queue->count == 0 && !queue->closed)
+            _queue_wait(queue, &queue->not_empty, &queue->n_pop_waiting, NULL);
+        got = _queue_take(queue, items, n);
+    }
+    if (got > 0) {
+        *active = 1;
+        queue->n_active++;
+        // A backlog: get another consumer going.  It spreads the work further if need be.
+        if (queue->count > 0 && queue->n_pop_waiting > 0)
+            fastcond_cond_signal(&queue->not_empty);
+    } else if (queue->n_active == 0 && queue->count > 0) {
+        _queue_wake(&queue->not_empty, queue->n_pop_waiting, queue->count);
+    }
+    NATIVE_MUTEX_UNLOCK(&queue->mutex);
+    return got;
+}
+
+int fastcond_queue_drain_end(fastcond_queue_t *queue, int *active)
+{
+    NATIVE_MUTEX_LOCK(&queue->mutex);
+    if (*active) {
+        *active = 0;
+        // The last one out owes sleepers the wakeups that producers skipped
+        if (--queue->n_active == 0 && queue->count > 0)
+            _queue_wake(&queue->not_empty, queue->n_pop_waiting, queue->count);
+    }
+    NATIVE_MUTEX_UNLOCK(&queue->mutex);
+    return 0;
+}
+
+int fastcond_queue_close(fastcond_queue_t *queue)
+{
+    NATIVE_MUTEX_LOCK(&queue->mutex);
+    queue->closed = 1;
+    if (queue->n_pop_waiting)
+        fastcond_cond_broadcast(&queue->not_empty);
+    if (queue->n_push_waiting)
+        fastcond_cond_broadcast(&queue->not_full);
+    NATIVE_MUTEX_UNLOCK(&queue->mutex);
+    return 0;
+}
+
+int fastcond_queue_size(fastcond_queue_t *queue)
+{
+    int count;
+
+    NATIVE_MUTEX_LOCK(&queue->mutex);
+    count = queue->count;
+    NATIVE_MUTEX_UNLOCK(&queue->mutex);
+    return count;
+}
+
+int fastcond_queue_get_stats(fastcond_queue_t *queue, struct fastcond_queue_stats *stats)
+{
+    NATIVE_MUTEX_LOCK(&queue->mutex);
+    stats->pushed = queue->n_pushed;
+    stats->popped = queue->n_popped;
+    stats->pop_wakeups = queue->n_pop_wakeups;
+    NATIVE_MUTEX_UNLOCK(&queue->mutex);
+    return 0;
+}
@@ -0,0 +1,103 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#ifndef _FASTCOND_QUEUE_H_
+#define _FASTCOND_QUEUE_H_
+
+#include "fastcond.h"
+#include "native_primitives.h"
+
+// A bounded multi-producer, multi-consumer FIFO of void pointers.
+//
+// The queue of test/qtest.c as a library type: a ring buffer under one mutex with
+// not_empty and not_full condition variables.  Producers and consumers count themselves
+// while they wait, so a push signals only when a consumer is blocked and a pop only when a
+// producer is, and an uncontended queue makes no semaphore calls at all.
+//
+// push_n() and pop_n() move many items per lock acquisition, and wake no more waiters than
+// the items moved can satisfy.
+//
+// fastcond_queue_drain() is pop_n() for consumer loops, with wakeups coalesced.  A consumer
+// that got a batch from it stays ACTIVE until its next drain() or drain_end(), and while any
+// consumer is active a push does not signal: an active consumer comes back for the new items
+// anyway.  To keep other consumers busy under a backlog, a drain() that leaves items behind
+// wakes one sleeping consumer, and the last active consumer to leave wakes sleepers for
+// whatever is still queued.  Wakeups per item then fall from about one to about one per
+// batch.  Counters for measuring that are in fastcond_queue_get_stats().
+//
+// After fastcond_queue_close() pushes fail with EPIPE and pops drain what is left, then
+// fail with EPIPE too; blocked threads are woken.  Deadlines are absolute CLOCK_REALTIME
+// times, as for fastcond_cond_timedwait().
+
+typedef struct _fastcond_queue_t {
+    native_mutex_t mutex;
+    fastcond_cond_t not_empty;
+    fastcond_cond_t not_full;
+    void **items;
+    int capacity;
+    int head;           // index of the oldest item
+    int count;          // items in the queue
+    int n_pop_waiting;  // consumers blocked on not_empty
+    int n_push_waiting; // producers blocked on not_full
+    int n_active;       // consumers between fastcond_queue_drain() calls
+    int closed;
+    long long n_pushed;
+    long long n_popped;
+    long long n_pop_wakeups;
+} fastcond_queue_t;
+
+struct fastcond_queue_stats {
+    long long pushed;
+    long long popped;
+    long long pop_wakeups; // consumer returns from waiting, including ones that found nothing
+};
+
+// Returns 0, EINVAL for a capacity below 1, or ENOMEM
+int fastcond_queue_init(fastcond_queue_t *queue, int capacity);
+
+// No thread may be using the queue.  Items still in it are dropped.
+int fastcond_queue_fini(fastcond_queue_t *queue);
+
+// Returns 0, or EPIPE once the queue is closed
+int fastcond_queue_push(fastcond_queue_t *queue, void *item);
+
+// Returns 0, EPIPE, or ETIMEDOUT if the queue stayed full until abstime
+int fastcond_queue_timedpush(fastcond_queue_t *queue, void *item, const struct timespec *abstime);
+
+// Returns 0, EPIPE, or EAGAIN if the queue is full
+int fastcond_queue_trypush(fastcond_queue_t *queue, void *item);
+
+// Returns 0, or EPIPE once the queue is closed and empty
+int fastcond_queue_pop(fastcond_queue_t *queue, void **item);
+
+// Returns 0, EPIPE, or ETIMEDOUT if the queue stayed empty until abstime
+int fastcond_queue_timedpop(fastcond_queue_t *queue, void **item, const struct timespec *abstime);
+
+// Returns 0, EPIPE, or EAGAIN if the queue is empty
+int fastcond_queue_trypop(fastcond_queue_t *queue, void **item);
+
+// Push all n items in order, as many at a time as there is room for, waiting while the
+// queue is full.  Returns the number pushed: n, or fewer if the queue was closed.
+int fastcond_queue_push_n(fastcond_queue_t *queue, void *const *items, int n);
+
+// Wait for at least one item, then take up to n.  Returns the number taken, or 0 once the
+// queue is closed and empty.
+int fastcond_queue_pop_n(fastcond_queue_t *queue, void **items, int n);
+
+// Wait for at least one item, then take up to n, and become an active consumer.  *active
+// is the caller's own flag, 0 before its first call; pass it back unchanged.  Returns the
+// number taken, or 0 once the queue is closed and empty, when the caller is no longer active.
+int fastcond_queue_drain(fastcond_queue_t *queue, void **items, int n, int *active);
+
+// Stop being an active consumer, for a consumer that leaves its drain() loop early
+int fastcond_queue_drain_end(fastcond_queue_t *queue, int *active);
+
+// Refuse further pushes and wake every blocked thread
+int fastcond_queue_close(fastcond_queue_t *queue);
+
+// Items in the queue right now; only a hint while other threads use it
+int fastcond_queue_size(fastcond_queue_t *queue);
+
+// Counters since fastcond_queue_init()
+int fastcond_queue_get_stats(fastcond_queue_t *queue, struct fastcond_queue_stats *stats);
+
+#endif /* ! defined _FASTCOND_QUEUE_H_ */
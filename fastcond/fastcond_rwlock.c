@@ -0,0 +1,132 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#include "fastcond_rwlock.h"
+#include <errno.h>
+
+#define RWLOCK_WRITER 0x40000000
+
+/* A blocked thread registers in n_readers_waiting or n_writers_waiting, under the mutex,
+ * before trying the lock word again, and a releasing thread changes the lock word before
+ * looking at those counts.  All of them are read-modify-write operations, so either the
+ * blocked thread gets the lock, or the releaser sees it registered and takes the mutex,
+ * which the blocked thread holds until it is asleep, to wake it.  This is the semaphore
+ * handshake of fastcond_sync.c.
+ */
+
+// Add a reader if no writer holds the lock and, preferring writers, none is waiting
+static int _rwlock_tryread(fastcond_rwlock_t *rwlock)
+{
+    int s = native_atomic_load(&rwlock->state);
+
+    while (!(s & RWLOCK_WRITER)) {
+        if (rwlock->prefer == FASTCOND_RWLOCK_PREFER_WRITER &&
+            native_atomic_load(&rwlock->n_writers_waiting) > 0)
+            break;
+        if (native_atomic_cas(&rwlock->state, s, s + 1))
+            return 1;
+        s = native_atomic_load(&rwlock->state);
+    }
+    return 0;
+}
+
+static int _rwlock_trywrite(fastcond_rwlock_t *rwlock)
+{
+    return native_atomic_cas(&rwlock->state, 0, RWLOCK_WRITER);
+}
+
+int fastcond_rwlock_init(fastcond_rwlock_t *rwlock, int prefer)
+{
+    int err;
+
+    if (prefer != FASTCOND_RWLOCK_PREFER_WRITER && prefer != FASTCOND_RWLOCK_PREFER_READER)
+        return EINVAL;
+    err = fastcond_cond_init(&rwlock->readers, NULL);
+    if (err)
+        return err;
+    err = fastcond_cond_init(&rwlock->writers, NULL);
+    if (err) {
+        fastcond_cond_fini(&rwlock->readers);
+        return err;
+    }
+    NATIVE_MUTEX_INIT(&rwlock->mutex);
+    rwlock->state = 0;
+    rwlock->n_writers_waiting = 0;
+    rwlock->n_readers_waiting = 0;
+    rwlock->prefer = prefer;
+    return 0;
+}
+
+int fastcond_rwlock_fini(fastcond_rwlock_t *rwlock)
+{
+    fastcond_cond_fini(&rwlock->writers);
+    fastcond_cond_fini(&rwlock->readers);
+    NATIVE_MUTEX_DESTROY(&rwlock->mutex);
+    return 0;
+}
+
+int fastcond_rwlock_rdlock(fastcond_rwlock_t *rwlock)
+{
+    if (_rwlock_tryread(rwlock))
+        return 0;
+    NATIVE_MUTEX_LOCK(&rwlock->mutex);
+    native_atomic_add(&rwlock->n_readers_waiting, 1);
+    while (!_rwlock_tryread(rwlock))
+        fastcond_cond_wait(&rwlock->readers, &rwlock->mutex);
+    native_atomic_add(&rwlock->n_readers_waiting, -1);
+    NATIVE_MUTEX_UNLOCK(&rwlock->mutex);
+    return 0;
+}
+
+int fastcond_rwlock_tryrdlock(fastcond_rwlock_t *rwlock)
+{
+    return _rwlock_tryread(rwlock) ? 0 : EBUSY;
+}
+
+int fastcond_rwlock_wrlock(fastcond_rwlock_t *rwlock)
+{
+    if (_rwlock_trywrite(rwlock))
+        return 0;
+    NATIVE_MUTEX_LOCK(&rwlock->mutex);
+    // From here on, preferring writers, new readers stay out
+    native_atomic_add(&rwlock->n_writers_waiting, 1);
+    while (!_rwlock_trywrite(rwlock))
+        fastcond_cond_wait(&rwlock->writers, &rwlock->mutex);
+    native_atomic_add(&rwlock->n_writers_waiting, -1);
+    NATIVE_MUTEX_UNLOCK(&rwlock->mutex);
+    return 0;
+}
+
+int fastcond_rwlock_trywrlock(fastcond_rwlock_t *rwlock)
+{
+    return _rwlock_trywrite(rwlock) ? 0 : EBUSY;
+}
+
+int fastcond_rwlock_unlock(fastcond_rwlock_t *rwlock)
+{
+    int writers, readers;
+
+    if (native_atomic_load(&rwlock->state) & RWLOCK_WRITER) {
+        native_atomic_add(&rwlock->state, -RWLOCK_WRITER);
+        writers = native_atomic_add(&rwlock->n_writers_waiting, 0);
+        readers = native_atomic_add(&rwlock->n_readers_waiting, 0);
+        if (!writers && !readers)
+            return 0;
+        NATIVE_MUTEX_LOCK(&rwlock->mutex);
+        // Preferring writers, a waiting writer goes next and the readers wait for its unlock
+        if (readers && !(writers && rwlock->prefer == FASTCOND_RWLOCK_PREFER_WRITER))
+            fastcond_cond_broadcast(&rwlock->readers);
+        if (writers)
+            fastcond_cond_signal(&rwlock->writers);
+        NATIVE_MUTEX_UNLOCK(&rwlock->mutex);
+        return 0;
+    }
+
+    // Only the last reader out can let a writer in
+    if (native_atomic_add(&rwlock->state, -1) == 0 &&
+        native_atomic_add(&rwlock->n_writers_waiting, 0) > 0) {
+        NATIVE_MUTEX_LOCK(&rwlock->mutex);
+        fastcond_cond_signal(&rwlock->writers);
+        NATIVE_MUTEX_UNLOCK(&rwlock->mutex);
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#ifndef _FASTCOND_RWLOCK_H_
+#define _FASTCOND_RWLOCK_H_
+
+#include "fastcond.h"
+#include "native_primitives.h"
+
+// A reader-writer lock on fastcond condition variables.
+//
+// The lock word holds the number of readers and a writer bit.  A reader takes the lock with
+// one compare-and-swap on it, and releases it with one atomic decrement, with no mutex
+// involved while no writer holds or wants the lock.  Threads that must block do so on a
+// native mutex and one of two fastcond_cond_t, readers and writers apart, and register
+// themselves first so that a releasing thread touches the mutex only when someone sleeps.
+//
+// With FASTCOND_RWLOCK_PREFER_WRITER (the default) a waiting writer holds off new readers, so
+// a steady stream of readers cannot starve updates; a thread must then not take a read lock
+// it already holds, as a writer queued in between deadlocks it.  With
+// FASTCOND_RWLOCK_PREFER_READER new readers always enter while readers hold the lock.
+
+#define FASTCOND_RWLOCK_PREFER_WRITER 0
+#define FASTCOND_RWLOCK_PREFER_READER 1
+
+typedef struct _fastcond_rwlock_t {
+    volatile int state;             // readers holding the lock, plus the writer bit
+    volatile int n_writers_waiting; // writers in the slow path of a write lock
+    volatile int n_readers_waiting; // readers in the slow path of a read lock
+    int prefer;
+    native_mutex_t mutex;
+    fastcond_cond_t readers;
+    fastcond_cond_t writers;
+} fastcond_rwlock_t;
+
+// Returns 0, EINVAL for an unknown preference, or an error from fastcond_cond_init()
+int fastcond_rwlock_init(fastcond_rwlock_t *rwlock, int prefer);
+int fastcond_rwlock_fini(fastcond_rwlock_t *rwlock);
+int fastcond_rwlock_rdlock(fastcond_rwlock_t *rwlock);
+// Returns 0, or EBUSY if a writer holds the lock or, preferring writers, waits for it
+int fastcond_rwlock_tryrdlock(fastcond_rwlock_t *rwlock);
+int fastcond_rwlock_wrlock(fastcond_rwlock_t *rwlock);
+// Returns 0, or EBUSY if the lock is held
+int fastcond_rwlock_trywrlock(fastcond_rwlock_t *rwlock);
+// Releases a read or a write lock held by the caller
+int fastcond_rwlock_unlock(fastcond_rwlock_t *rwlock);
+
+#endif /* ! defined _FASTCOND_RWLOCK_H_ */
@@ -0,0 +1,224 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#include "fastcond_sync.h"
+#include <errno.h>
+
+// Spin rounds before a barrier waiter sleeps, on multi-core machines
+#ifndef FASTCOND_BARRIER_SPIN
+#define FASTCOND_BARRIER_SPIN 200
+#endif
+
+/* Semaphore
+ *
+ * A waiter that finds the count at zero registers in n_waiting, under the mutex, before
+ * looking at the count again, and a poster increments the count before looking at
+ * n_waiting.  Both use read-modify-write operations, which are sequentially consistent, so
+ * at least one of them sees the other: either the waiter finds the count, or the poster
+ * takes the mutex, which the waiter holds until it is asleep, and signals.
+ */
+
+// Take one from the count if it is above zero
+static int _sem_take(fastcond_sem_t *sem)
+{
+    int c = native_atomic_add(&sem->count, 0);
+
+    while (c > 0) {
+        if (native_atomic_cas(&sem->count, c, c - 1))
+            return 1;
+        c = native_atomic_load(&sem->count);
+    }
+    return 0;
+}
+
+static int _sem_wait(fastcond_sem_t *sem, const struct timespec *abstime)
+{
+    int took, err = 0;
+
+    if (_sem_take(sem))
+        return 0;
+    NATIVE_MUTEX_LOCK(&sem->mutex);
+    native_atomic_add(&sem->n_waiting, 1);
+    // After a timeout, one last look at the count
+    while (!(took = _sem_take(sem)) && !err) {
+        if (abstime)
+            err = fastcond_cond_timedwait(&sem->cond, &sem->mutex, abstime);
+        else
+            err = fastcond_cond_wait(&sem->cond, &sem->mutex);
+    }
+    native_atomic_add(&sem->n_waiting, -1);
+    NATIVE_MUTEX_UNLOCK(&sem->mutex);
+    return took ? 0 : err;
+}
+
+int fastcond_sem_init(fastcond_sem_t *sem, int value)
+{
+    int err;
+
+    if (value < 0)
+        return EINVAL;
+    err = fastcond_cond_init(&sem->cond, NULL);
+    if (err)
+        return err;
+    NATIVE_MUTEX_INIT(&sem->mutex);
+    sem->count = value;
+    sem->n_waiting = 0;
+    return 0;
+}
+
+int fastcond_sem_fini(fastcond_sem_t *sem)
+{
+    fastcond_cond_fini(&sem->cond);
+    NATIVE_MUTEX_DESTROY(&sem->mutex);
+    return 0;
+}
+
+int fastcond_sem_wait(fastcond_sem_t *sem)
+{
+    return _sem_wait(sem, NULL);
+}
+
+int fastcond_sem_timedwait(fastcond_sem_t *sem, const struct timespec *abstime)
+{
+    return _sem_wait(sem, abstime);
+}
+
+int fastcond_sem_trywait(fastcond_sem_t *sem)
+{
+    return _sem_take(sem) ? 0 : EAGAIN;
+}
+
+int fastcond_sem_post(fastcond_sem_t *sem)
+{
+    native_atomic_add(&sem->count, 1);
+    if (native_atomic_add(&sem->n_waiting, 0) > 0) {
+        NATIVE_MUTEX_LOCK(&sem->mutex);
+        fastcond_cond_signal(&sem->cond);
+        NATIVE_MUTEX_UNLOCK(&sem->mutex);
+    }
+    return 0;
+}
+
+int fastcond_sem_getvalue(fastcond_sem_t *sem)
+{
+    return native_atomic_load(&sem->count);
+}
+
+/* Barrier
+ *
+ * A waiter reads the phase before its decrement; the phase cannot move on until every
+ * thread, itself included, has decremented.  The last arriver restores the count before it
+ * publishes the new phase, so a thread racing ahead into the next phase decrements a fresh
+ * count.  The phase changes under the mutex, so a waiter that checked it under the mutex and
+ * went to sleep is always woken.
+ */
+
+int fastcond_barrier_init(fastcond_barrier_t *barrier, int count)
+{
+    int err;
+
+    if (count < 1)
+        return EINVAL;
+    err = fastcond_cond_init(&barrier->cond, NULL);
+    if (err)
+        return err;
+    NATIVE_MUTEX_INIT(&barrier->mutex);
+    barrier->remaining = count;
+    barrier->phase = 0;
+    barrier->count = count;
+    barrier->spin = native_cpu_count() > 1 ? FASTCOND_BARRIER_SPIN : 0;
+    barrier->n_sleeping = 0;
+    return 0;
+}
+
+int fastcond_barrier_fini(fastcond_barrier_t *barrier)
+{
+    fastcond_cond_fini(&barrier->cond);
+    NATIVE_MUTEX_DESTROY(&barrier->mutex);
+    return 0;
+}
+
+int fastcond_barrier_wait(fastcond_barrier_t *barrier)
+{
+    int phase = native_atomic_load(&barrier->phase);
+    int i;
+
+    if (native_atomic_add(&barrier->remaining, -1) == 0) {
+        native_atomic_store(&barrier->remaining, barrier->count);
+        NATIVE_MUTEX_LOCK(&barrier->mutex);
+        native_atomic_store(&barrier->phase, (int) ((unsigned) phase + 1)); // may wrap
+        if (barrier->n_sleeping)
+            fastcond_cond_broadcast(&barrier->cond);
+        NATIVE_MUTEX_UNLOCK(&barrier->mutex);
+        return FASTCOND_BARRIER_SERIAL_THREAD;
+    }
+
+    for (i = 0; i < barrier->spin; i++) {
+        if (native_atomic_load(&barrier->phase) != phase)
+            return 0;
+        NATIVE_CPU_RELAX();
+    }
+    NATIVE_MUTEX_LOCK(&barrier->mutex);
+    barrier->n_sleeping++;
+    while (native_atomic_load(&barrier->phase) == phase)
+        fastcond_cond_wait(&barrier->cond, &barrier->mutex);
+    barrier->n_sleeping--;
+    NATIVE_MUTEX_UNLOCK(&barrier->mutex);
+    return 0;
+}
+
+/* Latch */
+
+int fastcond_latch_init(fastcond_latch_t *latch, int count)
+{
+    int err;
+
+    if (count < 0)
+        return EINVAL;
+    err = fastcond_cond_init(&latch->cond, NULL);
+    if (err)
+        return err;
+    NATIVE_MUTEX_INIT(&latch->mutex);
+    latch->count = count;
+    return 0;
+}
+
+int fastcond_latch_fini(fastcond_latch_t *latch)
+{
+    fastcond_cond_fini(&latch->cond);
+    NATIVE_MUTEX_DESTROY(&latch->mutex);
+    return 0;
+}
+
+int fastcond_latch_count_down(fastcond_latch_t *latch, int n)
+{
+    if (n <= 0 || native_atomic_add(&latch->count, -n) != 0)
+        return 0;
+    // Reached zero.  Waiters test the count under the mutex, so taking it here means none
+    // is between its test and its wait.
+    NATIVE_MUTEX_LOCK(&latch->mutex);
+    fastcond_cond_broadcast(&latch->cond);
+    NATIVE_MUTEX_UNLOCK(&latch->mutex);
+    return 0;
+}
+
+int fastcond_latch_wait(fastcond_latch_t *latch)
+{
+    if (native_atomic_load(&latch->count) == 0)
+        return 0;
+    NATIVE_MUTEX_LOCK(&latch->mutex);
+    while (native_atomic_load(&latch->count) != 0)
+        fastcond_cond_wait(&latch->cond, &latch->mutex);
+    NATIVE_MUTEX_UNLOCK(&latch->mutex);
+    return 0;
+}
+
+int fastcond_latch_try_wait(fastcond_latch_t *latch)
+{
+    return native_atomic_load(&latch->count) == 0 ? 0 : EAGAIN;
+}
+
+int fastcond_latch_arrive_and_wait(fastcond_latch_t *latch, int n)
+{
+    fastcond_latch_count_down(latch, n);
+    return fastcond_latch_wait(latch);
+}
@@ -0,0 +1,81 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#ifndef _FASTCOND_SYNC_H_
+#define _FASTCOND_SYNC_H_
+
+#include "fastcond.h"
+#include "native_primitives.h"
+
+// Counting semaphore, barrier and latch on fastcond condition variables.
+//
+// Each is a native mutex and a fastcond_cond_t around an atomic counter.  The common path
+// touches only the counter: a semaphore post with nobody waiting, a wait with the count
+// above zero, a barrier arrival that is not the last and a latch count-down that does not
+// reach zero are each one atomic operation.  The mutex is taken only to sleep, and by the
+// thread that must wake sleepers, which then does so with a single signal or broadcast.
+//
+// Deadlines are absolute CLOCK_REALTIME times, as for fastcond_cond_timedwait().
+
+// A COUNTING SEMAPHORE
+typedef struct _fastcond_sem_t {
+    volatile int count;
+    volatile int n_waiting; // threads in the slow path of a wait
+    native_mutex_t mutex;
+    fastcond_cond_t cond;
+} fastcond_sem_t;
+
+// Returns 0, EINVAL for a negative value, or an error from fastcond_cond_init()
+int fastcond_sem_init(fastcond_sem_t *sem, int value);
+int fastcond_sem_fini(fastcond_sem_t *sem);
+int fastcond_sem_wait(fastcond_sem_t *sem);
+// Returns 0, or ETIMEDOUT if the count stayed at zero until abstime
+int fastcond_sem_timedwait(fastcond_sem_t *sem, const struct timespec *abstime);
+// Returns 0, or EAGAIN if the count is zero
+int fastcond_sem_trywait(fastcond_sem_t *sem);
+int fastcond_sem_post(fastcond_sem_t *sem);
+int fastcond_sem_getvalue(fastcond_sem_t *sem);
+
+// A BARRIER for a fixed number of threads, reusable phase after phase.
+//
+// Arrival is one atomic decrement.  The last thread to arrive resets the count, starts the
+// next phase and wakes the others with one broadcast, if any went to sleep.  On multi-core
+// machines waiters spin for up to FASTCOND_BARRIER_SPIN rounds before sleeping, as phases
+// are often short; on a single CPU they sleep at once.
+#define FASTCOND_BARRIER_SERIAL_THREAD (-1)
+
+typedef struct _fastcond_barrier_t {
+    volatile int remaining; // threads yet to arrive in this phase
+    volatile int phase;
+    int count;
+    int spin; // spin rounds before sleeping; 0 on a single CPU
+    int n_sleeping;
+    native_mutex_t mutex;
+    fastcond_cond_t cond;
+} fastcond_barrier_t;
+
+// Returns 0, EINVAL for a count below 1, or an error from fastcond_cond_init()
+int fastcond_barrier_init(fastcond_barrier_t *barrier, int count);
+int fastcond_barrier_fini(fastcond_barrier_t *barrier);
+// Returns FASTCOND_BARRIER_SERIAL_THREAD in the last thread to arrive, 0 in the others
+int fastcond_barrier_wait(fastcond_barrier_t *barrier);
+
+// A LATCH: a single-use countdown, as C++20 std::latch.  Waiters are released once the
+// count reaches zero, and stay released.
+typedef struct _fastcond_latch_t {
+    volatile int count;
+    native_mutex_t mutex;
+    fastcond_cond_t cond;
+} fastcond_latch_t;
+
+// Returns 0, EINVAL for a negative count, or an error from fastcond_cond_init()
+int fastcond_latch_init(fastcond_latch_t *latch, int count);
+int fastcond_latch_fini(fastcond_latch_t *latch);
+// Subtract n; the count must not go below zero
+int fastcond_latch_count_down(fastcond_latch_t *latch, int n);
+int fastcond_latch_wait(fastcond_latch_t *latch);
+// Returns 0 if the count has reached zero, otherwise EAGAIN
+int fastcond_latch_try_wait(fastcond_latch_t *latch);
+// fastcond_latch_count_down(latch, n), then fastcond_latch_wait(latch)
+int fastcond_latch_arrive_and_wait(fastcond_latch_t *latch, int n);
+
+#endif /* ! defined _FASTCOND_SYNC_H_ */
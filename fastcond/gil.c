@@ -2,12 +2,17 @@
 
 #include "gil.h"
 #include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
 
 // GIL implementation mode control
-// Three modes available for experimental comparison:
+// Four modes available for experimental comparison:
 //   NAIVE: Simple mutex acquire/release - no condition variables or fairness
 //   UNFAIR: Uses condition variables but disables fairness mechanism
 //   FAIR: Full implementation with anti-greedy fairness mechanism (default)
+//   TICKET: Strict FIFO ticket lock with per-ticket parking (FASTCOND_GIL_MODE_TICKET, gil.h)
+// FASTCOND_GIL_USE_FUTEX (gil.h) swaps the UNFAIR/FAIR implementation for a futex word.
 
 #ifndef FASTCOND_GIL_MODE_NAIVE
 #define FASTCOND_GIL_MODE_NAIVE 0
@@ -30,98 +35,962 @@
     "NAIVE mode requires unfair behavior (set FASTCOND_GIL_YIELD_FAIR=0 and FASTCOND_GIL_ACQUIRE_GREEDY=1)"
 #endif
 
-void fastcond_gil_init(struct fastcond_gil *gil)
+#if FASTCOND_GIL_MODE_NAIVE && FASTCOND_GIL_IO_BOOST
+#error "I/O boost needs the condition variable GIL, it cannot be combined with NAIVE mode"
+#endif
+
+#if FASTCOND_GIL_MODE_TICKET && (FASTCOND_GIL_MODE_NAIVE || FASTCOND_GIL_IO_BOOST)
+#error "TICKET mode is strict FIFO; it cannot be combined with NAIVE mode or I/O boost"
+#endif
+
+#if FASTCOND_GIL_MODE_NAIVE && FASTCOND_GIL_STATS
+#error "GIL statistics need the condition variable GIL, they cannot be combined with NAIVE mode"
+#endif
+
+#if FASTCOND_GIL_NUMA && (FASTCOND_GIL_MODE_NAIVE || FASTCOND_GIL_MODE_TICKET)
+#error "NUMA handoff needs the condition variable GIL, not NAIVE or TICKET mode"
+#endif
+
+#if FASTCOND_GIL_PRIO && (FASTCOND_GIL_MODE_NAIVE || FASTCOND_GIL_MODE_TICKET ||                \
+                          FASTCOND_GIL_IO_BOOST || FASTCOND_GIL_NUMA)
+#error "Priority classes need the condition variable GIL, without I/O boost or NUMA handoff"
+#endif
+
+#if FASTCOND_GIL_SPIN && (FASTCOND_GIL_MODE_NAIVE || FASTCOND_GIL_MODE_TICKET)
+#error "Spin-before-park needs the condition variable GIL, not NAIVE or TICKET mode"
+#endif
+
+#if FASTCOND_GIL_PRIO && FASTCOND_GIL_USE_FUTEX
+#error "The futex GIL backend has no priority classes"
+#endif
+
+#if FASTCOND_GIL_USE_FUTEX && !NATIVE_HAVE_FUTEX
+#error "The futex GIL backend is only available on Linux"
+#endif
+
+#if FASTCOND_GIL_USE_FUTEX &&                                                                      \
+    (FASTCOND_GIL_USE_NATIVE_COND || FASTCOND_GIL_MODE_NAIVE || FASTCOND_GIL_MODE_TICKET ||        \
+     FASTCOND_GIL_IO_BOOST || FASTCOND_GIL_NUMA || FASTCOND_GIL_SPIN || FASTCOND_GIL_STATS)
+#error "The futex GIL backend combines only with RECURSIVE mode"
+#endif
+
+#if FASTCOND_GIL_USE_FASTCOND_MUTEX && (FASTCOND_GIL_USE_NATIVE_COND || FASTCOND_GIL_USE_FUTEX)
+#error "fastcond_mutex_t needs the fastcond condition variables, not native ones or the futex GIL"
+#endif
+
+#if (FASTCOND_GIL_MUTEX_KIND == NATIVE_MUTEX_KIND_ADAPTIVE && !NATIVE_HAVE_MUTEX_ADAPTIVE) ||     \
+    (FASTCOND_GIL_MUTEX_KIND == NATIVE_MUTEX_KIND_ERRORCHECK && !NATIVE_HAVE_MUTEX_ERRORCHECK) || \
+    (FASTCOND_GIL_MUTEX_KIND == NATIVE_MUTEX_KIND_PI && !NATIVE_HAVE_MUTEX_PI)
+#error "FASTCOND_GIL_MUTEX_KIND names a mutex kind this platform does not provide"
+#endif
+
+// Modes that read the clock on entry to acquire/yield
+#define GIL_TIMING (FASTCOND_GIL_IO_BOOST || FASTCOND_GIL_STATS || FASTCOND_GIL_SPIN)
+
+// I/O boost thresholds (see gil.h)
+#ifndef FASTCOND_GIL_IO_BOOST_HOLD_US
+#define FASTCOND_GIL_IO_BOOST_HOLD_US 1000
+#endif
+#ifndef FASTCOND_GIL_IO_BOOST_RELEASE_US
+#define FASTCOND_GIL_IO_BOOST_RELEASE_US 10000
+#endif
+#ifndef FASTCOND_GIL_IO_BOOST_MAX_STREAK
+#define FASTCOND_GIL_IO_BOOST_MAX_STREAK 8
+#endif
+
+// NUMA handoff streak cap (see gil.h)
+#ifndef FASTCOND_GIL_NUMA_MAX_STREAK
+#define FASTCOND_GIL_NUMA_MAX_STREAK 4
+#endif
+
+// Priority class aging step (see gil.h)
+#ifndef FASTCOND_GIL_PRIO_AGING
+#define FASTCOND_GIL_PRIO_AGING 8
+#endif
+
+// Spin budget cap (see gil.h)
+#ifndef FASTCOND_GIL_SPIN_MAX_NS
+#define FASTCOND_GIL_SPIN_MAX_NS 10000
+#endif
+
+// Operations on the internal mutex, fastcond_gil_mutex_t
+#if FASTCOND_GIL_USE_FASTCOND_MUTEX
+#define GIL_MUTEX_INIT(mutex) fastcond_mutex_init((mutex), FASTCOND_GIL_MUTEX_FLAGS)
+#define GIL_MUTEX_DESTROY(mutex) fastcond_mutex_fini(mutex)
+#define GIL_MUTEX_LOCK(mutex) fastcond_mutex_lock(mutex)
+#define GIL_MUTEX_UNLOCK(mutex) fastcond_mutex_unlock(mutex)
+#define GIL_MUTEX_TRYLOCK(mutex) fastcond_mutex_trylock(mutex)
+#elif FASTCOND_GIL_MUTEX_KIND == NATIVE_MUTEX_KIND_ERRORCHECK
+// The GIL never relocks its mutex or unlocks it unheld; if the mutex reports that it did,
+// the GIL state is already corrupt, so stop there rather than carry on
+static inline void _gil_mutex_check(int err)
 {
-    // Always initialize condition variables (even if NAIVE mode won't use them)
+    if (err)
+        abort();
+}
+#define GIL_MUTEX_INIT(mutex)                                                                      \
+    _gil_mutex_check(native_mutex_init_kind((mutex), FASTCOND_GIL_MUTEX_KIND))
+#define GIL_MUTEX_DESTROY(mutex) _gil_mutex_check(NATIVE_MUTEX_DESTROY(mutex))
+#define GIL_MUTEX_LOCK(mutex) _gil_mutex_check(NATIVE_MUTEX_LOCK(mutex))
+#define GIL_MUTEX_UNLOCK(mutex) _gil_mutex_check(NATIVE_MUTEX_UNLOCK(mutex))
+#define GIL_MUTEX_TRYLOCK(mutex) NATIVE_MUTEX_TRYLOCK(mutex)
+#else
+// fastcond_gil_init() cannot report failure; the kind was checked at build time
+#define GIL_MUTEX_INIT(mutex) ((void) native_mutex_init_kind((mutex), FASTCOND_GIL_MUTEX_KIND))
+#define GIL_MUTEX_DESTROY(mutex) NATIVE_MUTEX_DESTROY(mutex)
+#define GIL_MUTEX_LOCK(mutex) NATIVE_MUTEX_LOCK(mutex)
+#define GIL_MUTEX_UNLOCK(mutex) NATIVE_MUTEX_UNLOCK(mutex)
+#define GIL_MUTEX_TRYLOCK(mutex) NATIVE_MUTEX_TRYLOCK(mutex)
+#endif
+
+// Backend-neutral condition variable operations on fastcond_gil_cond_t
 #if FASTCOND_GIL_USE_NATIVE_COND
-    NATIVE_COND_INIT(&gil->cond);
+#define GIL_COND_INIT(cond) NATIVE_COND_INIT(cond)
+#define GIL_COND_DESTROY(cond) NATIVE_COND_DESTROY(cond)
+#define GIL_COND_WAIT(cond, mutex) NATIVE_COND_WAIT((cond), (mutex))
+#define GIL_COND_TIMEDWAIT(cond, mutex, abstime) NATIVE_COND_TIMEDWAIT((cond), (mutex), (abstime))
+#define GIL_COND_SIGNAL(cond) NATIVE_COND_SIGNAL(cond)
+#define GIL_COND_BROADCAST(cond) NATIVE_COND_BROADCAST(cond)
+#elif FASTCOND_GIL_USE_FASTCOND_MUTEX
+#define GIL_COND_INIT(cond) fastcond_cond_init((cond), NULL)
+#define GIL_COND_DESTROY(cond) fastcond_cond_fini(cond)
+#define GIL_COND_WAIT(cond, mutex) fastcond_cond_wait_fm((cond), (mutex))
+#define GIL_COND_TIMEDWAIT(cond, mutex, abstime)                                                   \
+    fastcond_cond_timedwait_fm((cond), (mutex), (abstime))
+#define GIL_COND_SIGNAL(cond) fastcond_cond_signal(cond)
+#define GIL_COND_BROADCAST(cond) fastcond_cond_broadcast(cond)
+#else
+#define GIL_COND_INIT(cond) fastcond_cond_init((cond), NULL)
+#define GIL_COND_DESTROY(cond) fastcond_cond_fini(cond)
+#define GIL_COND_WAIT(cond, mutex) fastcond_cond_wait((cond), (mutex))
+#define GIL_COND_TIMEDWAIT(cond, mutex, abstime) fastcond_cond_timedwait((cond), (mutex), (abstime))
+#define GIL_COND_SIGNAL(cond) fastcond_cond_signal(cond)
+#define GIL_COND_BROADCAST(cond) fastcond_cond_broadcast(cond)
+#endif
+
+#if FASTCOND_GIL_IO_BOOST
+// Per-thread burst bookkeeping for I/O-bound classification.
+//
+// A "burst" is the span from fastcond_gil_acquire() to fastcond_gil_release().  Yields
+// inside a burst do not end it, which is exactly what separates the two populations: a
+// CPU-bound thread yields many times between its rare releases and so has long bursts,
+// while an I/O-bound thread does a little work and releases again almost at once.
+//
+// The state lives in the thread context rather than in the GIL.  A thread juggling several
+// GILs gets one blended history, which is good enough for a scheduling hint.
+
+// Is the calling thread, about to re-acquire, an I/O-bound thread back from a short release?
+static inline int _gil_io_boosted(const struct fastcond_gil_thread *t, long long now)
+{
+    return t->io_release_ns != 0 &&
+           now - t->io_release_ns <= FASTCOND_GIL_IO_BOOST_RELEASE_US * 1000LL &&
+           t->io_burst_avg_ns <= FASTCOND_GIL_IO_BOOST_HOLD_US * 1000LL;
+}
+
+static inline void _gil_io_note_release(struct fastcond_gil_thread *t, long long now)
+{
+    long long burst = now - t->io_burst_start_ns;
+    if (t->io_release_ns == 0)
+        t->io_burst_avg_ns = burst; // first sample seeds the average
+    else
+        t->io_burst_avg_ns += (burst - t->io_burst_avg_ns) / 4;
+    t->io_release_ns = now;
+}
+
+// Non-boosted threads must leave a free GIL to a boosted waiter, unless boosted threads have
+// already had FASTCOND_GIL_IO_BOOST_MAX_STREAK turns in a row.
+#define GIL_BOOST_RESERVED(gil, boosted)                                                           \
+    (!(boosted) && (gil)->n_boost_waiting > 0 &&                                                   \
+     (gil)->boost_streak < FASTCOND_GIL_IO_BOOST_MAX_STREAK)
+#else
+#define GIL_BOOST_RESERVED(gil, boosted) 0
+#endif
+
+#if FASTCOND_GIL_PRIO
+// Rank of waiter class cls: its level, raised one step for every FASTCOND_GIL_PRIO_AGING
+// acquisitions by other classes since one of it was last served
+static inline int _gil_prio_rank(const struct fastcond_gil *gil, int cls)
+{
+    return cls + gil->prio_passed[cls] / FASTCOND_GIL_PRIO_AGING;
+}
+
+// The class to hand a released GIL to: of those with waiters, the one of highest rank, ties
+// going to the higher level.  Returns -1 if nobody waits.  Caller holds gil->mutex.
+static int _gil_prio_pick(const struct fastcond_gil *gil)
+{
+    int pick = -1;
+    int cls;
+
+    for (cls = FASTCOND_GIL_PRIO_LEVELS - 1; cls >= 0; cls--) {
+        if (gil->prio_waiting[cls] > 0 &&
+            (pick < 0 || _gil_prio_rank(gil, cls) > _gil_prio_rank(gil, pick)))
+            pick = cls;
+    }
+    return pick;
+}
+
+// Record an acquisition by class cls: every other class with waiters was passed over.
+// Caller holds gil->mutex.
+static inline void _gil_prio_served(struct fastcond_gil *gil, int cls)
+{
+    for (int i = 0; i < FASTCOND_GIL_PRIO_LEVELS; i++) {
+        if (i != cls && gil->prio_waiting[i] > 0 &&
+            gil->prio_passed[i] < FASTCOND_GIL_PRIO_LEVELS * FASTCOND_GIL_PRIO_AGING)
+            gil->prio_passed[i]++;
+    }
+    gil->prio_passed[cls] = 0;
+    gil->prio_next = -1;
+}
+
+// Other classes must leave a free GIL to the class the last release woke, while it still
+// has waiters.  The choice is made once, at release: choosing again when the woken thread
+// runs could pick the releaser itself, held back by the fairness rule, and stall both.
+#define GIL_PRIO_RESERVED(gil, cls)                                                                \
+    ((gil)->prio_next >= 0 && (gil)->prio_next != (cls) &&                                         \
+     (gil)->prio_waiting[(gil)->prio_next] > 0)
+
+// A free GIL can still end up kept for the class of the last owner, when a timed-out waiter
+// passes its wakeup on.  Woken for it but held back by the fairness rule, the last owner
+// passes the wakeup on again.  Used after each wait; caller holds gil->mutex.
+#define GIL_PRIO_PASS_ON(gil, self, cls)                                                           \
+    do {                                                                                           \
+        if (!(gil)->held && (gil)->prio_next == (cls) &&                                           \
+            NATIVE_THREAD_EQUAL((gil)->last_owner, (self)))                                        \
+            _gil_signal(gil);                                                                      \
+    } while (0)
+#else
+#define GIL_PRIO_RESERVED(gil, cls) 0
+#define GIL_PRIO_PASS_ON(gil, self, cls) ((void) 0)
+#endif
+
+#if !FASTCOND_GIL_USE_FUTEX
+// Park the calling thread until the GIL state changes, or until abstime if not NULL.
+// cls is the waiter class: 1 for a boosted thread with I/O boost, the priority level with
+// FASTCOND_GIL_PRIO, otherwise 0.  Caller holds gil->mutex and has already counted itself
+// in n_waiting.  Returns ETIMEDOUT if the deadline passed; any other result may be a wakeup
+// or a spurious return.
+static inline int _gil_wait(struct fastcond_gil *gil, int cls, const struct timespec *abstime)
+{
+    fastcond_gil_cond_t *cond = &gil->cond;
+    volatile int *n_class = NULL; // waiter count of the class we park in, if any
+    int err;
+
+#if FASTCOND_GIL_IO_BOOST
+    if (cls) {
+        cond = &gil->boost_cond;
+        n_class = &gil->n_boost_waiting;
+    }
+#elif FASTCOND_GIL_PRIO
+    cond = &gil->prio_cond[cls];
+    n_class = &gil->prio_waiting[cls];
+#else
+    (void) cls;
+#endif
+#if FASTCOND_GIL_NUMA
+    if (!n_class) {
+        int node = native_current_node() % FASTCOND_GIL_NUMA_NODES;
+        cond = &gil->node_cond[node];
+        n_class = &gil->node_waiting[node];
+    }
+#endif
+    if (n_class)
+        (*n_class)++;
+    if (abstime)
+        err = GIL_COND_TIMEDWAIT(cond, &gil->mutex, abstime);
+    else
+        err = GIL_COND_WAIT(cond, &gil->mutex);
+    if (n_class)
+        (*n_class)--;
+    return err;
+}
+
+#if FASTCOND_GIL_NUMA
+// Wake a waiter, preferring the releasing thread's node unless it has had its streak while
+// other nodes waited; then the nearest node number above it with waiters gets a turn.
+// Caller holds gil->mutex.
+static void _gil_numa_signal(struct fastcond_gil *gil)
+{
+    int here = native_current_node() % FASTCOND_GIL_NUMA_NODES;
+    int others = 0;
+    int i, node;
+
+    for (i = 0; i < FASTCOND_GIL_NUMA_NODES; i++) {
+        if (i != here)
+            others += gil->node_waiting[i];
+    }
+    if (gil->node_waiting[here] > 0 &&
+        (others == 0 || gil->node_streak < FASTCOND_GIL_NUMA_MAX_STREAK)) {
+        gil->node_streak = others ? gil->node_streak + 1 : 0;
+        GIL_COND_SIGNAL(&gil->node_cond[here]);
+        return;
+    }
+    for (i = 1; i < FASTCOND_GIL_NUMA_NODES; i++) {
+        node = (here + i) % FASTCOND_GIL_NUMA_NODES;
+        if (gil->node_waiting[node] > 0) {
+            gil->node_streak = 0;
+            GIL_COND_SIGNAL(&gil->node_cond[node]);
+            return;
+        }
+    }
+}
+#endif
+
+// Wake one waiter, if any, to take over a GIL that is about to become free.
+// Caller holds gil->mutex.
+static inline void _gil_signal(struct fastcond_gil *gil)
+{
+#if FASTCOND_GIL_IO_BOOST
+    // Boosted waiters go first, unless they have had their streak and others are waiting
+    if (gil->n_boost_waiting > 0 && (gil->boost_streak < FASTCOND_GIL_IO_BOOST_MAX_STREAK ||
+                                     gil->n_boost_waiting == gil->n_waiting)) {
+        GIL_COND_SIGNAL(&gil->boost_cond);
+        return;
+    }
+#endif
+#if FASTCOND_GIL_NUMA
+    if (gil->n_waiting > 0)
+        _gil_numa_signal(gil);
+#elif FASTCOND_GIL_PRIO
+    gil->prio_next = _gil_prio_pick(gil);
+    if (gil->prio_next >= 0)
+        GIL_COND_SIGNAL(&gil->prio_cond[gil->prio_next]);
+#else
+    if (gil->n_waiting > 0)
+        GIL_COND_SIGNAL(&gil->cond);
+#endif
+}
+#endif
+
+#if FASTCOND_GIL_SPIN
+// Fold a completed hold into the average.  Only the owner writes hold_avg_ns; spinners read
+// it without the mutex, which is fine for a heuristic.
+static inline void _gil_spin_note_hold(struct fastcond_gil *gil, long long now)
+{
+    long long hold = now - gil->hold_start_ns;
+    if (gil->hold_avg_ns == 0)
+        gil->hold_avg_ns = hold; // first sample seeds the average
+    else
+        gil->hold_avg_ns += (hold - gil->hold_avg_ns) / 8;
+}
+
+// Watch a held GIL for up to twice the average hold time, hoping to see it released
+// before paying for a park and wake-up.  This is only a hint: the caller takes the mutex
+// and runs the normal acquire loop afterwards, whatever the outcome.
+static void _gil_spin(struct fastcond_gil *gil, long long now)
+{
+    long long avg = gil->hold_avg_ns;
+    long long deadline;
+    unsigned int i;
+
+    if (avg <= 0 || avg > FASTCOND_GIL_SPIN_MAX_NS)
+        return;
+    // The holder, every spinner and we ourselves must each have a CPU, or we would be
+    // spinning on the very CPU the holder needs to finish
+    if (native_atomic_add(&gil->n_spinning, 1) + 1 > gil->n_cpus) {
+        native_atomic_add(&gil->n_spinning, -1);
+        return;
+    }
+    deadline = now + (2 * avg < FASTCOND_GIL_SPIN_MAX_NS ? 2 * avg : FASTCOND_GIL_SPIN_MAX_NS);
+    for (i = 1; native_atomic_load(&gil->held); i++) {
+        NATIVE_CPU_RELAX();
+        // Reading the clock costs about as much as a few dozen pauses
+        if ((i & 31) == 0 && native_monotonic_ns() >= deadline)
+            break;
+    }
+    native_atomic_add(&gil->n_spinning, -1);
+}
+#endif
+
+#if FASTCOND_GIL_STATS
+static inline int _gil_log2_bucket(unsigned long long ns)
+{
+    int b = 0;
+#if defined(__GNUC__) || defined(__clang__)
+    if (ns)
+        b = 63 - __builtin_clzll(ns);
+#else
+    while (ns >>= 1)
+        b++;
+#endif
+    return b < FASTCOND_GIL_STATS_BUCKETS ? b : FASTCOND_GIL_STATS_BUCKETS - 1;
+}
+
+static void _gil_hist_add(struct fastcond_gil_histogram *h, long long ns)
+{
+    unsigned long long v = ns > 0 ? (unsigned long long) ns : 0;
+    h->count++;
+    h->sum_ns += v;
+    if (v > h->max_ns)
+        h->max_ns = v;
+    h->buckets[_gil_log2_bucket(v)]++;
+}
+
+// Account for an acquisition by self that entered acquire()/yield() at t_enter.
+// Caller holds gil->mutex and has already taken the GIL.  The per-thread table is searched
+// linearly; it is short, and the search happens under a mutex we hold anyway.
+static void _gil_stats_acquired(struct fastcond_gil *gil, native_thread_t self, long long t_enter,
+                                int waited, int handed_off)
+{
+    struct fastcond_gil_stats *st = &gil->stats;
+    long long now = native_monotonic_ns();
+    int i;
+
+    st->acquisitions++;
+    _gil_hist_add(&st->wait, now - t_enter);
+    if (waited)
+        st->contended++;
+    if (handed_off)
+        _gil_hist_add(&st->handoff, now - gil->stats_released_ns);
+    gil->stats_acquired_ns = now;
+
+    for (i = 0; i < st->n_threads; i++) {
+        if (NATIVE_THREAD_EQUAL(st->threads[i].thread, self)) {
+            st->threads[i].acquisitions++;
+            return;
+        }
+    }
+    if (st->n_threads < FASTCOND_GIL_STATS_MAX_THREADS) {
+        st->threads[st->n_threads].thread = self;
+        st->threads[st->n_threads].acquisitions = 1;
+        st->n_threads++;
+    } else {
+        st->untracked_acquisitions++;
+    }
+}
+
+// Account for the owner giving up the GIL.  Caller holds gil->mutex.
+static void _gil_stats_released(struct fastcond_gil *gil, long long now)
+{
+    _gil_hist_add(&gil->stats.hold, now - gil->stats_acquired_ns);
+    gil->stats_released_ns = now;
+}
+#endif
+
+#if FASTCOND_GIL_MODE_TICKET
+// Ticket lock.  All ticket state is protected by gil->mutex; the counters are unsigned so
+// they wrap harmlessly.  A ticket t parks on slot t % FASTCOND_GIL_TICKET_SLOTS.
+
+// Wait until ticket comes up.  Caller holds gil->mutex.  Returns nonzero if it had to wait.
+static int _gil_ticket_wait(struct fastcond_gil *gil, unsigned int ticket)
+{
+    int slot = ticket % FASTCOND_GIL_TICKET_SLOTS;
+
+    if (gil->now_serving == ticket)
+        return 0;
+    gil->n_waiting++;
+    gil->ticket_waiting[slot]++;
+    while (gil->now_serving != ticket)
+        GIL_COND_WAIT(&gil->ticket_cond[slot], &gil->mutex);
+    gil->ticket_waiting[slot]--;
+    gil->n_waiting--;
+    return 1;
+}
+
+// Pass the GIL to the next ticket, skipping abandoned ones.  Caller holds gil->mutex.
+static void _gil_ticket_advance(struct fastcond_gil *gil)
+{
+    int slot = ++gil->now_serving % FASTCOND_GIL_TICKET_SLOTS;
+
+    while (gil->ticket_abandoned_set[slot] && gil->ticket_abandoned[slot] == gil->now_serving) {
+        gil->ticket_abandoned_set[slot] = 0;
+        slot = ++gil->now_serving % FASTCOND_GIL_TICKET_SLOTS;
+    }
+
+    // A slot only has company when there are more waiters than slots.  Signal would then
+    // wake an arbitrary sharer, so wake them all and let the wrong ones park again.
+    if (gil->ticket_waiting[slot] == 1)
+        GIL_COND_SIGNAL(&gil->ticket_cond[slot]);
+    else if (gil->ticket_waiting[slot] > 1)
+        GIL_COND_BROADCAST(&gil->ticket_cond[slot]);
+}
+
+// As _gil_ticket_wait(), but give up at abstime.  Returns 0 once ticket is served, or
+// ETIMEDOUT.  A ticket cannot leave the queue, so a timed-out one is marked abandoned in its
+// slot for _gil_ticket_advance() to skip.  Each slot has room for one mark; if it is taken,
+// which needs more waiters than slots, we keep our place and pass the GIL straight on when
+// our turn comes, returning ETIMEDOUT late rather than breaking the queue.
+static int _gil_ticket_wait_until(struct fastcond_gil *gil, unsigned int ticket,
+                                  const struct timespec *abstime)
+{
+    int slot = ticket % FASTCOND_GIL_TICKET_SLOTS;
+    int late = 0;
+
+    if (gil->now_serving == ticket)
+        return 0;
+    gil->n_waiting++;
+    gil->ticket_waiting[slot]++;
+    while (gil->now_serving != ticket) {
+        if (late) {
+            GIL_COND_WAIT(&gil->ticket_cond[slot], &gil->mutex);
+        } else if (GIL_COND_TIMEDWAIT(&gil->ticket_cond[slot], &gil->mutex, abstime) ==
+                       ETIMEDOUT &&
+                   gil->now_serving != ticket) {
+            if (!gil->ticket_abandoned_set[slot]) {
+                gil->ticket_abandoned_set[slot] = 1;
+                gil->ticket_abandoned[slot] = ticket;
+                break;
+            }
+            late = 1;
+        }
+    }
+    gil->ticket_waiting[slot]--;
+    gil->n_waiting--;
+    if (late) {
+        _gil_ticket_advance(gil);
+        return ETIMEDOUT;
+    }
+    return gil->now_serving == ticket ? 0 : ETIMEDOUT;
+}
+#endif
+
+// Thread contexts.  The plain API uses an implicit one per thread, set up on first use, so
+// both APIs share the same code paths below; only the lookup differs.
+void fastcond_gil_thread_init(fastcond_gil_thread_t *thread)
+{
+    memset(thread, 0, sizeof(*thread));
+    thread->id = NATIVE_THREAD_SELF();
+}
+
+static NATIVE_THREAD_LOCAL struct fastcond_gil_thread _gil_tls_thread;
+static NATIVE_THREAD_LOCAL int _gil_tls_ready;
+
+static inline struct fastcond_gil_thread *_gil_self(void)
+{
+    if (!_gil_tls_ready) {
+        fastcond_gil_thread_init(&_gil_tls_thread);
+        _gil_tls_ready = 1;
+    }
+    return &_gil_tls_thread;
+}
+
+#if !FASTCOND_GIL_USE_FUTEX
+// Send the condition variable signals the GIL holder deferred.  The holder calls this as it
+// lets go of the GIL, under gil->mutex, so a woken waiter finds the GIL free or queues for
+// it, instead of waking while the signaller still holds it only to sleep again.
+static inline void _gil_cond_flush(struct fastcond_gil *gil)
+{
+    int i;
+
+    for (i = 0; i < gil->n_deferred; i++) {
+        if (gil->deferred_broadcast[i])
+            GIL_COND_BROADCAST(gil->deferred[i]);
+        else
+            GIL_COND_SIGNAL(gil->deferred[i]);
+    }
+    gil->n_deferred = 0;
+}
+
+// Queue a signal (or broadcast) to send at the next release.  Only the holder touches the
+// queue, so it needs no lock until it is full and must be sent early, under gil->mutex.  In
+// NAIVE mode the holder already owns gil->mutex, since that is the GIL.
+static int _gil_cond_defer(struct fastcond_gil *gil, fastcond_gil_cond_t *cond, int broadcast)
+{
+    if (gil->n_deferred == FASTCOND_GIL_COND_DEFERRED) {
+#if FASTCOND_GIL_MODE_NAIVE
+        _gil_cond_flush(gil);
+#else
+        GIL_MUTEX_LOCK(&gil->mutex);
+        _gil_cond_flush(gil);
+        GIL_MUTEX_UNLOCK(&gil->mutex);
+#endif
+    }
+    gil->deferred[gil->n_deferred] = cond;
+    gil->deferred_broadcast[gil->n_deferred] = (char) broadcast;
+    gil->n_deferred++;
+    return 0;
+}
+#endif
+
+#if FASTCOND_GIL_USE_FUTEX
+// Futex GIL.  The whole state is one word: FASTCOND_GIL_FUTEX_HELD plus
+// FASTCOND_GIL_FUTEX_WAITER for each thread registered as waiting.  Waiters sleep on the
+// word itself, so any change to it (a release, a new waiter) makes a sleeper about to block
+// on a stale value return at once instead.  Each release that leaves waiters wakes one of
+// them; whoever is woken and cannot take the GIL must pass the wakeup on if the GIL is
+// free, so that a free GIL never sits with all its waiters asleep.
+#define GIL_FUTEX_HELD FASTCOND_GIL_FUTEX_HELD
+#define GIL_FUTEX_WAITER FASTCOND_GIL_FUTEX_WAITER
+
+// Must self, seeing state s, keep waiting?  registered is 1 if self is counted in s.
+// With fair set, a free GIL is left to the others while self was the last owner.
+static inline int _gil_futex_blocked(struct fastcond_gil *gil, int s, native_thread_t self,
+                                     int registered, int fair)
+{
+    if (s & GIL_FUTEX_HELD)
+        return 1;
+    return fair && s / GIL_FUTEX_WAITER > registered && NATIVE_THREAD_EQUAL(gil->last_owner, self);
+}
+
+// Take the GIL as self, registered as a waiter or not, waiting as needed.  Returns 0, or
+// EBUSY (nowait) or ETIMEDOUT (abstime), having then unregistered.  *waited is set if the
+// caller had to sleep.
+static int _gil_futex_take(struct fastcond_gil *gil, native_thread_t self, int registered,
+                           int fair, const struct timespec *abstime, int nowait, int *waited)
+{
+    int s, err = -1; // err: result of our last sleep, if any
+
+    for (;;) {
+        s = native_atomic_load(&gil->futex);
+        if (!_gil_futex_blocked(gil, s, self, registered, fair)) {
+            if (!native_atomic_cas(&gil->futex, s,
+                                   (s | GIL_FUTEX_HELD) - registered * GIL_FUTEX_WAITER))
+                continue;
+            gil->last_owner = self;
+            return 0;
+        }
+        if (nowait && !registered)
+            return EBUSY;
+        if (!registered) {
+            // Register, then look again before sleeping: the GIL may be free by now
+            native_atomic_add(&gil->futex, GIL_FUTEX_WAITER);
+            registered = 1;
+            continue;
+        }
+        if (err == 0 && !(s & GIL_FUTEX_HELD)) {
+            // Woken to a free GIL that fairness leaves to the others: pass the wakeup on,
+            // then sleep until the GIL changes hands
+            native_futex_wake(&gil->futex, 1);
+        }
+        err = native_futex_wait(&gil->futex, s, abstime);
+        *waited = 1;
+        if (err == ETIMEDOUT) {
+            s = native_atomic_load(&gil->futex);
+            if (!_gil_futex_blocked(gil, s, self, 1, fair))
+                continue; // free for us after all: take it rather than time out
+            s = native_atomic_add(&gil->futex, -GIL_FUTEX_WAITER);
+            if (!(s & GIL_FUTEX_HELD) && s >= GIL_FUTEX_WAITER)
+                native_futex_wake(&gil->futex, 1); // pass on a wakeup we may have been sent
+            return ETIMEDOUT;
+        }
+    }
+}
+
+// Free the GIL, registering self as a waiter in the same step if reacquire is set, and
+// wake a waiter if another is registered
+static inline void _gil_futex_release(struct fastcond_gil *gil, int reacquire)
+{
+    int s = native_atomic_add(&gil->futex, reacquire * GIL_FUTEX_WAITER - GIL_FUTEX_HELD);
+    assert(!(s & GIL_FUTEX_HELD));
+    if (s / GIL_FUTEX_WAITER > reacquire)
+        native_futex_wake(&gil->futex, 1);
+}
 #else
-    fastcond_cond_init(&gil->cond, NULL);
+// Record a new acquisition by a thread of waiter class cls.  Caller holds gil->mutex.
+static inline void _gil_take(struct fastcond_gil *gil, native_thread_t self, int cls)
+{
+    assert(!gil->held);
+    gil->last_owner = self;
+    gil->held = 1;
+#if FASTCOND_GIL_IO_BOOST
+    gil->boost_streak = cls ? gil->boost_streak + 1 : 0;
+#elif FASTCOND_GIL_PRIO
+    _gil_prio_served(gil, cls);
+#else
+    (void) cls;
+#endif
+}
 #endif
 
-    NATIVE_MUTEX_INIT(&gil->mutex);
+void fastcond_gil_init(struct fastcond_gil *gil)
+{
+#if FASTCOND_GIL_USE_FUTEX
+    gil->futex = 0;
+    gil->last_owner = NATIVE_THREAD_SELF();
+#else
+    // Always initialize condition variables (even if NAIVE mode won't use them)
+    GIL_COND_INIT(&gil->cond);
+
+    GIL_MUTEX_INIT(&gil->mutex);
 
     // Always initialize tracking variables (minimal overhead)
     gil->held = 0;
     gil->n_waiting = 0;
     gil->last_owner = NATIVE_THREAD_SELF();
+    gil->n_deferred = 0;
+#endif
+
+#if FASTCOND_GIL_IO_BOOST
+    GIL_COND_INIT(&gil->boost_cond);
+    gil->n_boost_waiting = 0;
+    gil->boost_streak = 0;
+#endif
+#if FASTCOND_GIL_MODE_TICKET
+    gil->next_ticket = 0;
+    gil->now_serving = 0;
+    for (int i = 0; i < FASTCOND_GIL_TICKET_SLOTS; i++) {
+        GIL_COND_INIT(&gil->ticket_cond[i]);
+        gil->ticket_waiting[i] = 0;
+        gil->ticket_abandoned_set[i] = 0;
+    }
+#endif
+#if FASTCOND_GIL_NUMA
+    for (int i = 0; i < FASTCOND_GIL_NUMA_NODES; i++) {
+        GIL_COND_INIT(&gil->node_cond[i]);
+        gil->node_waiting[i] = 0;
+    }
+    gil->node_streak = 0;
+#endif
+#if FASTCOND_GIL_PRIO
+    for (int i = 0; i < FASTCOND_GIL_PRIO_LEVELS; i++) {
+        GIL_COND_INIT(&gil->prio_cond[i]);
+        gil->prio_waiting[i] = 0;
+        gil->prio_passed[i] = 0;
+    }
+    gil->prio_next = -1;
+#endif
+#if FASTCOND_GIL_RECURSIVE
+    gil->owner = gil->last_owner;
+    gil->depth = 0;
+#endif
+#if FASTCOND_GIL_SPIN
+    gil->n_cpus = native_cpu_count();
+    gil->n_spinning = 0;
+    gil->hold_start_ns = 0;
+    gil->hold_avg_ns = 0;
+#endif
+#if FASTCOND_GIL_STATS
+    memset(&gil->stats, 0, sizeof(gil->stats));
+    gil->stats_acquired_ns = gil->stats_released_ns = native_monotonic_ns();
+#endif
 }
 
 void fastcond_gil_destroy(struct fastcond_gil *gil)
 {
-    // Always destroy condition variables (even if NAIVE mode didn't use them)
-#if FASTCOND_GIL_USE_NATIVE_COND
-    NATIVE_COND_DESTROY(&gil->cond);
+#if FASTCOND_GIL_USE_FUTEX
+    assert(gil->futex == 0); // neither held nor waited for
 #else
-    fastcond_cond_fini(&gil->cond);
+    // Always destroy condition variables (even if NAIVE mode didn't use them)
+    GIL_COND_DESTROY(&gil->cond);
+#endif
+#if FASTCOND_GIL_IO_BOOST
+    GIL_COND_DESTROY(&gil->boost_cond);
+#endif
+#if FASTCOND_GIL_MODE_TICKET
+    for (int i = 0; i < FASTCOND_GIL_TICKET_SLOTS; i++) {
+        GIL_COND_DESTROY(&gil->ticket_cond[i]);
+    }
+#endif
+#if FASTCOND_GIL_NUMA
+    for (int i = 0; i < FASTCOND_GIL_NUMA_NODES; i++) {
+        GIL_COND_DESTROY(&gil->node_cond[i]);
+    }
+#endif
+#if FASTCOND_GIL_PRIO
+    for (int i = 0; i < FASTCOND_GIL_PRIO_LEVELS; i++) {
+        GIL_COND_DESTROY(&gil->prio_cond[i]);
+    }
+#endif
+#if !FASTCOND_GIL_USE_FUTEX
+    GIL_MUTEX_DESTROY(&gil->mutex);
 #endif
-    NATIVE_MUTEX_DESTROY(&gil->mutex);
 }
 
+#if !FASTCOND_GIL_MODE_NAIVE && !FASTCOND_GIL_MODE_TICKET && !FASTCOND_GIL_USE_FUTEX
 // Implement the GIL logic.  A Thread can acquire the gil if
 // A) the gil is not currently held and:
 //   1) no one is waiting or
 //   2) (fairness enabled) someone is waiting, but the last owner is not the current thread
 //   3) (fairness disabled) behaves like a regular mutex - any thread can acquire
+// B) (I/O boost enabled) no boosted waiter has first claim on it, unless the caller is
+//    itself boosted
+// C) (priority classes enabled) no other class has been chosen to have it
+// Returns nonzero while the caller must keep waiting.  Caller holds gil->mutex.
+static inline int _gil_acquire_blocked(struct fastcond_gil *gil, native_thread_t self, int cls)
+{
+    (void) cls; // only consulted with I/O boost and priority classes
+    // Fairness control: use ACQUIRE_GREEDY setting
+#if FASTCOND_GIL_ACQUIRE_GREEDY
+    // GREEDY mode: only wait if GIL is held (ignores fairness condition)
+    (void) self;
+    return gil->held || GIL_BOOST_RESERVED(gil, cls) || GIL_PRIO_RESERVED(gil, cls);
+#else
+    // FAIR mode: also prevent re-acquisition when others are waiting
+    return gil->held || (gil->n_waiting > 0 && NATIVE_THREAD_EQUAL(gil->last_owner, self)) ||
+           GIL_BOOST_RESERVED(gil, cls) || GIL_PRIO_RESERVED(gil, cls);
+#endif
+}
+#endif
 
-void fastcond_gil_acquire(struct fastcond_gil *gil)
+// Acquire the GIL.  With abstime NULL, wait for as long as it takes; otherwise give up with
+// ETIMEDOUT once abstime passes.  With nowait, give up with EBUSY rather than wait at all.
+// Callers pass constants, so the plain blocking acquire compiles to what it always was.
+static inline int _gil_acquire(struct fastcond_gil *gil, struct fastcond_gil_thread *t,
+                               const struct timespec *abstime, int nowait)
 {
 #if FASTCOND_GIL_MODE_NAIVE
     // NAIVE mode: Simple mutex lock - no condition variables or state tracking
     // This provides the absolute minimal baseline for comparison
-    NATIVE_MUTEX_LOCK(&gil->mutex);
+    int err = 0;
+    if (nowait)
+        err = GIL_MUTEX_TRYLOCK(&gil->mutex);
+    else if (abstime)
+        return ENOSYS; // there is no portable timed mutex lock
+    else
+        GIL_MUTEX_LOCK(&gil->mutex);
     // In naive mode, mutex lock provides all synchronization
     // No state tracking, no condition variables
+    if (err == 0)
+        t->acquisitions++;
+    return err;
+#elif FASTCOND_GIL_MODE_TICKET
+    // TICKET mode: take a number and wait for it to come up
+    native_thread_t self = t->id;
+#if FASTCOND_GIL_STATS
+    long long t_enter = native_monotonic_ns();
+#endif
+    int waited;
+    GIL_MUTEX_LOCK(&gil->mutex);
+    if (nowait && gil->now_serving != gil->next_ticket) {
+        // Held, or someone is queued ahead of us
+        GIL_MUTEX_UNLOCK(&gil->mutex);
+        return EBUSY;
+    }
+    unsigned int ticket = gil->next_ticket++;
+    if (!abstime) {
+        waited = _gil_ticket_wait(gil, ticket);
+    } else {
+        waited = gil->now_serving != ticket;
+        if (_gil_ticket_wait_until(gil, ticket, abstime) != 0) {
+            GIL_MUTEX_UNLOCK(&gil->mutex);
+            return ETIMEDOUT;
+        }
+    }
+    _gil_take(gil, self, 0);
+#if FASTCOND_GIL_STATS
+    _gil_stats_acquired(gil, self, t_enter, waited, waited);
+#endif
+    GIL_MUTEX_UNLOCK(&gil->mutex);
+    t->acquisitions++;
+    t->contended += waited;
+    return 0;
+#elif FASTCOND_GIL_USE_FUTEX
+    // FUTEX backend: one CAS when free, otherwise register and sleep on the word
+    int waited = 0;
+    int err = _gil_futex_take(gil, t->id, 0, !FASTCOND_GIL_ACQUIRE_GREEDY, abstime, nowait,
+                              &waited);
+    if (err == 0) {
+        t->acquisitions++;
+        t->contended += waited;
+    }
+    return err;
 #else
-    // UNFAIR and FAIR modes: Identical except for the while condition
-    // Always get thread ID for state tracking (even in UNFAIR mode)
-    native_thread_t self = NATIVE_THREAD_SELF();
-    NATIVE_MUTEX_LOCK(&gil->mutex);
-
-    // Fairness control: use ACQUIRE_GREEDY setting
-#if FASTCOND_GIL_ACQUIRE_GREEDY
-    // GREEDY mode: only wait if GIL is held (ignores fairness condition)
-    while (gil->held) {
-#else
-    // FAIR mode: also prevent re-acquisition when others are waiting
-    while (gil->held || (gil->n_waiting > 0 && NATIVE_THREAD_EQUAL(gil->last_owner, self))) {
+    // UNFAIR and FAIR modes: Identical except for _gil_acquire_blocked()
+    // The cached thread ID serves state tracking (even in UNFAIR mode)
+    native_thread_t self = t->id;
+#if GIL_TIMING
+    long long t_enter = native_monotonic_ns();
 #endif
-        gil->n_waiting++;
-#if FASTCOND_GIL_USE_NATIVE_COND
-        NATIVE_COND_WAIT(&gil->cond, &gil->mutex);
+#if FASTCOND_GIL_IO_BOOST
+    // Classify before taking the mutex; the clock read needs no protection
+    int cls = _gil_io_boosted(t, t_enter);
+#elif FASTCOND_GIL_PRIO
+    int cls = t->prio;
 #else
-        fastcond_cond_wait(&gil->cond, &gil->mutex);
+    const int cls = 0;
+#endif
+    int waited = 0;
+#if FASTCOND_GIL_SPIN
+    // Spin before taking the mutex, so spinners do not contend with the holder for it.
+    // Bounded waits go straight to the condition variable; their callers want out early.
+    if (!abstime && !nowait && gil->held)
+        _gil_spin(gil, t_enter);
 #endif
+    GIL_MUTEX_LOCK(&gil->mutex);
+
+    while (_gil_acquire_blocked(gil, self, cls)) {
+        int err;
+
+        if (nowait) {
+            GIL_MUTEX_UNLOCK(&gil->mutex);
+            return EBUSY;
+        }
+        gil->n_waiting++;
+        err = _gil_wait(gil, cls, abstime);
         gil->n_waiting--;
+        waited = 1;
+        if (err == ETIMEDOUT && _gil_acquire_blocked(gil, self, cls)) {
+            // A release may have chosen us to wake just as we timed out.  Pass the wakeup
+            // on, or a free GIL could be left with every other waiter still asleep.
+            if (!gil->held)
+                _gil_signal(gil);
+            GIL_MUTEX_UNLOCK(&gil->mutex);
+            return ETIMEDOUT;
+        }
+        GIL_PRIO_PASS_ON(gil, self, cls);
     }
 
-    assert(!gil->held);
     // Always update state tracking (even in UNFAIR mode)
-    gil->last_owner = self;
-    gil->held = 1;
-    NATIVE_MUTEX_UNLOCK(&gil->mutex);
+    _gil_take(gil, self, cls);
+#if FASTCOND_GIL_STATS
+    _gil_stats_acquired(gil, self, t_enter, waited, waited);
+#endif
+    GIL_MUTEX_UNLOCK(&gil->mutex);
+    t->acquisitions++;
+    t->contended += waited;
+
+#if FASTCOND_GIL_IO_BOOST || FASTCOND_GIL_SPIN
+    long long t_acquired = native_monotonic_ns();
+#endif
+#if FASTCOND_GIL_IO_BOOST
+    t->io_burst_start_ns = t_acquired;
+#endif
+#if FASTCOND_GIL_SPIN
+    gil->hold_start_ns = t_acquired;
+#endif
+    return 0;
 #endif
 }
 
-void fastcond_gil_release(struct fastcond_gil *gil)
+static inline void _gil_release(struct fastcond_gil *gil, struct fastcond_gil_thread *t)
 {
+#if !FASTCOND_GIL_IO_BOOST && !FASTCOND_GIL_PRIO
+    (void) t; // only I/O boost and priority classes keep per-thread state
+#endif
 #if FASTCOND_GIL_MODE_NAIVE
     // NAIVE mode: Simple mutex unlock - no state tracking or signaling
-    NATIVE_MUTEX_UNLOCK(&gil->mutex);
+    _gil_cond_flush(gil);
+    GIL_MUTEX_UNLOCK(&gil->mutex);
+#elif FASTCOND_GIL_MODE_TICKET
+    // TICKET mode: serve the next ticket
+#if FASTCOND_GIL_STATS
+    long long now = native_monotonic_ns();
+#endif
+    GIL_MUTEX_LOCK(&gil->mutex);
+    assert(gil->held);
+#if FASTCOND_GIL_STATS
+    _gil_stats_released(gil, now);
+#endif
+    gil->held = 0;
+    _gil_cond_flush(gil);
+    _gil_ticket_advance(gil);
+    GIL_MUTEX_UNLOCK(&gil->mutex);
+#elif FASTCOND_GIL_USE_FUTEX
+    // FUTEX backend: clear the held bit, and wake a waiter if there is one
+    _gil_futex_release(gil, 0);
 #else
     // UNFAIR and FAIR modes: Identical behavior
-    NATIVE_MUTEX_LOCK(&gil->mutex);
+#if GIL_TIMING
+    long long now = native_monotonic_ns();
+#endif
+#if FASTCOND_GIL_IO_BOOST
+    _gil_io_note_release(t, now);
+#endif
+#if FASTCOND_GIL_SPIN
+    _gil_spin_note_hold(gil, now);
+#endif
+#if FASTCOND_GIL_PRIO
+    t->prio = 0; // the class lasts until release
+#endif
+    GIL_MUTEX_LOCK(&gil->mutex);
     assert(gil->held);
 
-    if (gil->n_waiting > 0) {
-#if FASTCOND_GIL_USE_NATIVE_COND
-        NATIVE_COND_SIGNAL(&gil->cond);
-#else
-        fastcond_cond_signal(&gil->cond);
+#if FASTCOND_GIL_STATS
+    _gil_stats_released(gil, now);
 #endif
-    }
+    _gil_cond_flush(gil);
+    _gil_signal(gil);
     gil->held = 0;
-    NATIVE_MUTEX_UNLOCK(&gil->mutex);
+    GIL_MUTEX_UNLOCK(&gil->mutex);
 #endif
 }
 
@@ -137,33 +1006,80 @@ void fastcond_gil_release(struct fastcond_gil *gil)
 // - NAIVE mode: Simple mutex unlock + lock (no optimization possible)
 // - FAIR/UNFAIR modes: Optimized to eliminate redundant mutex unlock/lock
 //   pair between release and acquire phases, reducing mutex operations by 50%
+// - TICKET mode: Same single lock/unlock, but the yielding thread always goes to the
+//   back of the queue
+// - FUTEX backend: one atomic op to release and register, one to take back
 
-void fastcond_gil_yield(struct fastcond_gil *gil)
+static inline void _gil_yield(struct fastcond_gil *gil, struct fastcond_gil_thread *t)
 {
 #if FASTCOND_GIL_MODE_NAIVE
     // NAIVE mode: Simple release + acquire with mutex operations
     // No optimization possible since we just have a plain mutex
-    NATIVE_MUTEX_UNLOCK(&gil->mutex);
-    NATIVE_MUTEX_LOCK(&gil->mutex);
+    _gil_cond_flush(gil);
+    GIL_MUTEX_UNLOCK(&gil->mutex);
+    GIL_MUTEX_LOCK(&gil->mutex);
+    t->acquisitions++;
+#elif FASTCOND_GIL_MODE_TICKET
+    // TICKET mode: serve the next ticket and go to the back of the queue.  With nobody
+    // waiting, our new ticket is the one now being served and we carry straight on.
+    native_thread_t self = t->id;
+#if FASTCOND_GIL_STATS
+    long long t_enter = native_monotonic_ns();
+#endif
+    GIL_MUTEX_LOCK(&gil->mutex);
+    assert(gil->held);
+#if FASTCOND_GIL_STATS
+    _gil_stats_released(gil, t_enter);
+#endif
+    gil->held = 0;
+    _gil_cond_flush(gil);
+    _gil_ticket_advance(gil);
+
+    int waited = _gil_ticket_wait(gil, gil->next_ticket++);
+    _gil_take(gil, self, 0);
+#if FASTCOND_GIL_STATS
+    _gil_stats_acquired(gil, self, t_enter, waited, waited);
+#endif
+    GIL_MUTEX_UNLOCK(&gil->mutex);
+    t->acquisitions++;
+    t->contended += waited;
+#elif FASTCOND_GIL_USE_FUTEX
+    // FUTEX backend: release and register as a waiter in one atomic step, so that with
+    // nobody else waiting the GIL is simply taken back with a second one
+    int waited = 0;
+    _gil_futex_release(gil, 1);
+    _gil_futex_take(gil, t->id, 1, FASTCOND_GIL_YIELD_FAIR, NULL, 0, &waited);
+    t->acquisitions++;
+    t->contended += waited;
 #else
     // OPTIMIZED IMPLEMENTATION: Combine release + acquire with shared mutex lock
 
-    // Get thread ID for fairness checking (same as acquire)
-    native_thread_t self = NATIVE_THREAD_SELF();
+    // Cached thread ID for fairness checking (same as acquire)
+    native_thread_t self = t->id;
+#if FASTCOND_GIL_STATS || FASTCOND_GIL_SPIN
+    long long t_enter = native_monotonic_ns();
+#endif
+#if FASTCOND_GIL_PRIO
+    int cls = t->prio; // a yield keeps the class of the hold
+#else
+    const int cls = 0; // a yielding thread is never boosted
+#endif
+    int waited = 0;
+#if FASTCOND_GIL_SPIN
+    _gil_spin_note_hold(gil, t_enter);
+#endif
 
     // Single mutex lock for entire yield operation
-    NATIVE_MUTEX_LOCK(&gil->mutex);
+    GIL_MUTEX_LOCK(&gil->mutex);
 
     // RELEASE PHASE: Same logic as fastcond_gil_release() but no mutex unlock
     assert(gil->held);
 
-    if (gil->n_waiting > 0) {
-#if FASTCOND_GIL_USE_NATIVE_COND
-        NATIVE_COND_SIGNAL(&gil->cond);
-#else
-        fastcond_cond_signal(&gil->cond);
+#if FASTCOND_GIL_STATS
+    _gil_stats_released(gil, t_enter);
 #endif
-    }
+    _gil_cond_flush(gil);
+    _gil_signal(gil);
     gil->held = 0;
 
     // YIELD POINT: Other threads can now compete for the GIL
@@ -172,29 +1088,326 @@ void fastcond_gil_yield(struct fastcond_gil *gil)
     // ACQUIRE PHASE: Same logic as fastcond_gil_acquire() but no mutex lock
     // The critical difference: we already hold the mutex from the release phase
     // NOTE: yield() uses its own fairness setting, independent of acquire()
+    // A yielding thread is never boosted: it is by definition in the middle of a burst.
 
 #if !FASTCOND_GIL_YIELD_FAIR
     // Unfair yield: only wait if GIL is held (ignores fairness condition)
-    while (gil->held) {
+    while (gil->held || GIL_BOOST_RESERVED(gil, cls) || GIL_PRIO_RESERVED(gil, cls)) {
 #else
     // Fair yield: also prevent re-acquisition when others are waiting (default)
-    while (gil->held || (gil->n_waiting > 0 && NATIVE_THREAD_EQUAL(gil->last_owner, self))) {
+    while (gil->held || (gil->n_waiting > 0 && NATIVE_THREAD_EQUAL(gil->last_owner, self)) ||
+           GIL_BOOST_RESERVED(gil, cls) || GIL_PRIO_RESERVED(gil, cls)) {
 #endif
         gil->n_waiting++;
-#if FASTCOND_GIL_USE_NATIVE_COND
-        NATIVE_COND_WAIT(&gil->cond, &gil->mutex);
-#else
-        fastcond_cond_wait(&gil->cond, &gil->mutex);
-#endif
+        _gil_wait(gil, cls, NULL);
         gil->n_waiting--;
+        waited = 1;
+        GIL_PRIO_PASS_ON(gil, self, cls);
     }
 
-    assert(!gil->held);
     // Update state tracking for new acquisition
-    gil->last_owner = self;
-    gil->held = 1;
+#if FASTCOND_GIL_STATS
+    // Getting the GIL back after sleeping only counts as a handoff to us if another
+    // thread held it in between; otherwise the "release" was our own.
+    int handed_off = waited && !NATIVE_THREAD_EQUAL(gil->last_owner, self);
+#endif
+    _gil_take(gil, self, cls);
+#if FASTCOND_GIL_STATS
+    _gil_stats_acquired(gil, self, t_enter, waited, handed_off);
+#endif
 
     // Single mutex unlock for entire yield operation
-    NATIVE_MUTEX_UNLOCK(&gil->mutex);
+    GIL_MUTEX_UNLOCK(&gil->mutex);
+    t->acquisitions++;
+    t->contended += waited;
+
+#if FASTCOND_GIL_SPIN
+    // If we never let go, the new hold starts where the old one ended
+    gil->hold_start_ns = waited ? native_monotonic_ns() : t_enter;
+#endif
+#endif
+}
+
+// Wait on cond, with the GIL as its mutex: release the GIL, sleep until cond is signalled,
+// then take the GIL back before returning, all under one hold of gil->mutex.  A signal
+// deferred until the signaller's release wakes us when the GIL is free, so the usual path
+// is one sleep and one wakeup.  The way back in follows yield() rules: never boosted, in the
+// same priority class, and at the back of the queue in TICKET mode.
+static inline int _gil_cond_wait(struct fastcond_gil *gil, struct fastcond_gil_thread *t,
+                                 fastcond_gil_cond_t *cond)
+{
+#if FASTCOND_GIL_MODE_NAIVE
+    // NAIVE mode: the GIL is the mutex
+    _gil_cond_flush(gil);
+    GIL_COND_WAIT(cond, &gil->mutex);
+    t->acquisitions++;
+    return 0;
+#elif FASTCOND_GIL_MODE_TICKET
+    native_thread_t self = t->id;
+#if FASTCOND_GIL_STATS
+    long long now = native_monotonic_ns();
+#endif
+    GIL_MUTEX_LOCK(&gil->mutex);
+    assert(gil->held);
+#if FASTCOND_GIL_STATS
+    _gil_stats_released(gil, now);
+#endif
+    gil->held = 0;
+    _gil_cond_flush(gil);
+    _gil_ticket_advance(gil);
+    GIL_COND_WAIT(cond, &gil->mutex);
+
+#if FASTCOND_GIL_STATS
+    long long t_enter = native_monotonic_ns();
+#endif
+    int waited = _gil_ticket_wait(gil, gil->next_ticket++);
+    _gil_take(gil, self, 0);
+#if FASTCOND_GIL_STATS
+    _gil_stats_acquired(gil, self, t_enter, waited, waited);
+#endif
+    GIL_MUTEX_UNLOCK(&gil->mutex);
+    t->acquisitions++;
+    t->contended += waited;
+    return 0;
+#elif FASTCOND_GIL_USE_FUTEX
+    // No mutex to wait with; see gil.h
+    (void) gil;
+    (void) t;
+    (void) cond;
+    return ENOSYS;
+#else
+    native_thread_t self = t->id;
+#if FASTCOND_GIL_PRIO
+    int cls = t->prio;
+#else
+    const int cls = 0;
+#endif
+    int waited = 0;
+#if GIL_TIMING
+    long long now = native_monotonic_ns();
+#endif
+#if FASTCOND_GIL_IO_BOOST
+    _gil_io_note_release(t, now);
+#endif
+#if FASTCOND_GIL_SPIN
+    _gil_spin_note_hold(gil, now);
+#endif
+    GIL_MUTEX_LOCK(&gil->mutex);
+    assert(gil->held);
+#if FASTCOND_GIL_STATS
+    _gil_stats_released(gil, now);
+#endif
+    _gil_cond_flush(gil);
+    _gil_signal(gil);
+    gil->held = 0;
+    GIL_COND_WAIT(cond, &gil->mutex);
+
+    // Signalled, and still holding gil->mutex: go straight for the GIL
+#if FASTCOND_GIL_STATS
+    long long t_enter = native_monotonic_ns();
+#endif
+    while (_gil_acquire_blocked(gil, self, cls)) {
+        gil->n_waiting++;
+        _gil_wait(gil, cls, NULL);
+        gil->n_waiting--;
+        waited = 1;
+        GIL_PRIO_PASS_ON(gil, self, cls);
+    }
+    _gil_take(gil, self, cls);
+#if FASTCOND_GIL_STATS
+    _gil_stats_acquired(gil, self, t_enter, waited, waited);
+#endif
+    GIL_MUTEX_UNLOCK(&gil->mutex);
+    t->acquisitions++;
+    t->contended += waited;
+
+#if FASTCOND_GIL_IO_BOOST || FASTCOND_GIL_SPIN
+    long long t_acquired = native_monotonic_ns();
+#endif
+#if FASTCOND_GIL_IO_BOOST
+    t->io_burst_start_ns = t_acquired;
+#endif
+#if FASTCOND_GIL_SPIN
+    gil->hold_start_ns = t_acquired;
+#endif
+    return 0;
+#endif
+}
+
+// Public entry points.  In RECURSIVE mode these track ownership depth around the mode
+// implementations above, which only ever see the outermost acquire and release.
+//
+// Only the owner writes owner and depth.  A new owner stores owner before publishing
+// depth, so a thread that sees depth > 0 also sees the current owner and can never mistake
+// itself for it; and a thread that is the owner reads back its own writes.
+
+#if FASTCOND_GIL_RECURSIVE
+// Whether t already owns the GIL, so that an acquire would only nest
+#define GIL_NESTED(gil, t)                                                                         \
+    (native_atomic_load(&(gil)->depth) > 0 && NATIVE_THREAD_EQUAL((gil)->owner, (t)->id))
+
+// Shared by the acquire variants: nested acquires succeed at once, outer ones go through
+// _gil_acquire() and record the new owner on success
+static inline int _gil_acquire_recursive(struct fastcond_gil *gil, struct fastcond_gil_thread *t,
+                                         const struct timespec *abstime, int nowait)
+{
+    int err;
+
+    if (GIL_NESTED(gil, t)) {
+        gil->depth++; // nested: we already own it
+        return 0;
+    }
+    err = _gil_acquire(gil, t, abstime, nowait);
+    if (err == 0) {
+        gil->owner = t->id;
+        native_atomic_store(&gil->depth, 1);
+    }
+    return err;
+}
+#define GIL_ACQUIRE(gil, t, abstime, nowait) _gil_acquire_recursive((gil), (t), (abstime), (nowait))
+
+static inline void _gil_release_recursive(struct fastcond_gil *gil, struct fastcond_gil_thread *t)
+{
+    assert(gil->depth > 0 && NATIVE_THREAD_EQUAL(gil->owner, t->id));
+    if (gil->depth > 1) {
+        gil->depth--;
+        return;
+    }
+    native_atomic_store(&gil->depth, 0);
+    _gil_release(gil, t);
+}
+#define GIL_RELEASE(gil, t) _gil_release_recursive((gil), (t))
+
+// A yield lets go of the GIL whatever the nesting, and restores the depth on return
+static inline void _gil_yield_recursive(struct fastcond_gil *gil, struct fastcond_gil_thread *t)
+{
+    int depth = gil->depth;
+    assert(depth > 0 && NATIVE_THREAD_EQUAL(gil->owner, t->id));
+    native_atomic_store(&gil->depth, 0);
+    _gil_yield(gil, t);
+    gil->owner = t->id;
+    native_atomic_store(&gil->depth, depth);
+}
+#define GIL_YIELD(gil, t) _gil_yield_recursive((gil), (t))
+#else
+#define GIL_NESTED(gil, t) 0
+#define GIL_ACQUIRE(gil, t, abstime, nowait) _gil_acquire((gil), (t), (abstime), (nowait))
+#define GIL_RELEASE(gil, t) _gil_release((gil), (t))
+#define GIL_YIELD(gil, t) _gil_yield((gil), (t))
+#endif
+
+void fastcond_gil_acquire(struct fastcond_gil *gil)
+{
+    GIL_ACQUIRE(gil, _gil_self(), NULL, 0);
+}
+
+int fastcond_gil_try_acquire(struct fastcond_gil *gil)
+{
+    return GIL_ACQUIRE(gil, _gil_self(), NULL, 1);
+}
+
+int fastcond_gil_acquire_timeout(struct fastcond_gil *gil, long long timeout_us)
+{
+    struct timespec abstime;
+
+    if (timeout_us <= 0)
+        return GIL_ACQUIRE(gil, _gil_self(), NULL, 1) == 0 ? 0 : ETIMEDOUT;
+    native_deadline_us(&abstime, timeout_us);
+    return GIL_ACQUIRE(gil, _gil_self(), &abstime, 0);
+}
+
+int fastcond_gil_acquire_prio(struct fastcond_gil *gil, int level)
+{
+    if (level < 0 || level >= FASTCOND_GIL_PRIO_LEVELS)
+        return EINVAL;
+#if FASTCOND_GIL_PRIO
+    struct fastcond_gil_thread *t = _gil_self();
+    if (!GIL_NESTED(gil, t))
+        t->prio = level; // a nested acquire keeps the class of the hold it is in
+    return GIL_ACQUIRE(gil, t, NULL, 0);
+#else
+    return GIL_ACQUIRE(gil, _gil_self(), NULL, 0);
+#endif
+}
+
+void fastcond_gil_release(struct fastcond_gil *gil)
+{
+    GIL_RELEASE(gil, _gil_self());
+}
+
+void fastcond_gil_yield(struct fastcond_gil *gil)
+{
+    GIL_YIELD(gil, _gil_self());
+}
+
+void fastcond_gil_acquire_ctx(struct fastcond_gil *gil, fastcond_gil_thread_t *thread)
+{
+    assert(NATIVE_THREAD_EQUAL(thread->id, NATIVE_THREAD_SELF()));
+    GIL_ACQUIRE(gil, thread, NULL, 0);
+}
+
+void fastcond_gil_release_ctx(struct fastcond_gil *gil, fastcond_gil_thread_t *thread)
+{
+    assert(NATIVE_THREAD_EQUAL(thread->id, NATIVE_THREAD_SELF()));
+    GIL_RELEASE(gil, thread);
+}
+
+void fastcond_gil_yield_ctx(struct fastcond_gil *gil, fastcond_gil_thread_t *thread)
+{
+    assert(NATIVE_THREAD_EQUAL(thread->id, NATIVE_THREAD_SELF()));
+    GIL_YIELD(gil, thread);
+}
+
+int fastcond_gil_cond_wait(struct fastcond_gil *gil, fastcond_gil_cond_t *cond)
+{
+    struct fastcond_gil_thread *t = _gil_self();
+#if FASTCOND_GIL_RECURSIVE
+    // Like yield: let go whatever the nesting, restore the depth on return
+    int depth = gil->depth;
+    int err;
+    assert(depth > 0 && NATIVE_THREAD_EQUAL(gil->owner, t->id));
+    native_atomic_store(&gil->depth, 0);
+    err = _gil_cond_wait(gil, t, cond);
+    gil->owner = t->id;
+    native_atomic_store(&gil->depth, depth);
+    return err;
+#else
+    return _gil_cond_wait(gil, t, cond);
+#endif
+}
+
+int fastcond_gil_cond_signal(struct fastcond_gil *gil, fastcond_gil_cond_t *cond)
+{
+#if FASTCOND_GIL_USE_FUTEX
+    (void) gil;
+    (void) cond;
+    return ENOSYS;
+#else
+    return _gil_cond_defer(gil, cond, 0);
+#endif
+}
+
+int fastcond_gil_cond_broadcast(struct fastcond_gil *gil, fastcond_gil_cond_t *cond)
+{
+#if FASTCOND_GIL_USE_FUTEX
+    (void) gil;
+    (void) cond;
+    return ENOSYS;
+#else
+    return _gil_cond_defer(gil, cond, 1);
+#endif
+}
+
+int fastcond_gil_get_stats(struct fastcond_gil *gil, struct fastcond_gil_stats *stats)
+{
+#if FASTCOND_GIL_STATS
+    GIL_MUTEX_LOCK(&gil->mutex);
+    *stats = gil->stats;
+    GIL_MUTEX_UNLOCK(&gil->mutex);
+    return 0;
+#else
+    (void) gil;
+    (void) stats;
+    return ENOSYS;
 #endif
 }
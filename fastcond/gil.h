@@ -9,6 +9,58 @@
 #define FASTCOND_GIL_USE_NATIVE_COND 0
 #endif
 
+// FUTEX BACKEND (Linux only):
+//
+// FASTCOND_GIL_USE_FUTEX (default: 0)
+//   Replaces the mutex, condition variable and held/n_waiting fields with a single 32-bit
+//   futex word holding a held bit and the waiter count.  An uncontended acquire or release
+//   is one atomic operation; a contended handoff is one FUTEX_WAKE and one FUTEX_WAIT, with
+//   no internal mutex for either side to queue on.  Fairness follows FASTCOND_GIL_YIELD_FAIR
+//   and FASTCOND_GIL_ACQUIRE_GREEDY as for the other backends.  Combines with RECURSIVE
+//   mode and the timed acquires; the other modes need the condition variable GIL.
+#ifndef FASTCOND_GIL_USE_FUTEX
+#define FASTCOND_GIL_USE_FUTEX 0
+#endif
+#define FASTCOND_GIL_FUTEX_HELD 1   // futex word: the GIL is held
+#define FASTCOND_GIL_FUTEX_WAITER 2 // futex word: added per registered waiter
+
+// Name of the backend compiled in, for reports
+#if FASTCOND_GIL_USE_FUTEX
+#define FASTCOND_GIL_BACKEND_NAME "futex"
+#elif FASTCOND_GIL_USE_NATIVE_COND
+#define FASTCOND_GIL_BACKEND_NAME "Native pthread"
+#else
+#define FASTCOND_GIL_BACKEND_NAME "fastcond"
+#endif
+
+// INTERNAL MUTEX:
+//
+// FASTCOND_GIL_MUTEX_KIND (default: NATIVE_MUTEX_KIND, see native_primitives.h)
+//   Kind of the native internal mutex: NATIVE_MUTEX_KIND_DEFAULT, _ADAPTIVE, _ERRORCHECK or
+//   _PI.  With _PI a real-time thread blocked on the mutex lends its priority to the holder,
+//   which bounds priority inversion inside acquire, release and yield.  GIL ownership itself
+//   is a flag guarded by that mutex and passes on no priority, except in NAIVE mode, where
+//   the mutex is the GIL.  With _ERRORCHECK a failed lock or unlock aborts.
+//
+// FASTCOND_GIL_USE_FASTCOND_MUTEX (default: 0)
+//   Uses fastcond_mutex_t (fastcond.h) for the GIL's internal mutex instead of
+//   native_mutex_t, with the fastcond condition variables waiting on it through
+//   fastcond_cond_wait_fm().  Every acquire, release and yield takes that mutex, so its
+//   uncontended cost and its wake-up behaviour show up directly in GIL handoff latency.
+//   Needs the fastcond condition variable backend, not native conditions or the futex GIL.
+//
+// FASTCOND_GIL_MUTEX_FLAGS (default: 0)
+//   Flags for fastcond_mutex_init(), e.g. FASTCOND_MUTEX_HANDOFF.
+#ifndef FASTCOND_GIL_MUTEX_KIND
+#define FASTCOND_GIL_MUTEX_KIND NATIVE_MUTEX_KIND
+#endif
+#ifndef FASTCOND_GIL_USE_FASTCOND_MUTEX
+#define FASTCOND_GIL_USE_FASTCOND_MUTEX 0
+#endif
+#ifndef FASTCOND_GIL_MUTEX_FLAGS
+#define FASTCOND_GIL_MUTEX_FLAGS 0
+#endif
+
 // FAIRNESS CONTROL CONFIGURATION:
 // The GIL provides separate fairness controls for yield() and acquire() operations:
 //
@@ -41,18 +93,281 @@
 // This pattern provides more realistic fairness behavior compared to simple acquire/release
 // cycles and better represents how Python threads interact with the GIL in practice.
 
-struct fastcond_gil {
+// I/O BOOST MODE (convoy-effect mitigation):
+//
+// FASTCOND_GIL_IO_BOOST (default: 0)
+//   The classic GIL convoy effect: a thread that releases the GIL for a short I/O operation
+//   and then calls fastcond_gil_acquire() queues behind CPU-bound threads that keep the GIL
+//   busy through fastcond_gil_yield(), so every short I/O costs a full trip round the
+//   convoy.  When enabled, a thread re-entering via fastcond_gil_acquire() is classified as
+//   I/O-bound if its recent GIL bursts (acquire to release) were short and it was only
+//   briefly released.  Such threads wait on a separate condition variable and are woken in
+//   preference to threads coming back from yield() or long releases.
+//
+// FASTCOND_GIL_IO_BOOST_HOLD_US (default: 1000)
+//   Upper bound on the smoothed burst length for a thread to count as I/O-bound.
+// FASTCOND_GIL_IO_BOOST_RELEASE_US (default: 10000)
+//   Upper bound on the release duration; threads returning from long sleeps are not boosted.
+// FASTCOND_GIL_IO_BOOST_MAX_STREAK (default: 8)
+//   Consecutive boosted handoffs after which a waiting CPU-bound thread gets its turn,
+//   so that a steady stream of I/O threads cannot starve the rest.
+#ifndef FASTCOND_GIL_IO_BOOST
+#define FASTCOND_GIL_IO_BOOST 0
+#endif
+
+// TICKET MODE (strict FIFO):
+//
+// FASTCOND_GIL_MODE_TICKET (default: 0)
+//   The default fairness rule, "n_waiting > 0 && last_owner == self", only stops the
+//   immediate previous owner from re-acquiring.  With three or more threads, two of them can
+//   pass the GIL back and forth while a third starves.  Ticket mode hands out tickets
+//   (next_ticket) on entry to acquire() and yield() and serves them strictly in order
+//   (now_serving), so a waiter has at most n_waiting acquisitions ahead of it.
+//   Waiters park on one of FASTCOND_GIL_TICKET_SLOTS condition variables chosen by ticket
+//   number, so a release normally wakes exactly the thread whose turn it is.  Ticket mode
+//   replaces the FASTCOND_GIL_YIELD_FAIR / FASTCOND_GIL_ACQUIRE_GREEDY rules.
+//
+// FASTCOND_GIL_TICKET_SLOTS (default: 16)
+//   Number of parking slots.  With more waiters than slots, tickets share a slot and a
+//   release broadcasts to it; correctness is unaffected.
+#ifndef FASTCOND_GIL_MODE_TICKET
+#define FASTCOND_GIL_MODE_TICKET 0
+#endif
+#ifndef FASTCOND_GIL_TICKET_SLOTS
+#define FASTCOND_GIL_TICKET_SLOTS 16
+#endif
+
+// NUMA MODE (topology-aware handoff):
+//
+// FASTCOND_GIL_NUMA (default: 0)
+//   On multi-socket machines a handoff to a thread on another NUMA node drags the
+//   interpreter's hot cache lines across the interconnect.  When enabled, waiters park on a
+//   condition variable for the node they are running on, and a release wakes a waiter on the
+//   releasing thread's own node when there is one.  Node numbers come from
+//   native_current_node(); threads may migrate, so this is a preference, not a guarantee.
+//   Not available in NAIVE or TICKET mode; combines with I/O boost, whose boosted waiters
+//   still come first.
+//
+// FASTCOND_GIL_NUMA_NODES (default: 8)
+//   Nodes tracked separately; higher node numbers share a condition variable modulo this.
+// FASTCOND_GIL_NUMA_MAX_STREAK (default: 4)
+//   Consecutive same-node handoffs, while other nodes have waiters, after which the next
+//   handoff goes to another node, so a busy node cannot starve the rest.
+#ifndef FASTCOND_GIL_NUMA
+#define FASTCOND_GIL_NUMA 0
+#endif
+#ifndef FASTCOND_GIL_NUMA_NODES
+#define FASTCOND_GIL_NUMA_NODES 8
+#endif
+
+// PRIORITY MODE (waiter classes):
+//
+// FASTCOND_GIL_PRIO (default: 0)
+//   A few latency-critical threads, such as a network reactor or a heartbeat, should not
+//   queue behind batch workers.  fastcond_gil_acquire_prio() acquires in one of
+//   FASTCOND_GIL_PRIO_LEVELS classes, 0 being that of the plain calls and higher levels
+//   more urgent.  Each class parks on its own condition variable; release and yield wake
+//   the highest class with waiters, and a free GIL is left to it rather than taken by a
+//   thread of a lower class.  The class holds until the thread's release, so yields and
+//   condition variable waits in between keep it.  In RECURSIVE mode that is the outermost
+//   release, and a nested fastcond_gil_acquire_prio() leaves the class of the hold as it is.
+//   Not available in NAIVE or TICKET mode, nor with I/O boost or NUMA handoff, which choose
+//   the waiter to wake in their own ways.
+//
+// FASTCOND_GIL_PRIO_LEVELS (default: 3)
+//   Number of classes.
+// FASTCOND_GIL_PRIO_AGING (default: 8)
+//   Starvation protection: a class with waiters rises one level for every this many
+//   acquisitions by other classes, back to its own level once one of it is served.
+#ifndef FASTCOND_GIL_PRIO
+#define FASTCOND_GIL_PRIO 0
+#endif
+#ifndef FASTCOND_GIL_PRIO_LEVELS
+#define FASTCOND_GIL_PRIO_LEVELS 3
+#endif
+
+// RECURSIVE MODE:
+//
+// FASTCOND_GIL_RECURSIVE (default: 0)
+//   Lets a thread that already holds the GIL call fastcond_gil_acquire() again, as happens
+//   when GIL-taking callbacks are invoked from code that may already hold it.  The owner
+//   and nesting depth live in the GIL itself: a nested acquire is a check of depth and
+//   owner followed by an increment, with no mutex, and only the outermost
+//   fastcond_gil_release() really releases.  fastcond_gil_yield() always lets go fully,
+//   then restores the depth once the GIL is back.  Works with every mode.
+#ifndef FASTCOND_GIL_RECURSIVE
+#define FASTCOND_GIL_RECURSIVE 0
+#endif
+
+// SPIN-BEFORE-PARK:
+//
+// FASTCOND_GIL_SPIN (default: 0)
+//   When the GIL is held only for a microsecond or two, as with fine-grained yields, a thread
+//   entering fastcond_gil_acquire() pays far more for sleeping in fastcond_cond_wait() and
+//   being woken again than it would for simply watching the holder finish.  When enabled,
+//   acquire() first spins on `held` with CPU pause instructions, for up to twice the
+//   observed average hold time, before taking the mutex and registering in n_waiting.
+//   Spinning is skipped when there are more running contenders (holder, spinners and the
+//   caller) than CPUs, since the spinner would then steal the holder's CPU, and when the
+//   average hold exceeds FASTCOND_GIL_SPIN_MAX_NS.  Not available in NAIVE or TICKET mode.
+//
+// FASTCOND_GIL_SPIN_MAX_NS (default: 10000)
+//   Upper bound on the spin budget; longer average holds disable spinning altogether.
+#ifndef FASTCOND_GIL_SPIN
+#define FASTCOND_GIL_SPIN 0
+#endif
+
+// STATISTICS:
+//
+// FASTCOND_GIL_STATS (default: 0)
+//   Built-in instrumentation for production use: log2-bucketed histograms of hold time,
+//   wait time and handoff latency, plus per-thread acquisition counts.  All recording is
+//   done under the GIL's internal mutex, which the acquire/release paths take anyway, so
+//   the cost is a few clock reads and counter updates per operation.  Read a consistent
+//   snapshot with fastcond_gil_get_stats().  Not available in NAIVE mode, which has no
+//   bookkeeping to hang it on.
+#ifndef FASTCOND_GIL_STATS
+#define FASTCOND_GIL_STATS 0
+#endif
+
+// Bucket i counts durations in [2^i, 2^(i+1)) nanoseconds; the last bucket is open-ended
+#define FASTCOND_GIL_STATS_BUCKETS 32
+// Threads beyond this many are counted in untracked_acquisitions only
+#define FASTCOND_GIL_STATS_MAX_THREADS 64
+
+struct fastcond_gil_histogram {
+    unsigned long long count;
+    unsigned long long sum_ns;
+    unsigned long long max_ns;
+    unsigned long long buckets[FASTCOND_GIL_STATS_BUCKETS];
+};
+
+struct fastcond_gil_thread_stats {
+    native_thread_t thread;
+    unsigned long long acquisitions;
+};
+
+struct fastcond_gil_stats {
+    struct fastcond_gil_histogram hold;    // acquisition to release (or yield)
+    struct fastcond_gil_histogram wait;    // entry to acquire()/yield() until ownership
+    struct fastcond_gil_histogram handoff; // release by one thread to acquisition by a waiter
+    unsigned long long acquisitions;       // including re-acquisitions inside yield()
+    unsigned long long contended;          // acquisitions that had to wait
+    unsigned long long untracked_acquisitions; // by threads that did not fit in threads[]
+    int n_threads;                             // valid entries in threads[]
+    struct fastcond_gil_thread_stats threads[FASTCOND_GIL_STATS_MAX_THREADS];
+};
+
+// GIL-AWARE CONDITION VARIABLES:
+//
+// Interpreter-level condition variables (Python's threading.Condition) are used under the
+// GIL.  Waiting on one with an ordinary mutex means releasing the GIL, sleeping on the
+// condition variable, and then sleeping again in fastcond_gil_acquire() when the signaller
+// still holds the GIL.  fastcond_gil_cond_wait() uses the GIL itself as the mutex: the
+// release and the wait are atomic, and the GIL is retaken on the way out.  Signals sent
+// with fastcond_gil_cond_signal()/_broadcast() are held back until the signaller releases
+// or yields the GIL, so the waiter wakes when it can actually run.
+//
+// FASTCOND_GIL_COND_DEFERRED (default: 4)
+//   Signals the holder may queue; one more sends the queue at once, taking the GIL's mutex
+//   for it (in NAIVE mode the holder owns that mutex already).
+#ifndef FASTCOND_GIL_COND_DEFERRED
+#define FASTCOND_GIL_COND_DEFERRED 4
+#endif
+
 #if FASTCOND_GIL_USE_NATIVE_COND
-    native_cond_t cond;
+typedef native_cond_t fastcond_gil_cond_t;
+#else
+typedef fastcond_cond_t fastcond_gil_cond_t;
+#endif
+
+#if FASTCOND_GIL_USE_FASTCOND_MUTEX
+typedef fastcond_mutex_t fastcond_gil_mutex_t;
 #else
-    fastcond_cond_t cond;
+typedef native_mutex_t fastcond_gil_mutex_t;
 #endif
-    native_mutex_t mutex;
+
+struct fastcond_gil {
+#if FASTCOND_GIL_USE_FUTEX
+    volatile int futex;         // FASTCOND_GIL_FUTEX_HELD | waiters * FASTCOND_GIL_FUTEX_WAITER
+    native_thread_t last_owner; // written by each new owner, read for fairness
+#else
+    fastcond_gil_cond_t cond;
+    fastcond_gil_mutex_t mutex;
     native_thread_t last_owner;
     volatile int held;      // volatile: ensures memory visibility across threads
     volatile int n_waiting; // volatile: prevents compiler caching in wait loops
+    int n_deferred;         // condition variable signals queued by the holder
+    fastcond_gil_cond_t *deferred[FASTCOND_GIL_COND_DEFERRED];
+    char deferred_broadcast[FASTCOND_GIL_COND_DEFERRED];
+#endif
+#if FASTCOND_GIL_IO_BOOST
+    fastcond_gil_cond_t boost_cond; // I/O-bound waiters park here
+    volatile int n_boost_waiting;   // subset of n_waiting parked on boost_cond
+    int boost_streak;               // consecutive acquisitions by boosted threads
+#endif
+#if FASTCOND_GIL_MODE_TICKET
+    unsigned int next_ticket;          // next ticket to hand out
+    volatile unsigned int now_serving; // ticket whose holder owns (or may take) the GIL
+    int ticket_waiting[FASTCOND_GIL_TICKET_SLOTS]; // waiters parked on each slot
+    fastcond_gil_cond_t ticket_cond[FASTCOND_GIL_TICKET_SLOTS];
+    unsigned int ticket_abandoned[FASTCOND_GIL_TICKET_SLOTS]; // timed-out ticket to skip
+    char ticket_abandoned_set[FASTCOND_GIL_TICKET_SLOTS];     // ticket_abandoned is valid
+#endif
+#if FASTCOND_GIL_NUMA
+    fastcond_gil_cond_t node_cond[FASTCOND_GIL_NUMA_NODES];
+    volatile int node_waiting[FASTCOND_GIL_NUMA_NODES]; // subset of n_waiting on each node
+    int node_streak; // consecutive same-node handoffs while other nodes waited
+#endif
+#if FASTCOND_GIL_PRIO
+    fastcond_gil_cond_t prio_cond[FASTCOND_GIL_PRIO_LEVELS];
+    volatile int prio_waiting[FASTCOND_GIL_PRIO_LEVELS]; // subset of n_waiting in each class
+    int prio_passed[FASTCOND_GIL_PRIO_LEVELS]; // acquisitions by other classes while waiting
+    int prio_next; // class the last release woke, which a free GIL is kept for; -1 if none
+#endif
+#if FASTCOND_GIL_RECURSIVE
+    native_thread_t owner; // current owner; only meaningful while depth > 0
+    volatile int depth;    // nesting depth of the owner's acquires, 0 when free
+#endif
+#if FASTCOND_GIL_SPIN
+    int n_cpus;                     // online CPUs, sampled at init
+    volatile int n_spinning;        // threads in the spin phase (atomic, no mutex)
+    long long hold_start_ns;        // when the current owner got the GIL
+    volatile long long hold_avg_ns; // smoothed hold time (EWMA, weight 1/8), owner-written
+#endif
+#if FASTCOND_GIL_STATS
+    long long stats_acquired_ns; // when the current owner got the GIL
+    long long stats_released_ns; // when the GIL was last released
+    struct fastcond_gil_stats stats;
+#endif
 };
 
+// PER-THREAD CONTEXT:
+//
+// Every GIL operation needs the caller's identity, and the I/O boost classifier keeps a
+// history per thread.  The plain API finds both through a thread-local context created on
+// first use.  A thread doing many GIL operations can instead register its own context once,
+// with fastcond_gil_thread_init() on that thread, and pass it to the _ctx variants; the
+// cached id then replaces the thread-local lookup, and the counters below give per-thread
+// statistics in any build.  The context holds no OS resources and needs no teardown.
+//
+// One context belongs to one thread and may be used with any number of GILs.  Use either
+// the plain or the _ctx calls for a given acquisition: release_ctx() after a plain
+// acquire() is fine, but the two keep separate I/O boost histories.
+typedef struct fastcond_gil_thread {
+    native_thread_t id;              // the owning thread, cached at init
+    unsigned long long acquisitions; // outermost acquisitions, including those inside yield()
+    unsigned long long contended;    // ... of which had to wait
+#if FASTCOND_GIL_IO_BOOST
+    long long io_burst_start_ns; // when the current burst began
+    long long io_release_ns;     // when the thread last released a GIL, 0 if never
+    long long io_burst_avg_ns;   // smoothed burst length (EWMA, weight 1/4)
+#endif
+#if FASTCOND_GIL_PRIO
+    int prio; // class of the current hold, 0 outside fastcond_gil_acquire_prio()
+#endif
+} fastcond_gil_thread_t;
+
 // Function declarations
 void fastcond_gil_init(struct fastcond_gil *gil);
 void fastcond_gil_destroy(struct fastcond_gil *gil);
@@ -60,3 +375,43 @@ void fastcond_gil_acquire(struct fastcond_gil *gil);
 void fastcond_gil_release(struct fastcond_gil *gil);
 void fastcond_gil_yield(
     struct fastcond_gil *gil); // Release and immediately reacquire (cooperative yielding)
+
+// Take the GIL only if that needs no waiting: it is free and, under the current fairness
+// rules, the caller may have it now.  Returns 0 on success or EBUSY.
+int fastcond_gil_try_acquire(struct fastcond_gil *gil);
+
+// As fastcond_gil_acquire(), but give up after timeout_us microseconds.  A thread that
+// times out leaves no trace in the GIL's waiter accounting and passes on any wakeup it
+// was handed.  Returns 0 on success or ETIMEDOUT; ENOSYS in NAIVE mode, which has no
+// portable timed lock (a timeout <= 0 still works there, as a try-acquire).
+int fastcond_gil_acquire_timeout(struct fastcond_gil *gil, long long timeout_us);
+
+// As fastcond_gil_acquire(), waiting in priority class level, 0 <= level <
+// FASTCOND_GIL_PRIO_LEVELS; see PRIORITY MODE above.  Without FASTCOND_GIL_PRIO the level
+// is checked and otherwise ignored.  Returns 0, or EINVAL for a bad level.
+int fastcond_gil_acquire_prio(struct fastcond_gil *gil, int level);
+
+// Set up a context for the calling thread; see PER-THREAD CONTEXT above
+void fastcond_gil_thread_init(fastcond_gil_thread_t *thread);
+
+// As the plain calls, for the thread that owns the context
+void fastcond_gil_acquire_ctx(struct fastcond_gil *gil, fastcond_gil_thread_t *thread);
+void fastcond_gil_release_ctx(struct fastcond_gil *gil, fastcond_gil_thread_t *thread);
+void fastcond_gil_yield_ctx(struct fastcond_gil *gil, fastcond_gil_thread_t *thread);
+
+// Wait on cond with the GIL as its mutex; see GIL-AWARE CONDITION VARIABLES above.
+// cond is the backend's condition variable: initialise it with fastcond_cond_init(), or
+// NATIVE_COND_INIT() with FASTCOND_GIL_USE_NATIVE_COND, and always use it with the same
+// GIL.  The caller must hold the GIL, and holds it again on return, which may be
+// spurious.  In RECURSIVE mode the GIL is let go whatever the nesting, as by yield().
+// Returns 0, or ENOSYS with the futex backend, which has no mutex to wait with.
+int fastcond_gil_cond_wait(struct fastcond_gil *gil, fastcond_gil_cond_t *cond);
+
+// Wake one (signal) or all (broadcast) waiters on cond once the caller, which must hold the
+// GIL, next releases or yields it.  Returns 0, or ENOSYS with the futex backend.
+int fastcond_gil_cond_signal(struct fastcond_gil *gil, fastcond_gil_cond_t *cond);
+int fastcond_gil_cond_broadcast(struct fastcond_gil *gil, fastcond_gil_cond_t *cond);
+
+// Copy a consistent snapshot of the GIL statistics into *stats.
+// Returns 0 on success, ENOSYS if the GIL was built without FASTCOND_GIL_STATS.
+int fastcond_gil_get_stats(struct fastcond_gil *gil, struct fastcond_gil_stats *stats);
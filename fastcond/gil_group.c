@@ -0,0 +1,277 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#include "gil_group.h"
+#include "gil.h" /* fastcond_gil_cond_t, FASTCOND_GIL_USE_NATIVE_COND */
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Slots are padded and aligned to this many bytes
+#ifndef FASTCOND_CACHE_LINE
+#define FASTCOND_CACHE_LINE 64
+#endif
+
+// Park nodes are allocated this many at a time
+#define GIL_PARK_CHUNK 16
+
+// GROUP_COND_INIT() returns 0 on success
+#if FASTCOND_GIL_USE_NATIVE_COND
+#ifdef NATIVE_USE_WINDOWS
+#define GROUP_COND_INIT(cond) (NATIVE_COND_INIT(cond), 0) // cannot fail
+#else
+#define GROUP_COND_INIT(cond) NATIVE_COND_INIT(cond)
+#endif
+#define GROUP_COND_DESTROY(cond) NATIVE_COND_DESTROY(cond)
+#define GROUP_COND_WAIT(cond, mutex) NATIVE_COND_WAIT((cond), (mutex))
+#define GROUP_COND_SIGNAL(cond) NATIVE_COND_SIGNAL(cond)
+#else
+#define GROUP_COND_INIT(cond) fastcond_cond_init((cond), NULL)
+#define GROUP_COND_DESTROY(cond) fastcond_cond_fini(cond)
+#define GROUP_COND_WAIT(cond, mutex) fastcond_cond_wait((cond), (mutex))
+#define GROUP_COND_SIGNAL(cond) fastcond_cond_signal(cond)
+#endif
+
+// Where a parked thread sleeps.  A node has one waiter at a time, which waits on it with
+// the mutex of whatever slot it is queued on; both backends allow that, as no two threads
+// ever wait on the node with different mutexes at once.
+struct gil_park {
+    fastcond_gil_cond_t cond;
+    struct gil_park *next; // slot queue or pool free list
+    int woken;             // set, under the slot mutex, by the thread that dequeued us
+};
+
+struct gil_park_chunk {
+    struct gil_park_chunk *next;
+    struct gil_park nodes[GIL_PARK_CHUNK];
+};
+
+// One GIL.  The wait queue is a circular list reached through its tail, so one pointer
+// serves for both ends and the slot fits a single 64-byte line with a glibc mutex.
+struct gil_slot {
+    native_mutex_t mutex;
+    native_thread_t last_owner;
+    int held;
+    int n_waiting;         // parked, including woken threads that have not yet run
+    struct gil_park *tail; // last waiter; tail->next is the first; NULL when empty
+};
+
+struct fastcond_gil_group {
+    int n_gils;
+    size_t stride;   // slot size rounded up to FASTCOND_CACHE_LINE
+    char *slots;     // first slot, cache-line aligned
+    void *slots_raw; // the allocation slots lives in
+    native_mutex_t pool_mutex;
+    struct gil_park *free_parks;
+    struct gil_park_chunk *chunks;
+    int n_parks;
+};
+
+static inline struct gil_slot *_slot(struct fastcond_gil_group *group, int index)
+{
+    assert(index >= 0 && index < group->n_gils);
+    return (struct gil_slot *) (group->slots + (size_t) index * group->stride);
+}
+
+// Take a park node from the pool, growing it if empty.  Called with a slot mutex held; the
+// pool mutex always nests inside slot mutexes, never the other way round.
+static struct gil_park *_park_get(struct fastcond_gil_group *group)
+{
+    struct gil_park *node;
+
+    NATIVE_MUTEX_LOCK(&group->pool_mutex);
+    if (!group->free_parks) {
+        struct gil_park_chunk *chunk = malloc(sizeof(*chunk));
+        int i = 0;
+        if (chunk) {
+            for (; i < GIL_PARK_CHUNK; i++) {
+                if (GROUP_COND_INIT(&chunk->nodes[i].cond) != 0)
+                    break;
+                chunk->nodes[i].next = i + 1 < GIL_PARK_CHUNK ? &chunk->nodes[i + 1] : NULL;
+            }
+        }
+        if (i < GIL_PARK_CHUNK) {
+            // the whole chunk fails: undo the nodes already set up
+            while (i > 0)
+                GROUP_COND_DESTROY(&chunk->nodes[--i].cond);
+            free(chunk);
+            NATIVE_MUTEX_UNLOCK(&group->pool_mutex);
+            abort(); // cannot park and cannot report it: the GIL API returns void
+        }
+        chunk->next = group->chunks;
+        group->chunks = chunk;
+        group->free_parks = &chunk->nodes[0];
+        group->n_parks += GIL_PARK_CHUNK;
+    }
+    node = group->free_parks;
+    group->free_parks = node->next;
+    NATIVE_MUTEX_UNLOCK(&group->pool_mutex);
+    return node;
+}
+
+static void _park_put(struct fastcond_gil_group *group, struct gil_park *node)
+{
+    NATIVE_MUTEX_LOCK(&group->pool_mutex);
+    node->next = group->free_parks;
+    group->free_parks = node;
+    NATIVE_MUTEX_UNLOCK(&group->pool_mutex);
+}
+
+// Park on the slot's queue until a release dequeues us.  A thread that was woken but lost
+// the GIL to a greedy acquirer goes back in at the front, keeping its place.
+// Caller holds slot->mutex.
+static void _slot_wait(struct fastcond_gil_group *group, struct gil_slot *slot, int front)
+{
+    struct gil_park *node = _park_get(group);
+
+    node->woken = 0;
+    if (!slot->tail) {
+        node->next = node;
+        slot->tail = node;
+    } else {
+        node->next = slot->tail->next;
+        slot->tail->next = node;
+        if (!front)
+            slot->tail = node;
+    }
+    slot->n_waiting++;
+    while (!node->woken)
+        GROUP_COND_WAIT(&node->cond, &slot->mutex);
+    slot->n_waiting--;
+    _park_put(group, node);
+}
+
+// Wake the first parked waiter, if any.  Caller holds slot->mutex.
+static void _slot_wake(struct gil_slot *slot)
+{
+    struct gil_park *node;
+
+    if (!slot->tail)
+        return;
+    node = slot->tail->next;
+    if (node == slot->tail)
+        slot->tail = NULL;
+    else
+        slot->tail->next = node->next;
+    node->woken = 1;
+    GROUP_COND_SIGNAL(&node->cond);
+}
+
+int fastcond_gil_group_create(struct fastcond_gil_group **group, int n_gils)
+{
+    struct fastcond_gil_group *g;
+    size_t stride = (sizeof(struct gil_slot) + FASTCOND_CACHE_LINE - 1) &
+                    ~(size_t) (FASTCOND_CACHE_LINE - 1);
+    int i;
+
+    if (n_gils <= 0)
+        return EINVAL;
+    g = malloc(sizeof(*g));
+    if (!g)
+        return ENOMEM;
+    // C99 has no aligned allocation; over-allocate and align by hand
+    g->slots_raw = malloc(stride * (size_t) n_gils + FASTCOND_CACHE_LINE - 1);
+    if (!g->slots_raw) {
+        free(g);
+        return ENOMEM;
+    }
+    g->slots = (char *) (((uintptr_t) g->slots_raw + FASTCOND_CACHE_LINE - 1) &
+                         ~(uintptr_t) (FASTCOND_CACHE_LINE - 1));
+    g->stride = stride;
+    g->n_gils = n_gils;
+    for (i = 0; i < n_gils; i++) {
+        struct gil_slot *slot = _slot(g, i);
+        NATIVE_MUTEX_INIT(&slot->mutex);
+        slot->last_owner = NATIVE_THREAD_SELF();
+        slot->held = 0;
+        slot->n_waiting = 0;
+        slot->tail = NULL;
+    }
+    NATIVE_MUTEX_INIT(&g->pool_mutex);
+    g->free_parks = NULL;
+    g->chunks = NULL;
+    g->n_parks = 0;
+    *group = g;
+    return 0;
+}
+
+void fastcond_gil_group_destroy(struct fastcond_gil_group *group)
+{
+    int i;
+
+    for (i = 0; i < group->n_gils; i++) {
+        struct gil_slot *slot = _slot(group, i);
+        assert(!slot->held && !slot->tail);
+        NATIVE_MUTEX_DESTROY(&slot->mutex);
+    }
+    while (group->chunks) {
+        struct gil_park_chunk *chunk = group->chunks;
+        group->chunks = chunk->next;
+        for (i = 0; i < GIL_PARK_CHUNK; i++) {
+            GROUP_COND_DESTROY(&chunk->nodes[i].cond);
+        }
+        free(chunk);
+    }
+    NATIVE_MUTEX_DESTROY(&group->pool_mutex);
+    free(group->slots_raw);
+    free(group);
+}
+
+void fastcond_gil_group_acquire(struct fastcond_gil_group *group, int index)
+{
+    struct gil_slot *slot = _slot(group, index);
+    int front = 0;
+
+    NATIVE_MUTEX_LOCK(&slot->mutex);
+    // Greedy, as fastcond_gil_acquire() with FASTCOND_GIL_ACQUIRE_GREEDY
+    while (slot->held) {
+        _slot_wait(group, slot, front);
+        front = 1;
+    }
+    slot->held = 1;
+    slot->last_owner = NATIVE_THREAD_SELF();
+    NATIVE_MUTEX_UNLOCK(&slot->mutex);
+}
+
+void fastcond_gil_group_release(struct fastcond_gil_group *group, int index)
+{
+    struct gil_slot *slot = _slot(group, index);
+
+    NATIVE_MUTEX_LOCK(&slot->mutex);
+    assert(slot->held);
+    slot->held = 0;
+    _slot_wake(slot);
+    NATIVE_MUTEX_UNLOCK(&slot->mutex);
+}
+
+void fastcond_gil_group_yield(struct fastcond_gil_group *group, int index)
+{
+    struct gil_slot *slot = _slot(group, index);
+    native_thread_t self = NATIVE_THREAD_SELF();
+    int front = 0;
+
+    NATIVE_MUTEX_LOCK(&slot->mutex);
+    assert(slot->held);
+    slot->held = 0;
+    _slot_wake(slot);
+
+    // Fair, as fastcond_gil_yield() with FASTCOND_GIL_YIELD_FAIR: with others waiting, the
+    // previous owner goes to the back of the queue
+    while (slot->held || (slot->n_waiting > 0 && NATIVE_THREAD_EQUAL(slot->last_owner, self))) {
+        _slot_wait(group, slot, front);
+        front = 1;
+    }
+    slot->held = 1;
+    slot->last_owner = self;
+    NATIVE_MUTEX_UNLOCK(&slot->mutex);
+}
+
+void fastcond_gil_group_get_info(struct fastcond_gil_group *group,
+                                 struct fastcond_gil_group_info *info)
+{
+    info->n_gils = group->n_gils;
+    info->slot_size = group->stride;
+    NATIVE_MUTEX_LOCK(&group->pool_mutex);
+    info->park_nodes = group->n_parks;
+    NATIVE_MUTEX_UNLOCK(&group->pool_mutex);
+}
@@ -0,0 +1,50 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#ifndef _FASTCOND_GIL_GROUP_H_
+#define _FASTCOND_GIL_GROUP_H_
+
+#include "native_primitives.h"
+#include <stddef.h>
+
+// A GIL GROUP: many GILs allocated together, e.g. one per subinterpreter.
+//
+// Every struct fastcond_gil carries its own mutex and condition variable, and with the
+// fastcond backend every condition variable owns a semaphore.  At dozens of GILs per process
+// that is dozens of mostly idle kernel objects, in structures laid out wherever the caller
+// put them, so one GIL's traffic can invalidate a neighbour's cache line.
+//
+// A group keeps each GIL in its own cache-line-aligned slot holding only a mutex, the GIL
+// state and a FIFO of parked waiters.  Threads park on nodes from a pool shared by the whole
+// group, one condition variable per node, so the number of semaphores follows the number of
+// threads parked at the same time rather than the number of GILs.  A release wakes the
+// waiter at the head of that GIL's queue directly, whichever GIL it is.
+//
+// Semantics match the default struct fastcond_gil: acquire() is greedy, yield() is fair.
+// The condition variable backend follows FASTCOND_GIL_USE_NATIVE_COND, as for gil.c.
+// GILs are addressed by index, 0 <= index < n_gils.
+
+struct fastcond_gil_group;
+
+// Footprint of a group, for benchmarks and capacity planning
+struct fastcond_gil_group_info {
+    int n_gils;
+    size_t slot_size; // bytes per GIL, including cache-line padding
+    int park_nodes;   // park nodes allocated so far: the peak number of parked threads,
+                      // rounded up to the allocation chunk
+};
+
+// Allocate a group of n_gils GILs, all free.  Returns 0, EINVAL or ENOMEM.
+int fastcond_gil_group_create(struct fastcond_gil_group **group, int n_gils);
+
+// Free the group and its park nodes.  No GIL in it may be held or waited for.
+void fastcond_gil_group_destroy(struct fastcond_gil_group *group);
+
+void fastcond_gil_group_acquire(struct fastcond_gil_group *group, int index);
+void fastcond_gil_group_release(struct fastcond_gil_group *group, int index);
+void fastcond_gil_group_yield(struct fastcond_gil_group *group,
+                              int index); // Release and immediately reacquire
+
+void fastcond_gil_group_get_info(struct fastcond_gil_group *group,
+                                 struct fastcond_gil_group_info *info);
+
+#endif /* ! defined _FASTCOND_GIL_GROUP_H_ */
@@ -23,6 +23,16 @@
 #define NATIVE_USE_POSIX 1
 #endif
 
+#include <errno.h> /* ETIMEDOUT, EBUSY */
+#include <time.h>  /* struct timespec, clock_gettime() / timespec_get() */
+#ifndef NATIVE_USE_WINDOWS
+#include <unistd.h> /* sysconf() for native_cpu_count() */
+#endif
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h> /* SYS_getcpu, SYS_futex */
+#endif
+
 /*
  * Thread ID abstraction
  * Windows: Use GetCurrentThreadId() which returns DWORD
@@ -38,6 +48,253 @@ typedef pthread_t native_thread_t;
 #define NATIVE_THREAD_EQUAL(t1, t2) pthread_equal((t1), (t2))
 #endif
 
+/*
+ * Thread-local storage qualifier
+ * The library is C99, which predates _Thread_local, so use the compiler
+ * extensions: __declspec(thread) on MSVC, __thread on GCC/Clang.
+ */
+#ifdef _MSC_VER
+#define NATIVE_THREAD_LOCAL __declspec(thread)
+#else
+#define NATIVE_THREAD_LOCAL __thread
+#endif
+
+/*
+ * Monotonic clock in nanoseconds
+ * Used by GIL modes that classify threads by how long they hold or release
+ * the GIL, and as the clock of fastcond_cond_clockwait() deadlines.  Only
+ * differences between two readings are meaningful.
+ * Windows: QueryPerformanceCounter
+ * POSIX: clock_gettime(CLOCK_MONOTONIC), a vDSO call on Linux and macOS
+ */
+#ifdef NATIVE_USE_WINDOWS
+static inline long long native_monotonic_ns(void)
+{
+    static LARGE_INTEGER frequency = {0};
+    LARGE_INTEGER counter;
+
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (long long) (counter.QuadPart / frequency.QuadPart) * 1000000000LL +
+           (long long) ((counter.QuadPart % frequency.QuadPart) * 1000000000LL /
+                        frequency.QuadPart);
+}
+#else
+static inline long long native_monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+#endif
+
+/*
+ * Absolute deadline for timed waits
+ * NATIVE_COND_TIMEDWAIT and fastcond_cond_timedwait take an absolute wall-clock
+ * deadline (CLOCK_REALTIME, TIME_UTC on Windows).  This fills in the one that
+ * lies timeout_us microseconds from now.
+ */
+static inline void native_deadline_us(struct timespec *ts, long long timeout_us)
+{
+#ifdef NATIVE_USE_WINDOWS
+    timespec_get(ts, TIME_UTC);
+#else
+    clock_gettime(CLOCK_REALTIME, ts);
+#endif
+    if (timeout_us < 0)
+        timeout_us = 0;
+    ts->tv_sec += (time_t) (timeout_us / 1000000);
+    ts->tv_nsec += (long) (timeout_us % 1000000) * 1000;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+/*
+ * Number of online CPUs, at least 1
+ * Used to decide whether spinning can pay off: a spinner only helps if the
+ * thread it is waiting for has a CPU of its own to run on.
+ */
+#ifdef NATIVE_USE_WINDOWS
+static inline int native_cpu_count(void)
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors > 0 ? (int) si.dwNumberOfProcessors : 1;
+}
+#else
+static inline int native_cpu_count(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int) n : 1;
+}
+#endif
+
+/*
+ * NUMA node of the CPU the caller is running on, 0 if unknown
+ * The answer may be stale as soon as it is returned; use it as a placement hint.
+ * Linux: getcpu(2) through syscall(), since older glibc has no wrapper.  It is a
+ *        real system call, so keep it off fast paths.
+ * Windows: GetCurrentProcessorNumberEx + GetNumaProcessorNodeEx
+ * Others (macOS has no NUMA): always 0
+ */
+#if defined(NATIVE_USE_WINDOWS)
+static inline int native_current_node(void)
+{
+    PROCESSOR_NUMBER pn;
+    USHORT node;
+
+    GetCurrentProcessorNumberEx(&pn);
+    return GetNumaProcessorNodeEx(&pn, &node) ? (int) node : 0;
+}
+#elif defined(__linux__) && defined(SYS_getcpu)
+static inline int native_current_node(void)
+{
+    unsigned int cpu, node;
+    return syscall(SYS_getcpu, &cpu, &node, NULL) == 0 ? (int) node : 0;
+}
+#else
+static inline int native_current_node(void)
+{
+    return 0;
+}
+#endif
+
+/*
+ * Futex wait and wake (Linux only; NATIVE_HAVE_FUTEX says whether they exist)
+ * native_futex_wait() sleeps while *addr == val, until woken or until abstime passes
+ * (CLOCK_REALTIME, as native_deadline_us() gives; NULL to wait indefinitely).  Returns 0
+ * on a wakeup, which may be spurious, EAGAIN if *addr != val already, ETIMEDOUT or EINTR.
+ * Process-private: the word must not live in memory shared with other processes.
+ */
+#if defined(__linux__) && defined(SYS_futex)
+#define NATIVE_HAVE_FUTEX 1
+static inline int native_futex_wait(volatile int *addr, int val, const struct timespec *abstime)
+{
+    if (syscall(SYS_futex, addr, FUTEX_WAIT_BITSET_PRIVATE | FUTEX_CLOCK_REALTIME, val, abstime,
+                NULL, FUTEX_BITSET_MATCH_ANY) == 0)
+        return 0;
+    return errno;
+}
+
+static inline void native_futex_wake(volatile int *addr, int n)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+#else
+#define NATIVE_HAVE_FUTEX 0
+#endif
+
+/*
+ * Spin-wait hint
+ * Tells the CPU we are in a busy-wait loop: on x86 PAUSE saves power and
+ * avoids the memory-order mis-speculation penalty when the loop exits, on ARM
+ * YIELD lets a sibling hardware thread run.
+ */
+#if defined(_MSC_VER)
+#define NATIVE_CPU_RELAX() YieldProcessor()
+#elif defined(__i386__) || defined(__x86_64__)
+#define NATIVE_CPU_RELAX() __builtin_ia32_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define NATIVE_CPU_RELAX() __asm__ __volatile__("yield" ::: "memory")
+#else
+#define NATIVE_CPU_RELAX() ((void) 0)
+#endif
+
+/*
+ * Give up the rest of the time slice
+ * For spin loops that may be waiting on a preempted thread, which on a single
+ * CPU cannot make progress until the spinner steps aside.
+ */
+#ifdef NATIVE_USE_WINDOWS
+#define NATIVE_THREAD_YIELD() ((void) SwitchToThread())
+#else
+#include <sched.h>
+#define NATIVE_THREAD_YIELD() ((void) sched_yield())
+#endif
+
+/*
+ * Atomic operations on int
+ * Most of fastcond relies on a mutex for ordering and uses plain volatile
+ * fields.  These are for the few places that must touch shared state without
+ * the mutex, such as spin phases.
+ * GCC/Clang: __atomic builtins.  Loads are acquire, stores release, and
+ *            read-modify-write operations sequentially consistent.
+ * MSVC: Interlocked* functions, which are full barriers throughout.
+ */
+#ifdef _MSC_VER
+static inline int native_atomic_load(volatile int *p)
+{
+    return (int) InterlockedCompareExchange((volatile LONG *) p, 0, 0);
+}
+
+static inline void native_atomic_store(volatile int *p, int v)
+{
+    InterlockedExchange((volatile LONG *) p, v);
+}
+
+/* Add v and return the new value */
+static inline int native_atomic_add(volatile int *p, int v)
+{
+    return (int) InterlockedExchangeAdd((volatile LONG *) p, v) + v;
+}
+
+/* Replace expected with desired; nonzero on success */
+static inline int native_atomic_cas(volatile int *p, int expected, int desired)
+{
+    return InterlockedCompareExchange((volatile LONG *) p, desired, expected) == expected;
+}
+
+/* Store v and return the previous value */
+static inline int native_atomic_exchange(volatile int *p, int v)
+{
+    return (int) InterlockedExchange((volatile LONG *) p, v);
+}
+
+/* Full barrier, ordering earlier stores before later loads */
+static inline void native_atomic_fence(void)
+{
+    MemoryBarrier();
+}
+#else
+static inline int native_atomic_load(volatile int *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void native_atomic_store(volatile int *p, int v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+/* Add v and return the new value */
+static inline int native_atomic_add(volatile int *p, int v)
+{
+    return __atomic_add_fetch(p, v, __ATOMIC_SEQ_CST);
+}
+
+/* Replace expected with desired; nonzero on success */
+static inline int native_atomic_cas(volatile int *p, int expected, int desired)
+{
+    return __atomic_compare_exchange_n(p, &expected, desired, 0, __ATOMIC_SEQ_CST,
+                                       __ATOMIC_SEQ_CST);
+}
+
+/* Store v and return the previous value */
+static inline int native_atomic_exchange(volatile int *p, int v)
+{
+    return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST);
+}
+
+/* Full barrier, ordering earlier stores before later loads */
+static inline void native_atomic_fence(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+#endif
+
 /*
  * Mutex abstraction
  * Windows: Use CRITICAL_SECTION (faster than MUTEX on Windows)
@@ -49,17 +306,134 @@ typedef pthread_t native_thread_t;
  */
 #ifdef NATIVE_USE_WINDOWS
 typedef CRITICAL_SECTION native_mutex_t;
-#define NATIVE_MUTEX_INIT(mutex) InitializeCriticalSection(mutex)
 #define NATIVE_MUTEX_DESTROY(mutex) DeleteCriticalSection(mutex)
 /* Windows critical section functions return void, wrap to return 0 for success */
 #define NATIVE_MUTEX_LOCK(mutex) (EnterCriticalSection(mutex), 0)
 #define NATIVE_MUTEX_UNLOCK(mutex) (LeaveCriticalSection(mutex), 0)
+#define NATIVE_MUTEX_TRYLOCK(mutex) (TryEnterCriticalSection(mutex) ? 0 : EBUSY)
 #else
 typedef pthread_mutex_t native_mutex_t;
-#define NATIVE_MUTEX_INIT(mutex) pthread_mutex_init(mutex, NULL)
 #define NATIVE_MUTEX_DESTROY(mutex) pthread_mutex_destroy(mutex)
 #define NATIVE_MUTEX_LOCK(mutex) pthread_mutex_lock(mutex)
 #define NATIVE_MUTEX_UNLOCK(mutex) pthread_mutex_unlock(mutex)
+#define NATIVE_MUTEX_TRYLOCK(mutex) pthread_mutex_trylock(mutex)
+#endif
+
+/*
+ * Mutex kind
+ * NATIVE_MUTEX_INIT() creates mutexes of the kind NATIVE_MUTEX_KIND, chosen at build time:
+ *   NATIVE_MUTEX_KIND_DEFAULT     the platform default (NULL attributes)
+ *   NATIVE_MUTEX_KIND_ADAPTIVE    spins briefly before sleeping, for throughput under short
+ *                                 critical sections: PTHREAD_MUTEX_ADAPTIVE_NP (glibc), or a
+ *                                 spin count of NATIVE_MUTEX_SPIN_COUNT (Windows)
+ *   NATIVE_MUTEX_KIND_ERRORCHECK  PTHREAD_MUTEX_ERRORCHECK: relocking, or unlocking a mutex
+ *                                 the caller does not hold, fails with EDEADLK or EPERM
+ *   NATIVE_MUTEX_KIND_PI          PTHREAD_PRIO_INHERIT: the holder runs at the priority of
+ *                                 the highest-priority thread blocked on the mutex, so a
+ *                                 real-time thread is not held up by a preempted low-priority
+ *                                 holder (priority inversion)
+ * A kind the platform lacks is a build error.  native_mutex_init_kind() takes the kind as
+ * an argument instead, returning 0 or an errno value (ENOTSUP for a kind the platform lacks).
+ */
+#define NATIVE_MUTEX_KIND_DEFAULT 0
+#define NATIVE_MUTEX_KIND_ADAPTIVE 1
+#define NATIVE_MUTEX_KIND_ERRORCHECK 2
+#define NATIVE_MUTEX_KIND_PI 3
+
+#ifndef NATIVE_MUTEX_KIND
+#define NATIVE_MUTEX_KIND NATIVE_MUTEX_KIND_DEFAULT
+#endif
+
+#ifdef NATIVE_USE_WINDOWS
+#ifndef NATIVE_MUTEX_SPIN_COUNT
+#define NATIVE_MUTEX_SPIN_COUNT 4000
+#endif
+#define NATIVE_HAVE_MUTEX_ADAPTIVE 1
+#define NATIVE_HAVE_MUTEX_ERRORCHECK 0
+#define NATIVE_HAVE_MUTEX_PI 0
+
+static inline int native_mutex_init_kind(native_mutex_t *mutex, int kind)
+{
+    switch (kind) {
+    case NATIVE_MUTEX_KIND_DEFAULT:
+        InitializeCriticalSection(mutex);
+        return 0;
+    case NATIVE_MUTEX_KIND_ADAPTIVE:
+        return InitializeCriticalSectionAndSpinCount(mutex, NATIVE_MUTEX_SPIN_COUNT) ? 0 : ENOMEM;
+    case NATIVE_MUTEX_KIND_ERRORCHECK:
+    case NATIVE_MUTEX_KIND_PI:
+        return ENOTSUP;
+    default:
+        return EINVAL;
+    }
+}
+
+#if NATIVE_MUTEX_KIND == NATIVE_MUTEX_KIND_DEFAULT
+#define NATIVE_MUTEX_INIT(mutex) InitializeCriticalSection(mutex)
+#endif
+#else
+/* PTHREAD_MUTEX_ADAPTIVE_NP is a glibc extension (an enumerator, so not testable itself) */
+#ifdef __GLIBC__
+#define NATIVE_HAVE_MUTEX_ADAPTIVE 1
+#else
+#define NATIVE_HAVE_MUTEX_ADAPTIVE 0
+#endif
+#define NATIVE_HAVE_MUTEX_ERRORCHECK 1
+#if defined(_POSIX_THREAD_PRIO_INHERIT) && _POSIX_THREAD_PRIO_INHERIT > 0
+#define NATIVE_HAVE_MUTEX_PI 1
+#else
+#define NATIVE_HAVE_MUTEX_PI 0
+#endif
+
+static inline int native_mutex_init_kind(native_mutex_t *mutex, int kind)
+{
+    pthread_mutexattr_t attr;
+    int err;
+
+    if (kind == NATIVE_MUTEX_KIND_DEFAULT)
+        return pthread_mutex_init(mutex, NULL);
+    err = pthread_mutexattr_init(&attr);
+    if (err)
+        return err;
+    switch (kind) {
+    case NATIVE_MUTEX_KIND_ADAPTIVE:
+#if NATIVE_HAVE_MUTEX_ADAPTIVE
+        err = pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ADAPTIVE_NP);
+#else
+        err = ENOTSUP;
+#endif
+        break;
+    case NATIVE_MUTEX_KIND_ERRORCHECK:
+        err = pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ERRORCHECK);
+        break;
+    case NATIVE_MUTEX_KIND_PI:
+#if NATIVE_HAVE_MUTEX_PI
+        err = pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+#else
+        err = ENOTSUP;
+#endif
+        break;
+    default:
+        err = EINVAL;
+    }
+    if (!err)
+        err = pthread_mutex_init(mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    return err;
+}
+
+#if NATIVE_MUTEX_KIND == NATIVE_MUTEX_KIND_DEFAULT
+#define NATIVE_MUTEX_INIT(mutex) pthread_mutex_init(mutex, NULL)
+#endif
+#endif
+
+#if NATIVE_MUTEX_KIND != NATIVE_MUTEX_KIND_DEFAULT
+#if (NATIVE_MUTEX_KIND == NATIVE_MUTEX_KIND_ADAPTIVE && !NATIVE_HAVE_MUTEX_ADAPTIVE) ||           \
+    (NATIVE_MUTEX_KIND == NATIVE_MUTEX_KIND_ERRORCHECK && !NATIVE_HAVE_MUTEX_ERRORCHECK) ||       \
+    (NATIVE_MUTEX_KIND == NATIVE_MUTEX_KIND_PI && !NATIVE_HAVE_MUTEX_PI)
+#error "NATIVE_MUTEX_KIND names a mutex kind this platform does not provide"
+#endif
+#define NATIVE_MUTEX_INIT(mutex) native_mutex_init_kind((mutex), NATIVE_MUTEX_KIND)
 #endif
 
 /*
@@ -76,14 +450,37 @@ typedef pthread_mutex_t native_mutex_t;
  * The fastcond library uses GCD semaphores internally but provides its own
  * condition variable API on top.
  *
+ * NATIVE_COND_TIMEDWAIT takes an absolute deadline (see native_deadline_us) and
+ * returns 0 or ETIMEDOUT on every platform.
+ *
  * IMPORTANT: All macros take POINTERS to the condition variable structure for consistency
  */
 #ifdef NATIVE_USE_WINDOWS
 /* Windows: Use native CONDITION_VARIABLE with CRITICAL_SECTION */
 typedef CONDITION_VARIABLE native_cond_t;
+
+/* SleepConditionVariableCS takes a relative timeout in milliseconds */
+static inline int native_cond_timedwait_windows(CONDITION_VARIABLE *cond, CRITICAL_SECTION *mutex,
+                                                const struct timespec *abstime)
+{
+    struct timespec now;
+    long long ms;
+
+    timespec_get(&now, TIME_UTC);
+    ms = (abstime->tv_sec - now.tv_sec) * 1000LL +
+         (abstime->tv_nsec - now.tv_nsec + 999999) / 1000000; /* round up */
+    if (ms < 0)
+        ms = 0;
+    if (SleepConditionVariableCS(cond, mutex, (DWORD) ms))
+        return 0;
+    return GetLastError() == ERROR_TIMEOUT ? ETIMEDOUT : EINVAL;
+}
+
 #define NATIVE_COND_INIT(cond) InitializeConditionVariable(cond)
 #define NATIVE_COND_DESTROY(cond) ((void) 0) /* No cleanup needed for CONDITION_VARIABLE */
 #define NATIVE_COND_WAIT(cond, mutex) SleepConditionVariableCS((cond), (mutex), INFINITE)
+#define NATIVE_COND_TIMEDWAIT(cond, mutex, abstime)                                                \
+    native_cond_timedwait_windows((cond), (mutex), (abstime))
 #define NATIVE_COND_SIGNAL(cond) WakeConditionVariable(cond)
 #define NATIVE_COND_BROADCAST(cond) WakeAllConditionVariable(cond)
 #elif defined(NATIVE_USE_GCD)
@@ -92,6 +489,7 @@ typedef pthread_cond_t native_cond_t;
 #define NATIVE_COND_INIT(cond) pthread_cond_init(cond, NULL)
 #define NATIVE_COND_DESTROY(cond) pthread_cond_destroy(cond)
 #define NATIVE_COND_WAIT(cond, mutex) pthread_cond_wait(cond, mutex)
+#define NATIVE_COND_TIMEDWAIT(cond, mutex, abstime) pthread_cond_timedwait(cond, mutex, abstime)
 #define NATIVE_COND_SIGNAL(cond) pthread_cond_signal(cond)
 #define NATIVE_COND_BROADCAST(cond) pthread_cond_broadcast(cond)
 #else
@@ -100,6 +498,7 @@ typedef pthread_cond_t native_cond_t;
 #define NATIVE_COND_INIT(cond) pthread_cond_init(cond, NULL)
 #define NATIVE_COND_DESTROY(cond) pthread_cond_destroy(cond)
 #define NATIVE_COND_WAIT(cond, mutex) pthread_cond_wait(cond, mutex)
+#define NATIVE_COND_TIMEDWAIT(cond, mutex, abstime) pthread_cond_timedwait(cond, mutex, abstime)
 #define NATIVE_COND_SIGNAL(cond) pthread_cond_signal(cond)
 #define NATIVE_COND_BROADCAST(cond) pthread_cond_broadcast(cond)
 #endif
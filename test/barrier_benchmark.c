@@ -0,0 +1,162 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#include "fastcond_sync.h"
+#include "test_portability.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Barrier Benchmark
+ *
+ * Phase-oriented: T threads each do a little work and then meet at a barrier, phase after
+ * phase, the pattern of a parallel solver stepping in lockstep.  For T = 2, 4 ... 64 it runs
+ *
+ * 1. fastcond - fastcond_barrier_t
+ * 2. pthread  - pthread_barrier_t, where the platform has it
+ *
+ * and reports phases per second and microseconds per phase.  After each barrier every
+ * thread checks that all T threads arrived for the phase.
+ *
+ * Usage: barrier_benchmark [phases] [work_cycles] [max_threads]
+ */
+
+#define MAX_THREADS 64
+
+#if !TEST_USE_WINDOWS && defined(_POSIX_BARRIERS) && _POSIX_BARRIERS > 0
+#define HAVE_PTHREAD_BARRIER 1
+#else
+#define HAVE_PTHREAD_BARRIER 0
+#endif
+
+struct barrier_context {
+    int n_threads;
+    int phases;
+    int work_cycles;
+    fastcond_barrier_t fc;
+#if HAVE_PTHREAD_BARRIER
+    pthread_barrier_t pt;
+#endif
+    int use_pthread;
+    volatile int arrived;
+    volatile int violations;
+};
+
+static void do_work(int cycles)
+{
+    volatile int sink = 0;
+    for (int i = 0; i < cycles; i++) {
+        sink += i;
+    }
+}
+
+static void bench_barrier_wait(struct barrier_context *ctx)
+{
+#if HAVE_PTHREAD_BARRIER
+    if (ctx->use_pthread) {
+        pthread_barrier_wait(&ctx->pt);
+        return;
+    }
+#endif
+    fastcond_barrier_wait(&ctx->fc);
+}
+
+TEST_THREAD_FUNC_RETURN phase_worker(void *arg)
+{
+    struct barrier_context *ctx = (struct barrier_context *) arg;
+
+    for (int phase = 0; phase < ctx->phases; phase++) {
+        do_work(ctx->work_cycles);
+        __sync_add_and_fetch(&ctx->arrived, 1);
+        bench_barrier_wait(ctx);
+        if (__sync_add_and_fetch(&ctx->arrived, 0) < (phase + 1) * ctx->n_threads)
+            __sync_add_and_fetch(&ctx->violations, 1);
+    }
+    TEST_THREAD_RETURN;
+}
+
+// Run one barrier; returns elapsed seconds, or a negative value on error
+static double run_barrier(struct barrier_context *ctx)
+{
+    test_thread_t threads[MAX_THREADS];
+    test_timespec_t start, end;
+
+    ctx->arrived = 0;
+    test_clock_gettime(&start);
+    for (int t = 0; t < ctx->n_threads; t++) {
+        if (test_thread_create(&threads[t], NULL, phase_worker, ctx) != 0) {
+            fprintf(stderr, "Error creating thread %d\n", t);
+            return -1.0;
+        }
+    }
+    for (int t = 0; t < ctx->n_threads; t++) {
+        test_thread_join(threads[t], NULL);
+    }
+    test_clock_gettime(&end);
+    return test_timespec_diff(&end, &start);
+}
+
+int main(int argc, char *argv[])
+{
+    int phases = 10000;
+    int work_cycles = 200;
+    int max_threads = MAX_THREADS;
+    int violations = 0;
+
+    if (argc > 1)
+        phases = atoi(argv[1]);
+    if (argc > 2)
+        work_cycles = atoi(argv[2]);
+    if (argc > 3)
+        max_threads = atoi(argv[3]);
+    if (phases <= 0 || work_cycles < 0 || max_threads < 2 || max_threads > MAX_THREADS) {
+        fprintf(stderr, "Usage: %s [phases] [work_cycles] [max_threads 2-%d]\n", argv[0],
+                MAX_THREADS);
+        return 1;
+    }
+
+    printf("=== Barrier Benchmark ===\n");
+    printf("Configuration: %d phases, %d work cycles per phase\n\n", phases, work_cycles);
+    printf("%7s | %14s %14s | %12s %12s\n", "threads", "fastcond ph/s", "pthread ph/s",
+           "fastcond us", "pthread us");
+
+    for (int n_threads = 2; n_threads <= max_threads; n_threads *= 2) {
+        struct barrier_context ctx;
+        double t_fc, t_pt = 0.0;
+
+        memset(&ctx, 0, sizeof(ctx));
+        ctx.n_threads = n_threads;
+        ctx.phases = phases;
+        ctx.work_cycles = work_cycles;
+
+        fastcond_barrier_init(&ctx.fc, n_threads);
+        t_fc = run_barrier(&ctx);
+        fastcond_barrier_fini(&ctx.fc);
+        if (t_fc <= 0)
+            return 1;
+
+#if HAVE_PTHREAD_BARRIER
+        pthread_barrier_init(&ctx.pt, NULL, (unsigned) n_threads);
+        ctx.use_pthread = 1;
+        t_pt = run_barrier(&ctx);
+        pthread_barrier_destroy(&ctx.pt);
+        if (t_pt <= 0)
+            return 1;
+#endif
+        violations += ctx.violations;
+
+        if (t_pt > 0)
+            printf("%7d | %14.0f %14.0f | %12.2f %12.2f\n", n_threads, phases / t_fc,
+                   phases / t_pt, t_fc * 1e6 / phases, t_pt * 1e6 / phases);
+        else
+            printf("%7d | %14.0f %14s | %12.2f %12s\n", n_threads, phases / t_fc, "-",
+                   t_fc * 1e6 / phases, "-");
+    }
+
+    if (violations) {
+        printf("❌ Barrier phases: FAILED (%d early departures)\n", violations);
+        return 1;
+    }
+    printf("✅ Barrier phases: PASSED\n");
+    return 0;
+}
@@ -0,0 +1,324 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#include "fastcond_chan.h"
+#include "test_portability.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * fastcond_chan_t test
+ *
+ * 1. Single-threaded checks of the try, close and non-blocking select semantics
+ * 2. Close wakes parked receivers and senders, and a select parked on a send
+ * 3. MPMC over an unbuffered and a buffered channel: every item arrives once
+ * 4. Fan-in: one consumer selects over a channel per producer until all are closed
+ * 5. Rendezvous ping-pong over two unbuffered channels, reported in round trips per second
+ *
+ * Usage: chan_test [producers] [items_per_producer] [round_trips]
+ */
+
+#define MAX_PRODUCERS 32
+
+struct chan_context {
+    fastcond_chan_t chans[MAX_PRODUCERS];
+    fastcond_chan_t *chan;
+    fastcond_chan_t *back; // ping-pong reply channel
+    int n_producers;
+    int items;
+    unsigned char *seen;
+    volatile int next_producer;
+    volatile int n_closed;
+    volatile long received;
+};
+
+static void mark_item(struct chan_context *ctx, void *item)
+{
+    ctx->seen[test_item_index(item)]++;
+}
+
+TEST_THREAD_FUNC_RETURN producer(void *arg)
+{
+    struct chan_context *ctx = (struct chan_context *) arg;
+    int id = __sync_fetch_and_add(&ctx->next_producer, 1);
+
+    for (int seq = 0; seq < ctx->items; seq++)
+        fastcond_chan_send(ctx->chan, test_make_item(id, ctx->items, seq));
+    TEST_THREAD_RETURN;
+}
+
+// Sends on its own channel of ctx->chans, and closes it when done
+TEST_THREAD_FUNC_RETURN fan_producer(void *arg)
+{
+    struct chan_context *ctx = (struct chan_context *) arg;
+    int id = __sync_fetch_and_add(&ctx->next_producer, 1);
+
+    for (int seq = 0; seq < ctx->items; seq++)
+        fastcond_chan_send(&ctx->chans[id], test_make_item(id, ctx->items, seq));
+    fastcond_chan_close(&ctx->chans[id]);
+    TEST_THREAD_RETURN;
+}
+
+TEST_THREAD_FUNC_RETURN consumer(void *arg)
+{
+    struct chan_context *ctx = (struct chan_context *) arg;
+    void *item;
+    long n = 0;
+
+    // seen[] entries are distinct per item, so no two consumers write the same one
+    while (fastcond_chan_recv(ctx->chan, &item) == 0) {
+        mark_item(ctx, item);
+        n++;
+    }
+    __sync_fetch_and_add(&ctx->received, n);
+    TEST_THREAD_RETURN;
+}
+
+TEST_THREAD_FUNC_RETURN parked_sender(void *arg)
+{
+    struct chan_context *ctx = (struct chan_context *) arg;
+
+    if (fastcond_chan_send(ctx->chan, (void *) 1) == EPIPE)
+        __sync_fetch_and_add(&ctx->n_closed, 1);
+    TEST_THREAD_RETURN;
+}
+
+TEST_THREAD_FUNC_RETURN parked_receiver(void *arg)
+{
+    struct chan_context *ctx = (struct chan_context *) arg;
+    void *item;
+
+    if (fastcond_chan_recv(ctx->chan, &item) == EPIPE && item == NULL)
+        __sync_fetch_and_add(&ctx->n_closed, 1);
+    TEST_THREAD_RETURN;
+}
+
+// Selects between a send on ctx->chans[0] and a receive on ctx->chans[1], the quit channel
+TEST_THREAD_FUNC_RETURN parked_selector(void *arg)
+{
+    struct chan_context *ctx = (struct chan_context *) arg;
+    struct fastcond_chan_case cases[2] = {
+        {&ctx->chans[0], FASTCOND_CHAN_SEND, (void *) 1, 0},
+        {&ctx->chans[1], FASTCOND_CHAN_RECV, NULL, 0},
+    };
+
+    if (fastcond_chan_select(cases, 2, 1) == 1 && cases[1].err == EPIPE)
+        __sync_fetch_and_add(&ctx->n_closed, 1);
+    TEST_THREAD_RETURN;
+}
+
+TEST_THREAD_FUNC_RETURN pong(void *arg)
+{
+    struct chan_context *ctx = (struct chan_context *) arg;
+    void *item;
+
+    while (fastcond_chan_recv(ctx->chan, &item) == 0)
+        fastcond_chan_send(ctx->back, item);
+    TEST_THREAD_RETURN;
+}
+
+static void test_single_threaded(void)
+{
+    fastcond_chan_t chan, other;
+    struct fastcond_chan_case cases[2];
+    void *item = NULL;
+    int ok;
+
+    check(fastcond_chan_init(&chan, -1) == EINVAL, "init rejects a negative capacity");
+
+    fastcond_chan_init(&chan, 0);
+    ok = fastcond_chan_trysend(&chan, (void *) 1) == EAGAIN;
+    check(ok && fastcond_chan_tryrecv(&chan, &item) == EAGAIN,
+          "unbuffered: try operations with no partner give EAGAIN");
+    fastcond_chan_fini(&chan);
+
+    fastcond_chan_init(&chan, 2);
+    ok = fastcond_chan_trysend(&chan, (void *) 1) == 0;
+    ok = ok && fastcond_chan_trysend(&chan, (void *) 2) == 0;
+    check(ok && fastcond_chan_trysend(&chan, (void *) 3) == EAGAIN,
+          "buffered: trysend on a full buffer gives EAGAIN");
+    ok = fastcond_chan_tryrecv(&chan, &item) == 0 && item == (void *) 1;
+    check(ok, "buffered: values come out in order");
+
+    fastcond_chan_init(&other, 0);
+    cases[0] = (struct fastcond_chan_case){&other, FASTCOND_CHAN_RECV, NULL, 0};
+    cases[1] = (struct fastcond_chan_case){&chan, FASTCOND_CHAN_SEND, (void *) 3, 0};
+    ok = fastcond_chan_select(cases, 2, 0) == 1 && cases[1].err == 0;
+    cases[1].op = FASTCOND_CHAN_RECV;
+    ok = ok && fastcond_chan_select(cases, 1, 0) == -1;
+    check(ok, "select: picks the ready case, or -1 without blocking");
+
+    fastcond_chan_close(&chan);
+    check(fastcond_chan_send(&chan, (void *) 4) == EPIPE, "send after close gives EPIPE");
+    ok = fastcond_chan_recv(&chan, &item) == 0 && item == (void *) 2;
+    ok = ok && fastcond_chan_recv(&chan, &item) == 0 && item == (void *) 3;
+    check(ok && fastcond_chan_recv(&chan, &item) == EPIPE, "close drains, then recv gives EPIPE");
+    ok = fastcond_chan_select(cases, 2, 1) == 1 && cases[1].err == EPIPE;
+    check(ok, "select: a closed channel is ready, with EPIPE");
+    fastcond_chan_fini(&other);
+    fastcond_chan_fini(&chan);
+}
+
+static void test_close_wakes(void)
+{
+    struct chan_context ctx;
+    test_thread_t threads[3];
+
+    memset(&ctx, 0, sizeof(ctx));
+    fastcond_chan_init(&ctx.chans[0], 0);
+    fastcond_chan_init(&ctx.chans[1], 0);
+    ctx.chan = &ctx.chans[0];
+    test_thread_create(&threads[0], NULL, parked_receiver, &ctx);
+    usleep(10000);
+    fastcond_chan_close(&ctx.chans[0]);
+    test_thread_join(threads[0], NULL);
+
+    fastcond_chan_fini(&ctx.chans[0]);
+    fastcond_chan_init(&ctx.chans[0], 1);
+    fastcond_chan_send(&ctx.chans[0], (void *) 1);
+    test_thread_create(&threads[1], NULL, parked_sender, &ctx);
+    usleep(10000);
+    fastcond_chan_close(&ctx.chans[0]);
+    test_thread_join(threads[1], NULL);
+
+    fastcond_chan_fini(&ctx.chans[0]);
+    fastcond_chan_init(&ctx.chans[0], 0);
+    test_thread_create(&threads[2], NULL, parked_selector, &ctx);
+    usleep(10000);
+    fastcond_chan_close(&ctx.chans[1]);
+    test_thread_join(threads[2], NULL);
+
+    check(ctx.n_closed == 3, "close wakes a parked receiver, sender and select");
+    fastcond_chan_fini(&ctx.chans[0]);
+    fastcond_chan_fini(&ctx.chans[1]);
+}
+
+static void test_mpmc(struct chan_context *ctx, int capacity)
+{
+    test_thread_t producers[MAX_PRODUCERS], consumers[MAX_PRODUCERS];
+    fastcond_chan_t chan;
+    char what[80];
+    long missing = 0;
+    int i;
+
+    fastcond_chan_init(&chan, capacity);
+    ctx->chan = &chan;
+    ctx->next_producer = 0;
+    ctx->received = 0;
+    memset(ctx->seen, 0, (size_t) ctx->n_producers * ctx->items);
+    for (i = 0; i < ctx->n_producers; i++) {
+        test_thread_create(&consumers[i], NULL, consumer, ctx);
+        test_thread_create(&producers[i], NULL, producer, ctx);
+    }
+    for (i = 0; i < ctx->n_producers; i++)
+        test_thread_join(producers[i], NULL);
+    fastcond_chan_close(&chan);
+    for (i = 0; i < ctx->n_producers; i++)
+        test_thread_join(consumers[i], NULL);
+    for (i = 0; i < ctx->n_producers * ctx->items; i++)
+        missing += ctx->seen[i] != 1;
+    snprintf(what, sizeof(what), "MPMC, capacity %d: every item received once", capacity);
+    check(missing == 0 && ctx->received == (long) ctx->n_producers * ctx->items, what);
+    fastcond_chan_fini(&chan);
+}
+
+static void test_fan_in(struct chan_context *ctx)
+{
+    test_thread_t producers[MAX_PRODUCERS];
+    struct fastcond_chan_case cases[MAX_PRODUCERS];
+    long missing = 0, received = 0;
+    int i, n = ctx->n_producers;
+
+    ctx->next_producer = 0;
+    memset(ctx->seen, 0, (size_t) ctx->n_producers * ctx->items);
+    for (i = 0; i < n; i++) {
+        fastcond_chan_init(&ctx->chans[i], i % 2); // unbuffered and buffered mixed
+        cases[i] = (struct fastcond_chan_case){&ctx->chans[i], FASTCOND_CHAN_RECV, NULL, 0};
+    }
+    for (i = 0; i < ctx->n_producers; i++)
+        test_thread_create(&producers[i], NULL, fan_producer, ctx);
+    while (n > 0) {
+        int k = fastcond_chan_select(cases, n, 1);
+        if (cases[k].err == EPIPE) {
+            cases[k] = cases[--n]; // closed and drained: stop selecting on it
+            continue;
+        }
+        mark_item(ctx, cases[k].value);
+        received++;
+    }
+    for (i = 0; i < ctx->n_producers; i++) {
+        test_thread_join(producers[i], NULL);
+        fastcond_chan_fini(&ctx->chans[i]);
+    }
+    for (i = 0; i < ctx->n_producers * ctx->items; i++)
+        missing += ctx->seen[i] != 1;
+    check(missing == 0 && received == (long) ctx->n_producers * ctx->items,
+          "fan-in select: every item received once");
+}
+
+static void test_ping_pong(struct chan_context *ctx, int round_trips)
+{
+    fastcond_chan_t ping, back;
+    test_thread_t thread;
+    test_timespec_t start, end;
+    void *item;
+    int ok = 1;
+
+    fastcond_chan_init(&ping, 0);
+    fastcond_chan_init(&back, 0);
+    ctx->chan = &ping;
+    ctx->back = &back;
+    test_thread_create(&thread, NULL, pong, ctx);
+    test_clock_gettime(&start);
+    for (int i = 1; i <= round_trips; i++) {
+        fastcond_chan_send(&ping, (void *) (size_t) i);
+        ok = ok && fastcond_chan_recv(&back, &item) == 0 && item == (void *) (size_t) i;
+    }
+    test_clock_gettime(&end);
+    fastcond_chan_close(&ping);
+    test_thread_join(thread, NULL);
+    printf("Rendezvous: %.0f round trips/s\n",
+           round_trips / test_timespec_diff(&end, &start));
+    check(ok, "ping-pong: every value comes back");
+    fastcond_chan_fini(&ping);
+    fastcond_chan_fini(&back);
+}
+
+int main(int argc, char *argv[])
+{
+    struct chan_context ctx;
+    int round_trips = 20000;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.n_producers = 4;
+    ctx.items = 20000;
+    if (argc > 1)
+        ctx.n_producers = atoi(argv[1]);
+    if (argc > 2)
+        ctx.items = atoi(argv[2]);
+    if (argc > 3)
+        round_trips = atoi(argv[3]);
+    if (ctx.n_producers <= 0 || ctx.n_producers > MAX_PRODUCERS || ctx.items <= 0 ||
+        round_trips <= 0) {
+        fprintf(stderr, "Usage: %s [producers 1-%d] [items_per_producer] [round_trips]\n",
+                argv[0], MAX_PRODUCERS);
+        return 1;
+    }
+    ctx.seen = calloc((size_t) ctx.n_producers * ctx.items, 1);
+    if (!ctx.seen) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    printf("=== fastcond_chan_t test ===\n");
+    test_single_threaded();
+    test_close_wakes();
+    test_mpmc(&ctx, 0);
+    test_mpmc(&ctx, 16);
+    test_fan_in(&ctx);
+    test_ping_pong(&ctx, round_trips);
+
+    free(ctx.seen);
+    return test_report("Channel");
+}
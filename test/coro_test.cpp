@@ -0,0 +1,190 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#include "fastcond.hpp"
+#include "test_portability.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+/*
+ * fastcond.hpp test
+ *
+ * 1. Coroutines and blocked threads wait together on one async_cond: signals wake them one
+ *    at a time, a broadcast wakes the rest, and every waiter wakes once
+ * 2. async_queue: thousands of coroutine consumers on a few executor threads, and some
+ *    blocking consumer threads, share the items of several producers; each is taken once
+ *
+ * Usage: coro_test [coroutines] [executor_threads] [items]
+ */
+
+#define N_BLOCKING 4
+#define N_PRODUCERS 4
+
+struct cond_context {
+    native_mutex_t mutex;
+    fastcond::async_cond cond;
+    fastcond::async_cond done; // the main thread waits here for the counts below
+    int tickets = 0;           // each lets one waiter through
+    int registered = 0;
+    int woken = 0;
+};
+
+static void count_up(cond_context *ctx, int *counter)
+{
+    (*counter)++;
+    ctx->done.signal();
+}
+
+static fastcond::detached cond_coroutine(cond_context *ctx, fastcond::executor *ex)
+{
+    co_await fastcond::resume_on(*ex);
+    NATIVE_MUTEX_LOCK(&ctx->mutex);
+    count_up(ctx, &ctx->registered);
+    while (ctx->tickets == 0)
+        co_await ctx->cond.async_wait(ctx->mutex, *ex);
+    ctx->tickets--;
+    count_up(ctx, &ctx->woken);
+    NATIVE_MUTEX_UNLOCK(&ctx->mutex);
+}
+
+static void cond_thread(cond_context *ctx)
+{
+    NATIVE_MUTEX_LOCK(&ctx->mutex);
+    count_up(ctx, &ctx->registered);
+    while (ctx->tickets == 0)
+        ctx->cond.wait(ctx->mutex);
+    ctx->tickets--;
+    count_up(ctx, &ctx->woken);
+    NATIVE_MUTEX_UNLOCK(&ctx->mutex);
+}
+
+// Wait, holding ctx->mutex, until *counter reaches n
+static void wait_count(cond_context *ctx, int *counter, int n)
+{
+    while (*counter < n)
+        ctx->done.wait(ctx->mutex);
+}
+
+static void test_cond(int n_coroutines, int n_threads)
+{
+    cond_context ctx;
+    fastcond::thread_executor ex(n_threads);
+    std::vector<std::thread> threads;
+    int total = n_coroutines + N_BLOCKING;
+    int n_signals = total / 2;
+    int woken_by_signals;
+
+    NATIVE_MUTEX_INIT(&ctx.mutex);
+    for (int i = 0; i < n_coroutines; i++)
+        cond_coroutine(&ctx, &ex);
+    for (int t = 0; t < N_BLOCKING; t++)
+        threads.emplace_back(cond_thread, &ctx);
+
+    NATIVE_MUTEX_LOCK(&ctx.mutex);
+    wait_count(&ctx, &ctx.registered, total);
+    for (int i = 0; i < n_signals; i++) {
+        ctx.tickets++;
+        ctx.cond.signal();
+    }
+    wait_count(&ctx, &ctx.woken, n_signals);
+    NATIVE_MUTEX_UNLOCK(&ctx.mutex);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    NATIVE_MUTEX_LOCK(&ctx.mutex);
+    woken_by_signals = ctx.woken;
+    ctx.tickets += total - n_signals;
+    ctx.cond.broadcast();
+    wait_count(&ctx, &ctx.woken, total);
+    NATIVE_MUTEX_UNLOCK(&ctx.mutex);
+
+    for (auto &thread : threads)
+        thread.join();
+    check(woken_by_signals == n_signals, "mixed waiters: each signal lets one waiter through");
+    check(ctx.woken == total && ctx.tickets == 0, "mixed waiters: broadcast wakes the rest");
+    NATIVE_MUTEX_DESTROY(&ctx.mutex);
+}
+
+struct queue_context {
+    fastcond::async_queue<int> queue;
+    std::vector<std::atomic<int>> seen;
+    std::atomic<int> finished{0};
+
+    explicit queue_context(int n_items) : seen(n_items) {}
+};
+
+static fastcond::detached queue_coroutine(queue_context *ctx, fastcond::executor *ex)
+{
+    co_await fastcond::resume_on(*ex);
+    while (std::optional<int> item = co_await ctx->queue.async_pop(*ex))
+        ctx->seen[*item]++;
+    ctx->finished++;
+}
+
+static void queue_thread(queue_context *ctx)
+{
+    while (std::optional<int> item = ctx->queue.pop())
+        ctx->seen[*item]++;
+    ctx->finished++;
+}
+
+static void test_queue(int n_coroutines, int n_threads, int n_items)
+{
+    queue_context ctx(n_items);
+    fastcond::thread_executor ex(n_threads);
+    std::vector<std::thread> consumers, producers;
+    bool once = true;
+
+    for (int i = 0; i < n_coroutines; i++)
+        queue_coroutine(&ctx, &ex);
+    for (int t = 0; t < N_BLOCKING; t++)
+        consumers.emplace_back(queue_thread, &ctx);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int p = 0; p < N_PRODUCERS; p++) {
+        producers.emplace_back([&ctx, p, n_items] {
+            for (int i = p; i < n_items; i += N_PRODUCERS)
+                ctx.queue.push(i);
+        });
+    }
+    for (auto &thread : producers)
+        thread.join();
+    ctx.queue.close();
+    for (auto &thread : consumers)
+        thread.join();
+    while (ctx.finished < n_coroutines + N_BLOCKING)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    for (int i = 0; i < n_items; i++)
+        once &= ctx.seen[i] == 1;
+    check(once, "async_queue: every item taken once by coroutines and threads together");
+    check(!ctx.queue.push(0), "async_queue: push fails once closed");
+    printf("   %d coroutines on %d threads + %d blocking threads: %.0f items/s\n", n_coroutines,
+           n_threads, N_BLOCKING, n_items / elapsed.count());
+}
+
+int main(int argc, char *argv[])
+{
+    int n_coroutines = 2000;
+    int n_threads = 4;
+    int n_items = 200000;
+
+    if (argc > 1)
+        n_coroutines = atoi(argv[1]);
+    if (argc > 2)
+        n_threads = atoi(argv[2]);
+    if (argc > 3)
+        n_items = atoi(argv[3]);
+    if (n_coroutines < 1 || n_threads < 1 || n_items < 1) {
+        fprintf(stderr, "Usage: %s [coroutines] [executor_threads] [items]\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== fastcond.hpp coroutine test ===\n");
+    test_cond(n_coroutines, n_threads);
+    test_queue(n_coroutines, n_threads, n_items);
+
+    return test_report("Coroutine");
+}
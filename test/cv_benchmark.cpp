@@ -0,0 +1,209 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#include "fastcond.hpp"
+#include "test_portability.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * fastcond::condition_variable against std::condition_variable
+ *
+ * First a few checks of the wrapper's waits: predicates, timeouts on steady_clock and
+ * system_clock, and a notify_one() reaching a waiter in wait_for().
+ *
+ * Then the qtest workload, written once over the mutex and condition variable types: senders
+ * and receivers in equal numbers pass items through a bounded ring buffer, yielding between
+ * items, waiting on not_full and not_empty with predicates.  It runs with std::mutex and
+ * std::condition_variable, then fastcond::mutex and fastcond::condition_variable, for 1, 2,
+ * 4 ... max_pairs sender/receiver pairs, best of the rounds.  Every item must arrive.
+ *
+ * Usage: cv_benchmark [items] [max_pairs] [queue_size] [rounds]
+ */
+
+#define MAX_PAIRS 64
+
+using steady = std::chrono::steady_clock;
+
+static void test_waits()
+{
+    using namespace std::chrono_literals;
+    fastcond::mutex mutex;
+    fastcond::condition_variable cond;
+    bool ready = false;
+
+    {
+        std::unique_lock<fastcond::mutex> lock(mutex);
+        auto start = steady::now();
+        bool got = cond.wait_for(lock, 20ms, [&] { return ready; });
+
+        check(!got && steady::now() - start >= 20ms && lock.owns_lock(),
+              "wait_for with a false predicate times out, mutex held");
+        start = steady::now();
+        check(cond.wait_until(lock, start + 10ms) == std::cv_status::timeout &&
+                  steady::now() - start >= 10ms,
+              "wait_until a steady_clock deadline times out at it");
+        check(cond.wait_until(lock, std::chrono::system_clock::now() + 10ms,
+                              [&] { return ready; }) == false,
+              "wait_until a system_clock deadline times out");
+        check(cond.wait_for(lock, -1s) == std::cv_status::timeout &&
+                  cond.wait_until(lock, steady::time_point::max(), [] { return true; }),
+              "a past deadline times out at once; a true predicate does not wait");
+    }
+
+    std::thread notifier([&] {
+        std::this_thread::sleep_for(20ms);
+        std::lock_guard<fastcond::mutex> guard(mutex);
+        ready = true;
+        cond.notify_one();
+    });
+    {
+        std::unique_lock<fastcond::mutex> lock(mutex);
+
+        check(cond.wait_for(lock, 10s, [&] { return ready; }),
+              "notify_one wakes a waiter in wait_for");
+    }
+    notifier.join();
+}
+
+// The qtest ring buffer, for either pair of types
+template <class Mutex, class Cond> struct qtest_queue {
+    Mutex mutex;
+    Cond not_empty;
+    Cond not_full;
+    std::vector<long> ring;
+    size_t head = 0;
+    size_t count = 0;
+    long n_sent = 0;
+    long n_data;
+
+    qtest_queue(long n, size_t size) : ring(size), n_data(n) {}
+};
+
+template <class Mutex, class Cond> static void sender(qtest_queue<Mutex, Cond> &q)
+{
+    std::unique_lock<Mutex> lock(q.mutex);
+
+    while (q.n_sent < q.n_data) {
+        // simulate getting the data
+        lock.unlock();
+        std::this_thread::yield();
+        lock.lock();
+        q.not_full.wait(lock, [&] { return q.n_sent == q.n_data || q.count < q.ring.size(); });
+        if (q.n_sent == q.n_data)
+            break;
+        q.ring[(q.head + q.count) % q.ring.size()] = q.n_sent++;
+        q.count++;
+        q.not_empty.notify_one();
+        if (q.n_sent == q.n_data) {
+            // wake everyone for the end condition
+            q.not_full.notify_all();
+            q.not_empty.notify_all();
+        }
+    }
+}
+
+template <class Mutex, class Cond> static void receiver(qtest_queue<Mutex, Cond> &q, long &sum)
+{
+    std::unique_lock<Mutex> lock(q.mutex);
+
+    for (;;) {
+        q.not_empty.wait(lock, [&] { return q.count || q.n_sent == q.n_data; });
+        if (!q.count)
+            break;
+        sum += q.ring[q.head];
+        q.head = (q.head + 1) % q.ring.size();
+        q.count--;
+        q.not_full.notify_one();
+        // simulate getting rid of the data
+        lock.unlock();
+        std::this_thread::yield();
+        lock.lock();
+    }
+}
+
+// Seconds for one run; sets *ok if every item arrived once
+template <class Mutex, class Cond>
+static double run_qtest(long n_data, int n_pairs, size_t queue_size, bool *ok)
+{
+    qtest_queue<Mutex, Cond> q(n_data, queue_size);
+    std::vector<long> sums(n_pairs, 0);
+    std::vector<std::thread> threads;
+    long total = 0;
+
+    auto start = steady::now();
+    for (int i = 0; i < n_pairs; i++)
+        threads.emplace_back(receiver<Mutex, Cond>, std::ref(q), std::ref(sums[i]));
+    for (int i = 0; i < n_pairs; i++)
+        threads.emplace_back(sender<Mutex, Cond>, std::ref(q));
+    for (auto &thread : threads)
+        thread.join();
+    std::chrono::duration<double> elapsed = steady::now() - start;
+
+    for (long sum : sums)
+        total += sum;
+    *ok = total == n_data * (n_data - 1) / 2;
+    return elapsed.count();
+}
+
+template <class Mutex, class Cond>
+static double best_of(int rounds, long n_data, int n_pairs, size_t queue_size, bool *ok)
+{
+    double best = 0;
+
+    for (int r = 0; r < rounds; r++) {
+        bool round_ok;
+        double t = run_qtest<Mutex, Cond>(n_data, n_pairs, queue_size, &round_ok);
+
+        *ok &= round_ok;
+        if (r == 0 || t < best)
+            best = t;
+    }
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    long n_data = 200000;
+    int max_pairs = 8;
+    int queue_size = 10;
+    int rounds = 3;
+    bool ok = true;
+
+    if (argc > 1)
+        n_data = atol(argv[1]);
+    if (argc > 2)
+        max_pairs = atoi(argv[2]);
+    if (argc > 3)
+        queue_size = atoi(argv[3]);
+    if (argc > 4)
+        rounds = atoi(argv[4]);
+    if (n_data < 1 || max_pairs < 1 || max_pairs > MAX_PAIRS || queue_size < 1 || rounds < 1) {
+        fprintf(stderr, "Usage: %s [items] [max_pairs 1-%d] [queue_size] [rounds]\n", argv[0],
+                MAX_PAIRS);
+        return 1;
+    }
+
+    printf("=== fastcond::condition_variable vs std::condition_variable ===\n");
+    test_waits();
+
+    printf("\nqtest workload: %ld items, queue size %d, best of %d\n\n", n_data, queue_size,
+           rounds);
+    printf("%5s | %14s %16s | %7s\n", "pairs", "std items/s", "fastcond items/s", "speedup");
+    for (int n_pairs = 1; n_pairs <= max_pairs; n_pairs *= 2) {
+        double t_std = best_of<std::mutex, std::condition_variable>(rounds, n_data, n_pairs,
+                                                                    (size_t) queue_size, &ok);
+        double t_fc = best_of<fastcond::mutex, fastcond::condition_variable>(
+            rounds, n_data, n_pairs, (size_t) queue_size, &ok);
+
+        printf("%5d | %14.0f %16.0f | %6.2fx\n", n_pairs, n_data / t_std, n_data / t_fc,
+               t_std / t_fc);
+    }
+    check(ok, "every item arrived once in every run");
+
+    return test_report("Condition variable benchmark");
+}
@@ -0,0 +1,301 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#include "fastcond_delay.h"
+#include "test_portability.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * fastcond_delay_queue_t test
+ *
+ * 1. Single-threaded checks: try, cancel, close and an already-passed deadline
+ * 2. A blocked consumer is woken early by a push with an earlier deadline
+ * 3. Items spread over every wheel level (1us ticks) come out in deadline order, none early
+ * 4. Consumers share items pushed by several producers; every item is popped once
+ * 5. Push and cancel of many pending items, reported in operations per second
+ *
+ * Usage: delay_test [consumers] [items] [pending]
+ */
+
+#define MAX_CONSUMERS 32
+
+static long long clock_us(void)
+{
+    struct timespec ts;
+
+    native_deadline_us(&ts, 0);
+    return (long long) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void deadline_at(struct timespec *ts, long long us)
+{
+    ts->tv_sec = (time_t) (us / 1000000);
+    ts->tv_nsec = (long) (us % 1000000) * 1000;
+}
+
+static void test_basics(void)
+{
+    fastcond_delay_queue_t queue;
+    fastcond_delay_item_t a, b, *item = NULL;
+    struct timespec ts;
+
+    fastcond_delay_queue_init(&queue, 0);
+    fastcond_delay_item_init(&a, &a);
+    fastcond_delay_item_init(&b, &b);
+    check(fastcond_delay_queue_trypop(&queue, &item) == EAGAIN, "trypop on an empty queue");
+    check(fastcond_delay_queue_cancel(&queue, &a) == ENOENT, "cancel of an item never pushed");
+
+    deadline_at(&ts, clock_us() - 1000000);
+    fastcond_delay_queue_push(&queue, &a, &ts);
+    check(fastcond_delay_queue_trypop(&queue, &item) == 0 && item == &a,
+          "an item past its deadline is due at once");
+
+    native_deadline_us(&ts, 50000);
+    fastcond_delay_queue_push(&queue, &a, &ts);
+    native_deadline_us(&ts, 10000000);
+    fastcond_delay_queue_push(&queue, &b, &ts);
+    check(fastcond_delay_queue_size(&queue) == 2 &&
+              fastcond_delay_queue_trypop(&queue, &item) == EAGAIN,
+          "items are not due before their deadline");
+    native_deadline_us(&ts, 10000);
+    check(fastcond_delay_queue_timedpop(&queue, &item, &ts) == ETIMEDOUT,
+          "timedpop times out before the earliest deadline");
+    check(fastcond_delay_queue_cancel(&queue, &b) == 0 &&
+              fastcond_delay_queue_cancel(&queue, &b) == ENOENT &&
+              fastcond_delay_queue_size(&queue) == 1,
+          "cancel takes an item out once");
+    check(fastcond_delay_queue_pop(&queue, &item) == 0 && item == &a && item->value == &a,
+          "pop waits for the deadline");
+
+    native_deadline_us(&ts, 10000000);
+    fastcond_delay_queue_push(&queue, &b, &ts);
+    fastcond_delay_queue_close(&queue);
+    check(fastcond_delay_queue_push(&queue, &a, &ts) == EPIPE &&
+              fastcond_delay_queue_pop(&queue, &item) == EPIPE,
+          "after close, push fails and pop fails with nothing due");
+    fastcond_delay_queue_fini(&queue);
+}
+
+struct early_context {
+    fastcond_delay_queue_t queue;
+    fastcond_delay_item_t *popped;
+    long long popped_us;
+};
+
+TEST_THREAD_FUNC_RETURN early_consumer(void *arg)
+{
+    struct early_context *ctx = (struct early_context *) arg;
+
+    fastcond_delay_queue_pop(&ctx->queue, &ctx->popped);
+    ctx->popped_us = clock_us();
+    TEST_THREAD_RETURN;
+}
+
+static void test_earlier_push(void)
+{
+    struct early_context ctx;
+    fastcond_delay_item_t late, early;
+    test_thread_t thread;
+    struct timespec ts;
+    long long start;
+
+    fastcond_delay_queue_init(&ctx.queue, 0);
+    fastcond_delay_item_init(&late, NULL);
+    fastcond_delay_item_init(&early, NULL);
+    ctx.popped = NULL;
+    start = clock_us();
+    deadline_at(&ts, start + 2000000);
+    fastcond_delay_queue_push(&ctx.queue, &late, &ts);
+    test_thread_create(&thread, NULL, early_consumer, &ctx);
+    usleep(20000); // let it block until the late deadline
+    deadline_at(&ts, start + 40000);
+    fastcond_delay_queue_push(&ctx.queue, &early, &ts);
+    test_thread_join(thread, NULL);
+    check(ctx.popped == &early && ctx.popped_us >= start + 40000 &&
+              ctx.popped_us < start + 1000000,
+          "an earlier push wakes the consumer for the new deadline");
+    fastcond_delay_queue_fini(&ctx.queue);
+}
+
+static void test_levels(int n_items)
+{
+    fastcond_delay_queue_t queue;
+    fastcond_delay_item_t *items = malloc(sizeof(fastcond_delay_item_t) * (size_t) n_items);
+    fastcond_delay_item_t far, *item;
+    long long *deadlines = malloc(sizeof(long long) * (size_t) n_items);
+    long long start, last = 0, late = 0;
+    struct timespec ts;
+    int ordered = 1, early = 0;
+
+    // 1us ticks: 64us, 4ms, 262ms and 16.8s levels; deadlines up to 600ms use all but the top
+    fastcond_delay_queue_init(&queue, 1);
+    start = clock_us() + 1000;
+    srand(42);
+    for (int i = 0; i < n_items; i++) {
+        deadlines[i] = start + (long long) rand() % 600000;
+        fastcond_delay_item_init(&items[i], &deadlines[i]);
+        deadline_at(&ts, deadlines[i]);
+        fastcond_delay_queue_push(&queue, &items[i], &ts);
+    }
+    // Beyond the wheel's span: parked in the top level
+    fastcond_delay_item_init(&far, NULL);
+    deadline_at(&ts, start + 60000000);
+    fastcond_delay_queue_push(&queue, &far, &ts);
+
+    for (int i = 0; i < n_items; i++) {
+        long long deadline, now;
+
+        fastcond_delay_queue_pop(&queue, &item);
+        now = clock_us();
+        deadline = *(long long *) item->value;
+        ordered &= deadline >= last;
+        early += now < deadline;
+        if (now - deadline > late)
+            late = now - deadline;
+        last = deadline;
+    }
+    check(ordered && !early, "items over every level come out in order, none early");
+    check(fastcond_delay_queue_cancel(&queue, &far) == 0 && fastcond_delay_queue_size(&queue) == 0,
+          "an item beyond the wheel's span waits in the top level");
+    printf("   %d items over 600ms, worst lateness %lld us\n", n_items, late);
+    fastcond_delay_queue_fini(&queue);
+    free(deadlines);
+    free(items);
+}
+
+struct share_context {
+    fastcond_delay_queue_t queue;
+    fastcond_delay_item_t *items;
+    long long *deadlines;
+    unsigned char *seen;
+    int n_items, n_producers;
+    volatile int next_producer;
+    volatile int n_popped;
+    volatile int n_early;
+};
+
+TEST_THREAD_FUNC_RETURN share_producer(void *arg)
+{
+    struct share_context *ctx = (struct share_context *) arg;
+    int id = __sync_fetch_and_add(&ctx->next_producer, 1);
+    struct timespec ts;
+
+    for (int i = id; i < ctx->n_items; i += ctx->n_producers) {
+        deadline_at(&ts, ctx->deadlines[i]);
+        fastcond_delay_queue_push(&ctx->queue, &ctx->items[i], &ts);
+        if (i % 64 == 0)
+            usleep(100);
+    }
+    TEST_THREAD_RETURN;
+}
+
+TEST_THREAD_FUNC_RETURN share_consumer(void *arg)
+{
+    struct share_context *ctx = (struct share_context *) arg;
+    fastcond_delay_item_t *item;
+
+    while (fastcond_delay_queue_pop(&ctx->queue, &item) == 0) {
+        int i = (int) (item - ctx->items);
+
+        if (clock_us() < ctx->deadlines[i])
+            __sync_fetch_and_add(&ctx->n_early, 1);
+        ctx->seen[i]++;
+        if (__sync_fetch_and_add(&ctx->n_popped, 1) + 1 == ctx->n_items)
+            fastcond_delay_queue_close(&ctx->queue);
+    }
+    TEST_THREAD_RETURN;
+}
+
+static void test_shared(int n_consumers, int n_items)
+{
+    struct share_context ctx;
+    test_thread_t consumers[MAX_CONSUMERS], producers[4];
+    long long start = clock_us();
+    int once = 1;
+
+    fastcond_delay_queue_init(&ctx.queue, 0);
+    ctx.items = malloc(sizeof(fastcond_delay_item_t) * (size_t) n_items);
+    ctx.deadlines = malloc(sizeof(long long) * (size_t) n_items);
+    ctx.seen = calloc((size_t) n_items, 1);
+    ctx.n_items = n_items;
+    ctx.n_producers = 4;
+    ctx.next_producer = 0;
+    ctx.n_popped = 0;
+    ctx.n_early = 0;
+    for (int i = 0; i < n_items; i++) {
+        ctx.deadlines[i] = start + (long long) rand() % 200000;
+        fastcond_delay_item_init(&ctx.items[i], NULL);
+    }
+    for (int t = 0; t < n_consumers; t++)
+        test_thread_create(&consumers[t], NULL, share_consumer, &ctx);
+    for (int t = 0; t < ctx.n_producers; t++)
+        test_thread_create(&producers[t], NULL, share_producer, &ctx);
+    for (int t = 0; t < ctx.n_producers; t++)
+        test_thread_join(producers[t], NULL);
+    for (int t = 0; t < n_consumers; t++)
+        test_thread_join(consumers[t], NULL);
+    for (int i = 0; i < n_items; i++)
+        once &= ctx.seen[i] == 1;
+    check(once && !ctx.n_early, "shared consumers: every item popped once, none early");
+    free(ctx.seen);
+    free(ctx.deadlines);
+    free(ctx.items);
+    fastcond_delay_queue_fini(&ctx.queue);
+}
+
+static void test_pending(int n_pending)
+{
+    fastcond_delay_queue_t queue;
+    fastcond_delay_item_t *items = malloc(sizeof(fastcond_delay_item_t) * (size_t) n_pending);
+    test_timespec_t start, end;
+    long long base = clock_us();
+    struct timespec ts;
+    int cancelled = 0;
+    double elapsed;
+
+    fastcond_delay_queue_init(&queue, 0);
+    test_clock_gettime(&start);
+    for (int i = 0; i < n_pending; i++) {
+        fastcond_delay_item_init(&items[i], NULL);
+        deadline_at(&ts, base + 1000000 + (long long) i * 3600000000LL / n_pending);
+        fastcond_delay_queue_push(&queue, &items[i], &ts);
+    }
+    for (int i = 0; i < n_pending; i++)
+        cancelled += fastcond_delay_queue_cancel(&queue, &items[i]) == 0;
+    test_clock_gettime(&end);
+    elapsed = test_timespec_diff(&end, &start);
+    check(cancelled == n_pending && fastcond_delay_queue_size(&queue) == 0,
+          "pending items over an hour all cancel");
+    printf("   %d pending items: %.0f push+cancel/s\n", n_pending, n_pending / elapsed);
+    fastcond_delay_queue_fini(&queue);
+    free(items);
+}
+
+int main(int argc, char *argv[])
+{
+    int n_consumers = 4;
+    int n_items = 20000;
+    int n_pending = 200000;
+
+    if (argc > 1)
+        n_consumers = atoi(argv[1]);
+    if (argc > 2)
+        n_items = atoi(argv[2]);
+    if (argc > 3)
+        n_pending = atoi(argv[3]);
+    if (n_consumers < 1 || n_consumers > MAX_CONSUMERS || n_items < 1 || n_pending < 1) {
+        fprintf(stderr, "Usage: %s [consumers 1-%d] [items] [pending]\n", argv[0],
+                MAX_CONSUMERS);
+        return 1;
+    }
+
+    printf("=== fastcond_delay_queue_t test ===\n");
+    test_basics();
+    test_earlier_push();
+    test_levels(n_items);
+    test_shared(n_consumers, n_items);
+    test_pending(n_pending);
+
+    return test_report("Delay queue");
+}
@@ -0,0 +1,211 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#include "fastcond_future.h"
+#include "test_portability.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * fastcond_future_t test
+ *
+ * 1. Single-threaded checks: set once, errors, timeouts and the ready fast path
+ * 2. Many threads blocked in get() on one future all wake when it completes
+ * 3. Fan-out: completer threads finish a batch of futures per round while the main thread
+ *    waits with when_all() or when_any(); batches are larger than the on-stack wait nodes
+ *
+ * Usage: future_test [completers] [rounds] [batch]
+ */
+
+#define MAX_COMPLETERS 32
+#define MAX_BATCH 256
+#define N_GETTERS 8
+
+struct getter_context {
+    fastcond_future_t future;
+    volatile int n_ok;
+};
+
+TEST_THREAD_FUNC_RETURN getter(void *arg)
+{
+    struct getter_context *ctx = (struct getter_context *) arg;
+    void *value = NULL;
+
+    if (fastcond_future_get(&ctx->future, &value) == 0 && value == (void *) ctx)
+        __sync_fetch_and_add(&ctx->n_ok, 1);
+    TEST_THREAD_RETURN;
+}
+
+struct fanout_context {
+    fastcond_promise_t *promises; // rounds * batch
+    int rounds, batch, n_completers;
+    volatile int round; // completers hold back until the waiter reaches their round
+    volatile int next_id;
+};
+
+TEST_THREAD_FUNC_RETURN completer(void *arg)
+{
+    struct fanout_context *ctx = (struct fanout_context *) arg;
+    int id = __sync_fetch_and_add(&ctx->next_id, 1);
+
+    for (int r = 0; r < ctx->rounds; r++) {
+        while (ctx->round < r)
+            test_sched_yield();
+        for (int i = id; i < ctx->batch; i += ctx->n_completers) {
+            size_t k = (size_t) r * ctx->batch + i;
+
+            if ((i + r) % 7 == 3)
+                fastcond_promise_set_error(&ctx->promises[k], EIO);
+            else
+                fastcond_promise_set_value(&ctx->promises[k], (void *) (k + 1));
+        }
+    }
+    TEST_THREAD_RETURN;
+}
+
+static void test_basics(void)
+{
+    fastcond_future_t futures[3], *pointers[3];
+    fastcond_promise_t promises[3];
+    struct timespec ts;
+    void *value = NULL;
+    int index = -1;
+
+    for (int i = 0; i < 3; i++) {
+        fastcond_promise_init(&promises[i], &futures[i]);
+        pointers[i] = &futures[i];
+    }
+    check(!fastcond_future_ready(&futures[0]), "a new future is pending");
+    native_deadline_us(&ts, 10000);
+    check(fastcond_future_timedget(&futures[0], &value, &ts) == ETIMEDOUT,
+          "timedget times out on a pending future");
+    native_deadline_us(&ts, 10000);
+    check(fastcond_future_when_any(pointers, 3, &ts, &index) == ETIMEDOUT,
+          "when_any times out with every future pending");
+
+    fastcond_promise_set_value(&promises[1], &value);
+    check(fastcond_future_ready(&futures[1]) && fastcond_future_get(&futures[1], &value) == 0 &&
+              value == (void *) &value,
+          "get returns the value once set");
+    check(fastcond_promise_set_value(&promises[1], NULL) == EBUSY &&
+              fastcond_promise_set_error(&promises[1], EIO) == EBUSY,
+          "a future completes only once");
+    check(fastcond_future_when_any(pointers, 3, NULL, &index) == 0 && index == 1,
+          "when_any finds the ready future");
+    native_deadline_us(&ts, 10000);
+    check(fastcond_future_when_all(pointers, 3, &ts) == ETIMEDOUT,
+          "when_all times out with futures pending");
+
+    check(fastcond_promise_set_error(&promises[0], 0) == EINVAL, "set_error rejects 0");
+    fastcond_promise_set_error(&promises[0], EIO);
+    fastcond_promise_set_value(&promises[2], NULL);
+    check(fastcond_future_get(&futures[0], &value) == EIO, "get returns the error once set");
+    check(fastcond_future_when_all(pointers, 3, NULL) == 0 &&
+              fastcond_future_when_all(pointers, 0, NULL) == 0,
+          "when_all returns with every future ready");
+    check(fastcond_future_when_any(pointers, 0, NULL, &index) == EINVAL &&
+              fastcond_future_when_all(pointers, -1, NULL) == EINVAL,
+          "when_any and when_all check n");
+}
+
+static void test_getters(void)
+{
+    struct getter_context ctx;
+    fastcond_promise_t promise;
+    test_thread_t threads[N_GETTERS];
+
+    fastcond_promise_init(&promise, &ctx.future);
+    ctx.n_ok = 0;
+    for (int t = 0; t < N_GETTERS; t++)
+        test_thread_create(&threads[t], NULL, getter, &ctx);
+    usleep(20000); // let them block
+    fastcond_promise_set_value(&promise, &ctx);
+    for (int t = 0; t < N_GETTERS; t++)
+        test_thread_join(threads[t], NULL);
+    check(ctx.n_ok == N_GETTERS, "one completion wakes every blocked get()");
+}
+
+static void test_fanout(int n_completers, int rounds, int batch)
+{
+    struct fanout_context ctx;
+    fastcond_future_t *futures = malloc(sizeof(fastcond_future_t) * (size_t) rounds * batch);
+    fastcond_future_t *pointers[MAX_BATCH];
+    test_thread_t threads[MAX_COMPLETERS];
+    test_timespec_t start, end;
+    int ok = 1, any_ok = 1;
+    double elapsed;
+
+    ctx.promises = malloc(sizeof(fastcond_promise_t) * (size_t) rounds * batch);
+    ctx.rounds = rounds;
+    ctx.batch = batch;
+    ctx.n_completers = n_completers;
+    ctx.round = -1;
+    ctx.next_id = 0;
+    for (size_t k = 0; k < (size_t) rounds * batch; k++)
+        fastcond_promise_init(&ctx.promises[k], &futures[k]);
+    for (int t = 0; t < n_completers; t++)
+        test_thread_create(&threads[t], NULL, completer, &ctx);
+
+    test_clock_gettime(&start);
+    for (int r = 0; r < rounds; r++) {
+        fastcond_future_t *round = &futures[(size_t) r * batch];
+        int index = -1;
+
+        for (int i = 0; i < batch; i++)
+            pointers[i] = &round[i];
+        __sync_fetch_and_add(&ctx.round, 1);
+        if (r % 2) {
+            any_ok &= fastcond_future_when_any(pointers, batch, NULL, &index) == 0 &&
+                      index >= 0 && index < batch && fastcond_future_ready(pointers[index]);
+        }
+        ok &= fastcond_future_when_all(pointers, batch, NULL) == 0;
+        for (int i = 0; i < batch; i++) {
+            size_t k = (size_t) r * batch + i;
+            void *value = NULL;
+            int err = fastcond_future_get(&round[i], &value);
+
+            if ((i + r) % 7 == 3)
+                ok &= err == EIO;
+            else
+                ok &= err == 0 && value == (void *) (k + 1);
+        }
+    }
+    test_clock_gettime(&end);
+    for (int t = 0; t < n_completers; t++)
+        test_thread_join(threads[t], NULL);
+    elapsed = test_timespec_diff(&end, &start);
+
+    check(any_ok, "fan-out: when_any returns a ready future");
+    check(ok, "fan-out: when_all sees every value and error");
+    printf("   %d rounds of %d futures, %d completers: %.0f completions/s\n", rounds, batch,
+           n_completers, (double) rounds * batch / elapsed);
+    free(ctx.promises);
+    free(futures);
+}
+
+int main(int argc, char *argv[])
+{
+    int n_completers = 4;
+    int rounds = 2000;
+    int batch = 40;
+
+    if (argc > 1)
+        n_completers = atoi(argv[1]);
+    if (argc > 2)
+        rounds = atoi(argv[2]);
+    if (argc > 3)
+        batch = atoi(argv[3]);
+    if (n_completers < 1 || n_completers > MAX_COMPLETERS || rounds < 1 || batch < 1 ||
+        batch > MAX_BATCH) {
+        fprintf(stderr, "Usage: %s [completers 1-%d] [rounds] [batch 1-%d]\n", argv[0],
+                MAX_COMPLETERS, MAX_BATCH);
+        return 1;
+    }
+
+    printf("=== fastcond_future_t test ===\n");
+    test_basics();
+    test_getters();
+    test_fanout(n_completers, rounds, batch);
+
+    return test_report("Future");
+}
@@ -12,6 +12,21 @@
 #include <stdlib.h>
 #include <string.h>
 
+// Name of the GIL's internal mutex
+#if FASTCOND_GIL_USE_FUTEX
+#define GIL_MUTEX "none"
+#elif FASTCOND_GIL_USE_FASTCOND_MUTEX
+#define GIL_MUTEX "fastcond_mutex_t"
+#elif FASTCOND_GIL_MUTEX_KIND == NATIVE_MUTEX_KIND_ADAPTIVE
+#define GIL_MUTEX "native, adaptive"
+#elif FASTCOND_GIL_MUTEX_KIND == NATIVE_MUTEX_KIND_ERRORCHECK
+#define GIL_MUTEX "native, error-checking"
+#elif FASTCOND_GIL_MUTEX_KIND == NATIVE_MUTEX_KIND_PI
+#define GIL_MUTEX "native, priority-inheriting"
+#else
+#define GIL_MUTEX "native"
+#endif
+
 /*
  * GIL Performance Benchmark
  *
@@ -23,10 +38,20 @@
  * 1. High contention - many threads competing frequently
  * 2. Burst mode - threads acquire/release in rapid bursts
  * 3. Mixed workload - variable hold times simulating real-world usage
+ * 4. I/O latency under CPU hogs - one I/O-bound thread against yielding CPU-bound threads,
+ *    the convoy effect that FASTCOND_GIL_IO_BOOST is meant to mitigate
+ * 5. Condition variable ping-pong - two threads taking turns under the GIL, waiting with
+ *    a separate mutex and condition variable, then with fastcond_gil_cond_wait()
+ *
+ * Scenarios 1-3 also report handoff locality: for every acquisition, the NUMA distance
+ * between the node of the previous releaser and the node of the acquirer (see
+ * FASTCOND_GIL_NUMA).
  */
 
 #define MAX_THREADS 32
 #define MAX_SAMPLES 1000000
+#define MAX_NODES 64
+#define MAX_DISTANCE 256 // ACPI SLIT distances are one byte; 10 means local
 
 struct benchmark_context {
     struct fastcond_gil gil;
@@ -52,9 +77,38 @@ struct benchmark_context {
     volatile long total_wait_time_ns;
     volatile long max_wait_time_ns;
 
+    // Handoff locality, updated while holding the GIL
+    int last_release_node; // -1 before the first release
+    long handoffs_by_distance[MAX_DISTANCE];
+
     test_mutex_t stats_mutex;
 };
 
+// NUMA distance between two nodes, from sysfs where available; otherwise the conventional
+// 10 for local and 20 for remote
+static int node_distance(int from, int to)
+{
+    int distance = from == to ? 10 : 20;
+#if defined(__linux__)
+    char path[64];
+    FILE *f;
+
+    if (from >= MAX_NODES || to >= MAX_NODES)
+        return distance;
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/distance", from);
+    f = fopen(path, "r");
+    if (f) {
+        int d, i;
+        for (i = 0; i <= to && fscanf(f, "%d", &d) == 1; i++) {
+            if (i == to)
+                distance = d;
+        }
+        fclose(f);
+    }
+#endif
+    return distance < 0 || distance >= MAX_DISTANCE ? MAX_DISTANCE - 1 : distance;
+}
+
 // Get current time in nanoseconds
 static inline long long get_time_ns(void)
 {
@@ -127,11 +181,17 @@ TEST_THREAD_FUNC_RETURN benchmark_worker(void *arg)
         }
         test_mutex_unlock(&ctx->stats_mutex);
 
+        // Handoff locality: where the GIL came from, and where it goes next
+        int node = native_current_node();
+        if (ctx->last_release_node >= 0)
+            ctx->handoffs_by_distance[node_distance(ctx->last_release_node, node)]++;
+
         // Simulate work while holding GIL
         busy_wait_us(ctx->hold_time_us);
 
         // Release GIL
         test_clock_gettime(&release_time);
+        ctx->last_release_node = native_current_node();
         fastcond_gil_release(&ctx->gil);
 
         // Wait before next acquisition
@@ -142,6 +202,67 @@ TEST_THREAD_FUNC_RETURN benchmark_worker(void *arg)
     TEST_THREAD_RETURN;
 }
 
+// CPU-bound thread for the I/O latency scenario: holds the GIL for hold_time_us slices and
+// yields between them, like an interpreter thread running pure bytecode
+TEST_THREAD_FUNC_RETURN cpu_hog_worker(void *arg)
+{
+    struct benchmark_context *ctx = (struct benchmark_context *) arg;
+
+    while (!ctx->start_flag && !ctx->stop_flag) {
+        usleep(1000);
+    }
+
+    fastcond_gil_acquire(&ctx->gil);
+    while (!ctx->stop_flag) {
+        busy_wait_us(ctx->hold_time_us);
+        fastcond_gil_yield(&ctx->gil);
+    }
+    fastcond_gil_release(&ctx->gil);
+
+    __sync_sub_and_fetch(&ctx->active_threads, 1);
+    TEST_THREAD_RETURN;
+}
+
+// I/O-bound thread for the I/O latency scenario: a few microseconds of work under the GIL,
+// then a short blocking I/O with the GIL released.  Only this thread's re-acquire latency
+// is sampled.
+TEST_THREAD_FUNC_RETURN io_worker(void *arg)
+{
+    struct benchmark_context *ctx = (struct benchmark_context *) arg;
+    test_timespec_t acquire_start, acquire_end;
+
+    while (!ctx->start_flag && !ctx->stop_flag) {
+        usleep(1000);
+    }
+
+    for (int i = 0; i < ctx->iterations_per_thread; i++) {
+        test_clock_gettime(&acquire_start);
+        fastcond_gil_acquire(&ctx->gil);
+        test_clock_gettime(&acquire_end);
+
+        double latency_us = timespec_diff_us(&acquire_start, &acquire_end);
+        long long wait_time_ns = (long long) (latency_us * 1000);
+        ctx->total_acquisitions++;
+        ctx->total_wait_time_ns += wait_time_ns;
+        if (wait_time_ns > ctx->max_wait_time_ns)
+            ctx->max_wait_time_ns = wait_time_ns;
+        if (ctx->sample_count < ctx->max_samples)
+            ctx->latencies[ctx->sample_count++] = latency_us;
+
+        // Handle the request: a little work under the GIL
+        busy_wait_us(5);
+        fastcond_gil_release(&ctx->gil);
+
+        // Blocking I/O with the GIL released
+        usleep(ctx->release_time_us);
+    }
+
+    // The hogs run until the I/O thread is done
+    ctx->stop_flag = 1;
+    __sync_sub_and_fetch(&ctx->active_threads, 1);
+    TEST_THREAD_RETURN;
+}
+
 static void print_latency_statistics(struct benchmark_context *ctx)
 {
     if (ctx->sample_count == 0) {
@@ -199,6 +320,58 @@ static void print_latency_statistics(struct benchmark_context *ctx)
     free(sorted_latencies);
 }
 
+// Print handoffs by NUMA distance between the previous releaser and the acquirer
+static void print_handoff_locality(struct benchmark_context *ctx)
+{
+    long total = 0;
+
+    for (int d = 0; d < MAX_DISTANCE; d++) {
+        total += ctx->handoffs_by_distance[d];
+    }
+    if (total == 0)
+        return;
+    printf("\n=== Handoff Locality ===\n");
+    for (int d = 0; d < MAX_DISTANCE; d++) {
+        if (ctx->handoffs_by_distance[d] > 0)
+            printf("Distance %3d%s: %ld handoffs (%.1f%%)\n", d, d == 10 ? " (local)" : "",
+                   ctx->handoffs_by_distance[d], 100.0 * ctx->handoffs_by_distance[d] / total);
+    }
+}
+
+#if FASTCOND_GIL_STATS
+// Print one of the GIL's built-in log2 histograms, skipping empty buckets
+static void print_gil_histogram(const char *name, const struct fastcond_gil_histogram *h)
+{
+    printf("%s: %llu samples, mean %.2f μs, max %.2f μs\n", name, h->count,
+           h->count ? h->sum_ns / 1000.0 / h->count : 0.0, h->max_ns / 1000.0);
+    for (int i = 0; i < FASTCOND_GIL_STATS_BUCKETS; i++) {
+        if (h->buckets[i]) {
+            printf("  [%10.3f, %10.3f) μs: %llu\n", (double) (1ULL << i) / 1000.0,
+                   (double) (1ULL << (i + 1)) / 1000.0, h->buckets[i]);
+        }
+    }
+}
+
+// The GIL's own view of the run, as a production service would see it
+static void print_gil_stats(struct fastcond_gil *gil)
+{
+    struct fastcond_gil_stats st;
+
+    if (fastcond_gil_get_stats(gil, &st) != 0)
+        return;
+    printf("\n=== Built-in GIL Statistics ===\n");
+    printf("Acquisitions: %llu (%llu contended)\n", st.acquisitions, st.contended);
+    print_gil_histogram("Hold time", &st.hold);
+    print_gil_histogram("Wait time", &st.wait);
+    print_gil_histogram("Handoff latency", &st.handoff);
+    printf("Per-thread acquisitions:");
+    for (int i = 0; i < st.n_threads; i++) {
+        printf(" %llu", st.threads[i].acquisitions);
+    }
+    printf("\n");
+}
+#endif
+
 int run_benchmark(const char *test_name, int num_threads, int iterations_per_thread,
                   int hold_time_us, int release_time_us)
 {
@@ -211,8 +384,14 @@ int run_benchmark(const char *test_name, int num_threads, int iterations_per_thr
     }
 
     printf("\n=== %s ===\n", test_name);
-    printf("Backend: %s\n", FASTCOND_GIL_USE_NATIVE_COND ? "Native pthread" : "fastcond");
+    printf("Backend: %s (struct fastcond_gil: %zu bytes)\n", FASTCOND_GIL_BACKEND_NAME,
+           sizeof(struct fastcond_gil));
+    printf("Mutex: %s\n", GIL_MUTEX);
     printf("Fairness: %s\n", FASTCOND_GIL_DISABLE_FAIRNESS ? "DISABLED (plain mutex)" : "ENABLED");
+    if (FASTCOND_GIL_SPIN)
+        printf("Spin-before-park: ENABLED (%d CPUs)\n", native_cpu_count());
+    if (FASTCOND_GIL_NUMA)
+        printf("NUMA handoff preference: ENABLED\n");
     printf("Configuration: %d threads, %d iterations/thread\n", num_threads, iterations_per_thread);
     printf("Hold time: %d μs, Release time: %d μs\n", hold_time_us, release_time_us);
 
@@ -227,6 +406,7 @@ int run_benchmark(const char *test_name, int num_threads, int iterations_per_thr
     ctx.release_time_us = release_time_us;
     ctx.active_threads = num_threads;
     ctx.max_samples = MAX_SAMPLES;
+    ctx.last_release_node = -1;
 
     // Allocate memory for timing data
     ctx.acquire_times = malloc(MAX_SAMPLES * sizeof(test_timespec_t));
@@ -275,6 +455,10 @@ int run_benchmark(const char *test_name, int num_threads, int iterations_per_thr
 
     // Detailed latency statistics
     print_latency_statistics(&ctx);
+    print_handoff_locality(&ctx);
+#if FASTCOND_GIL_STATS
+    print_gil_stats(&ctx.gil);
+#endif
 
     // Cleanup
     fastcond_gil_destroy(&ctx.gil);
@@ -286,6 +470,205 @@ int run_benchmark(const char *test_name, int num_threads, int iterations_per_thr
     return 0;
 }
 
+// Convoy-effect scenario: num_threads - 1 CPU hogs yielding every hold_time_us, and one
+// I/O thread doing iterations short requests separated by release_time_us of blocking I/O.
+// Without I/O boost the I/O thread queues behind every hog on each return; the mean
+// re-acquire latency approaches (num_threads - 1) * hold_time_us.
+int run_io_latency_benchmark(const char *test_name, int num_threads, int iterations,
+                             int hold_time_us, int release_time_us)
+{
+    struct benchmark_context ctx;
+    test_thread_t threads[MAX_THREADS];
+    int num_hogs = num_threads > 1 ? num_threads - 1 : 1;
+
+    if (num_hogs + 1 > MAX_THREADS) {
+        fprintf(stderr, "Error: Maximum %d threads supported\n", MAX_THREADS);
+        return 1;
+    }
+
+    printf("\n=== %s ===\n", test_name);
+    printf("Backend: %s\n", FASTCOND_GIL_BACKEND_NAME);
+    printf("I/O boost: %s\n", FASTCOND_GIL_IO_BOOST ? "ENABLED" : "DISABLED");
+    printf("Configuration: %d CPU hogs, 1 I/O thread, %d I/O requests\n", num_hogs, iterations);
+    printf("Hog slice: %d μs, I/O duration: %d μs\n", hold_time_us, release_time_us);
+
+    memset(&ctx, 0, sizeof(ctx));
+    fastcond_gil_init(&ctx.gil);
+    test_mutex_init(&ctx.stats_mutex, NULL);
+
+    ctx.num_threads = num_hogs + 1;
+    ctx.iterations_per_thread = iterations;
+    ctx.hold_time_us = hold_time_us;
+    ctx.release_time_us = release_time_us;
+    ctx.active_threads = num_hogs + 1;
+    ctx.max_samples = iterations < MAX_SAMPLES ? iterations : MAX_SAMPLES;
+    ctx.latencies = malloc(ctx.max_samples * sizeof(double));
+    if (!ctx.latencies) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return 1;
+    }
+
+    for (int i = 0; i < num_hogs; i++) {
+        if (test_thread_create(&threads[i], NULL, cpu_hog_worker, &ctx) != 0) {
+            fprintf(stderr, "Error creating thread %d\n", i);
+            return 1;
+        }
+    }
+    if (test_thread_create(&threads[num_hogs], NULL, io_worker, &ctx) != 0) {
+        fprintf(stderr, "Error creating I/O thread\n");
+        return 1;
+    }
+
+    test_timespec_t start_time, end_time;
+    test_clock_gettime(&start_time);
+    ctx.start_flag = 1;
+
+    for (int i = 0; i <= num_hogs; i++) {
+        test_thread_join(threads[i], NULL);
+    }
+    test_clock_gettime(&end_time);
+
+    printf("Benchmark completed in %.3f seconds\n", test_timespec_diff(&end_time, &start_time));
+    printf("\n=== I/O Thread Results ===\n");
+    printf("I/O requests served: %ld\n", ctx.total_acquisitions);
+    printf("Average re-acquire latency: %.2f μs\n",
+           (double) ctx.total_wait_time_ns / (ctx.total_acquisitions * 1000.0));
+    printf("Maximum re-acquire latency: %.2f μs\n", ctx.max_wait_time_ns / 1000.0);
+    print_latency_statistics(&ctx);
+#if FASTCOND_GIL_STATS
+    print_gil_stats(&ctx.gil);
+#endif
+
+    fastcond_gil_destroy(&ctx.gil);
+    test_mutex_destroy(&ctx.stats_mutex);
+    free(ctx.latencies);
+
+    return 0;
+}
+
+#if !FASTCOND_GIL_USE_FUTEX
+// Condition variable of the GIL's backend, for the classic pattern
+#if FASTCOND_GIL_USE_NATIVE_COND
+#define BENCH_COND_INIT(cond) NATIVE_COND_INIT(cond)
+#define BENCH_COND_DESTROY(cond) NATIVE_COND_DESTROY(cond)
+#define BENCH_COND_WAIT(cond, mutex) NATIVE_COND_WAIT((cond), (mutex))
+#define BENCH_COND_SIGNAL(cond) NATIVE_COND_SIGNAL(cond)
+#else
+#define BENCH_COND_INIT(cond) fastcond_cond_init((cond), NULL)
+#define BENCH_COND_DESTROY(cond) fastcond_cond_fini(cond)
+#define BENCH_COND_WAIT(cond, mutex) fastcond_cond_wait((cond), (mutex))
+#define BENCH_COND_SIGNAL(cond) fastcond_cond_signal(cond)
+#endif
+
+struct pingpong_context {
+    struct fastcond_gil gil;
+    native_mutex_t mutex; // classic pattern only
+    fastcond_gil_cond_t cond[2];
+    volatile int turn;
+    int rounds;
+    int gil_cond; // use fastcond_gil_cond_wait()
+};
+
+struct pingpong_args {
+    struct pingpong_context *ctx;
+    int me;
+};
+
+TEST_THREAD_FUNC_RETURN pingpong_worker(void *arg)
+{
+    struct pingpong_args *args = (struct pingpong_args *) arg;
+    struct pingpong_context *ctx = args->ctx;
+    int me = args->me;
+
+    fastcond_gil_acquire(&ctx->gil);
+    for (int i = 0; i < ctx->rounds; i++) {
+        if (ctx->gil_cond) {
+            while (ctx->turn != me) {
+                fastcond_gil_cond_wait(&ctx->gil, &ctx->cond[me]);
+            }
+            ctx->turn = !me;
+            fastcond_gil_cond_signal(&ctx->gil, &ctx->cond[!me]);
+        } else {
+            // threading.Condition over a plain lock: drop the GIL around the wait
+            while (ctx->turn != me) {
+                fastcond_gil_release(&ctx->gil);
+                NATIVE_MUTEX_LOCK(&ctx->mutex);
+                while (ctx->turn != me) {
+                    BENCH_COND_WAIT(&ctx->cond[me], &ctx->mutex);
+                }
+                NATIVE_MUTEX_UNLOCK(&ctx->mutex);
+                fastcond_gil_acquire(&ctx->gil);
+            }
+            NATIVE_MUTEX_LOCK(&ctx->mutex);
+            ctx->turn = !me;
+            BENCH_COND_SIGNAL(&ctx->cond[!me]);
+            NATIVE_MUTEX_UNLOCK(&ctx->mutex);
+        }
+    }
+    fastcond_gil_release(&ctx->gil);
+    TEST_THREAD_RETURN;
+}
+
+// Time rounds turn handoffs between two threads; returns seconds, negative on error
+static double run_pingpong(int rounds, int gil_cond)
+{
+    struct pingpong_context ctx;
+    struct pingpong_args args[2];
+    test_thread_t threads[2];
+    test_timespec_t start, end;
+
+    memset(&ctx, 0, sizeof(ctx));
+    fastcond_gil_init(&ctx.gil);
+    NATIVE_MUTEX_INIT(&ctx.mutex);
+    BENCH_COND_INIT(&ctx.cond[0]);
+    BENCH_COND_INIT(&ctx.cond[1]);
+    ctx.rounds = rounds;
+    ctx.gil_cond = gil_cond;
+
+    test_clock_gettime(&start);
+    for (int i = 0; i < 2; i++) {
+        args[i].ctx = &ctx;
+        args[i].me = i;
+        if (test_thread_create(&threads[i], NULL, pingpong_worker, &args[i]) != 0) {
+            fprintf(stderr, "Error creating thread %d\n", i);
+            return -1.0;
+        }
+    }
+    for (int i = 0; i < 2; i++) {
+        test_thread_join(threads[i], NULL);
+    }
+    test_clock_gettime(&end);
+
+    BENCH_COND_DESTROY(&ctx.cond[0]);
+    BENCH_COND_DESTROY(&ctx.cond[1]);
+    NATIVE_MUTEX_DESTROY(&ctx.mutex);
+    fastcond_gil_destroy(&ctx.gil);
+    return test_timespec_diff(&end, &start);
+}
+#endif
+
+// Condition variable scenario: the threading.Condition hot path, both ways
+int run_cond_benchmark(const char *test_name, int rounds)
+{
+    printf("\n=== %s ===\n", test_name);
+    printf("Backend: %s\n", FASTCOND_GIL_BACKEND_NAME);
+#if FASTCOND_GIL_USE_FUTEX
+    (void) rounds;
+    printf("Skipped: fastcond_gil_cond_wait() needs the GIL's mutex\n");
+#else
+    printf("Configuration: 2 threads, %d handoffs each\n", rounds);
+    double t_classic = run_pingpong(rounds, 0);
+    double t_gil = run_pingpong(rounds, 1);
+    if (t_classic <= 0 || t_gil <= 0)
+        return 1;
+    printf("Release + mutex/cond wait + acquire: %.0f handoffs/s (%.2f μs each)\n",
+           2.0 * rounds / t_classic, t_classic * 1e6 / (2.0 * rounds));
+    printf("fastcond_gil_cond_wait():            %.0f handoffs/s (%.2f μs each)\n",
+           2.0 * rounds / t_gil, t_gil * 1e6 / (2.0 * rounds));
+#endif
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
     printf("fastcond GIL Performance Benchmark\n");
@@ -337,8 +720,19 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    // 5. I/O latency under CPU hogs - the convoy effect
+    if (run_io_latency_benchmark("I/O Latency Under CPU Hogs", num_threads, iterations / 10 + 1,
+                                 100, 50) != 0) {
+        return 1;
+    }
+
+    // 6. Condition variable ping-pong under the GIL
+    if (run_cond_benchmark("Condition Variable Ping-Pong", iterations) != 0) {
+        return 1;
+    }
+
     printf("\n=== Benchmark Suite Complete ===\n");
-    printf("Backend tested: %s\n", FASTCOND_GIL_USE_NATIVE_COND ? "Native pthread" : "fastcond");
+    printf("Backend tested: %s\n", FASTCOND_GIL_BACKEND_NAME);
     printf("Fairness mode: %s\n",
            FASTCOND_GIL_DISABLE_FAIRNESS ? "DISABLED (plain mutex)" : "ENABLED");
 
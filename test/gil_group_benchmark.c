@@ -0,0 +1,374 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#include "gil.h"
+#include "gil_group.h"
+#include "test_portability.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Multiple-GIL Benchmark
+ *
+ * Models per-subinterpreter GILs: N threads spread round-robin over G GILs, each thread
+ * running the usual interpreter pattern on its own GIL (mostly yields, with an occasional
+ * release and re-acquire).  For G = 1, 2, 4 ... 64 the same workload runs twice:
+ *
+ * 1. separate - an array of G independent struct fastcond_gil
+ * 2. group    - one fastcond_gil_group of G GILs sharing a park-node pool
+ *
+ * and reports throughput, bytes per GIL and the number of condition variables (each one a
+ * semaphore with the fastcond backend) that each layout needs.
+ *
+ * Then, for G = 2 ... 64, the handoff latency on one GIL while the others are busy: two
+ * threads on GIL 0 yield it to each other, the waiting one parked, and each measures the
+ * time from the other's yield until it holds the GIL.  Meanwhile busy threads run the
+ * workload above on the other G - 1 GILs, which in the group park and wake on the same
+ * node pool.  Reports the median and 99th percentile for each layout.
+ *
+ * Mutual exclusion is checked per GIL throughout.
+ *
+ * Usage: gil_group_benchmark [num_threads] [iterations_per_thread] [work_cycles] [max_gils]
+ */
+
+#define MAX_THREADS 64
+#define MAX_GILS 64
+#define RELEASE_EVERY 10 // one release/acquire per this many yields
+#define LATENCY_HANDOFFS 1000 // measured handoffs per layout, at most iterations
+
+struct group_context {
+    int n_gils;
+    int iterations;
+    int work_cycles;
+    struct fastcond_gil *gils;        // separate layout, or NULL
+    struct fastcond_gil_group *group; // group layout, or NULL
+    volatile int holders[MAX_GILS];
+    volatile int violations;
+    volatile int stop; // ends the workers early
+};
+
+struct group_thread_args {
+    struct group_context *ctx;
+    int gil_index;
+};
+
+static void do_work(int cycles)
+{
+    volatile int sink = 0;
+    for (int i = 0; i < cycles; i++) {
+        sink += i;
+    }
+}
+
+static void bench_acquire(struct group_context *ctx, int i)
+{
+    if (ctx->group)
+        fastcond_gil_group_acquire(ctx->group, i);
+    else
+        fastcond_gil_acquire(&ctx->gils[i]);
+}
+
+static void bench_release(struct group_context *ctx, int i)
+{
+    if (ctx->group)
+        fastcond_gil_group_release(ctx->group, i);
+    else
+        fastcond_gil_release(&ctx->gils[i]);
+}
+
+static void bench_yield(struct group_context *ctx, int i)
+{
+    if (ctx->group)
+        fastcond_gil_group_yield(ctx->group, i);
+    else
+        fastcond_gil_yield(&ctx->gils[i]);
+}
+
+TEST_THREAD_FUNC_RETURN group_worker(void *arg)
+{
+    struct group_thread_args *args = (struct group_thread_args *) arg;
+    struct group_context *ctx = args->ctx;
+    int g = args->gil_index;
+
+    bench_acquire(ctx, g);
+    for (int i = 0; i < ctx->iterations && !ctx->stop; i++) {
+        if (__sync_add_and_fetch(&ctx->holders[g], 1) != 1)
+            __sync_add_and_fetch(&ctx->violations, 1);
+        do_work(ctx->work_cycles);
+        __sync_sub_and_fetch(&ctx->holders[g], 1);
+
+        if (i % RELEASE_EVERY == RELEASE_EVERY - 1) {
+            bench_release(ctx, g);
+            bench_acquire(ctx, g);
+        } else {
+            bench_yield(ctx, g);
+        }
+    }
+    bench_release(ctx, g);
+    TEST_THREAD_RETURN;
+}
+
+// Run one layout; returns elapsed seconds, or a negative value on error
+static double run_layout(struct group_context *ctx, int num_threads)
+{
+    test_thread_t threads[MAX_THREADS];
+    struct group_thread_args args[MAX_THREADS];
+    test_timespec_t start, end;
+
+    memset((void *) ctx->holders, 0, sizeof(ctx->holders));
+    ctx->violations = 0;
+
+    test_clock_gettime(&start);
+    for (int t = 0; t < num_threads; t++) {
+        args[t].ctx = ctx;
+        args[t].gil_index = t % ctx->n_gils;
+        if (test_thread_create(&threads[t], NULL, group_worker, &args[t]) != 0) {
+            fprintf(stderr, "Error creating thread %d\n", t);
+            return -1.0;
+        }
+    }
+    for (int t = 0; t < num_threads; t++) {
+        test_thread_join(threads[t], NULL);
+    }
+    test_clock_gettime(&end);
+    return test_timespec_diff(&end, &start);
+}
+
+// Two threads handing GIL 0 back and forth
+struct latency_context {
+    struct group_context *ctx;
+    int handoffs;
+    test_timespec_t stamp; // when the holder last yielded
+    int stamp_owner;       // which thread set stamp, -1 before the first yield
+    int n_samples;
+    double samples_us[LATENCY_HANDOFFS];
+};
+
+struct latency_thread_args {
+    struct latency_context *lat;
+    int id;
+};
+
+TEST_THREAD_FUNC_RETURN latency_worker(void *arg)
+{
+    struct latency_thread_args *args = (struct latency_thread_args *) arg;
+    struct latency_context *lat = args->lat;
+    test_timespec_t now;
+
+    bench_acquire(lat->ctx, 0);
+    while (lat->n_samples < lat->handoffs) {
+        test_clock_gettime(&now);
+        // Only a yield that handed the GIL over counts
+        if (lat->stamp_owner >= 0 && lat->stamp_owner != args->id)
+            lat->samples_us[lat->n_samples++] = test_timespec_diff(&now, &lat->stamp) * 1e6;
+        lat->stamp = now;
+        lat->stamp_owner = args->id;
+        bench_yield(lat->ctx, 0);
+    }
+    bench_release(lat->ctx, 0);
+    TEST_THREAD_RETURN;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+// Measure handoffs on GIL 0 with n_busy threads working on the other GILs; sets *p50 and
+// *p99 in microseconds.  Returns 0, or -1 on error
+static int run_latency(struct group_context *ctx, int n_busy, int handoffs, double *p50,
+                       double *p99)
+{
+    static struct latency_context lat;
+    test_thread_t busy[MAX_GILS], pair[2];
+    struct group_thread_args busy_args[MAX_GILS];
+    struct latency_thread_args pair_args[2];
+    int iterations = ctx->iterations;
+    int n = 0, err = 0;
+
+    memset(&lat, 0, sizeof(lat));
+    lat.ctx = ctx;
+    lat.handoffs = handoffs;
+    lat.stamp_owner = -1;
+    ctx->stop = 0;
+    ctx->iterations = 0x7fffffff; // the busy threads run until stopped
+    for (; n < n_busy; n++) {
+        busy_args[n].ctx = ctx;
+        busy_args[n].gil_index = 1 + n % (ctx->n_gils - 1);
+        if (test_thread_create(&busy[n], NULL, group_worker, &busy_args[n]) != 0) {
+            err = -1;
+            break;
+        }
+    }
+    for (int t = 0; t < 2 && !err; t++) {
+        pair_args[t].lat = &lat;
+        pair_args[t].id = t;
+        if (test_thread_create(&pair[t], NULL, latency_worker, &pair_args[t]) != 0) {
+            // the first thread cannot finish on its own: end its rounds
+            lat.handoffs = 0;
+            if (t == 1)
+                test_thread_join(pair[0], NULL);
+            err = -1;
+        }
+    }
+    if (!err) {
+        test_thread_join(pair[0], NULL);
+        test_thread_join(pair[1], NULL);
+    }
+    ctx->stop = 1;
+    for (int t = 0; t < n; t++) {
+        test_thread_join(busy[t], NULL);
+    }
+    ctx->iterations = iterations;
+    if (err || lat.n_samples == 0) {
+        fprintf(stderr, "Error creating latency test threads\n");
+        return -1;
+    }
+
+    qsort(lat.samples_us, lat.n_samples, sizeof(double), compare_double);
+    *p50 = lat.samples_us[lat.n_samples / 2];
+    *p99 = lat.samples_us[lat.n_samples * 99 / 100];
+    return 0;
+}
+
+// Set up n_gils GILs for ctx: separate ones, allocated as one array the way an embedder
+// might, or one group.  Returns 0, or -1 on error
+static int layout_open(struct group_context *ctx, int n_gils, int grouped)
+{
+    ctx->n_gils = n_gils;
+    ctx->gils = NULL;
+    ctx->group = NULL;
+    if (grouped) {
+        if (fastcond_gil_group_create(&ctx->group, n_gils) != 0) {
+            fprintf(stderr, "fastcond_gil_group_create failed\n");
+            return -1;
+        }
+        return 0;
+    }
+    ctx->gils = malloc(sizeof(struct fastcond_gil) * n_gils);
+    if (!ctx->gils) {
+        fprintf(stderr, "Out of memory\n");
+        return -1;
+    }
+    for (int i = 0; i < n_gils; i++) {
+        fastcond_gil_init(&ctx->gils[i]);
+    }
+    return 0;
+}
+
+// Tear down what layout_open() set up; for a group, first fill *info if not NULL
+static void layout_close(struct group_context *ctx, struct fastcond_gil_group_info *info)
+{
+    if (ctx->group) {
+        if (info)
+            fastcond_gil_group_get_info(ctx->group, info);
+        fastcond_gil_group_destroy(ctx->group);
+        ctx->group = NULL;
+        return;
+    }
+    for (int i = 0; i < ctx->n_gils; i++) {
+        fastcond_gil_destroy(&ctx->gils[i]);
+    }
+    free(ctx->gils);
+    ctx->gils = NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_threads = 16;
+    int iterations = 20000;
+    int work_cycles = 100;
+    int max_gils = MAX_GILS;
+    int failed = 0;
+
+    if (argc > 1)
+        num_threads = atoi(argv[1]);
+    if (argc > 2)
+        iterations = atoi(argv[2]);
+    if (argc > 3)
+        work_cycles = atoi(argv[3]);
+    if (argc > 4)
+        max_gils = atoi(argv[4]);
+    if (num_threads <= 0 || num_threads > MAX_THREADS || iterations <= 0 || work_cycles < 0 ||
+        max_gils <= 0 || max_gils > MAX_GILS) {
+        fprintf(stderr, "Usage: %s [num_threads 1-%d] [iterations] [work_cycles] [max_gils 1-%d]\n",
+                argv[0], MAX_THREADS, MAX_GILS);
+        return 1;
+    }
+
+    printf("=== Multiple-GIL Benchmark ===\n");
+    printf("Backend: %s\n", FASTCOND_GIL_BACKEND_NAME);
+    printf("Configuration: %d threads, %d iterations each, %d work cycles\n\n", num_threads,
+           iterations, work_cycles);
+    printf("%5s | %14s %14s | %9s %9s | %10s %10s\n", "GILs", "separate op/s", "group op/s",
+           "B/GIL sep", "B/GIL grp", "conds sep", "conds grp");
+
+    for (int n_gils = 1; n_gils <= max_gils; n_gils *= 2) {
+        struct group_context ctx;
+        struct fastcond_gil_group_info info;
+        double t_separate, t_group;
+        double ops = (double) num_threads * iterations;
+
+        memset(&ctx, 0, sizeof(ctx));
+        ctx.iterations = iterations;
+        ctx.work_cycles = work_cycles;
+
+        if (layout_open(&ctx, n_gils, 0) != 0)
+            return 1;
+        t_separate = run_layout(&ctx, num_threads);
+        failed |= ctx.violations != 0;
+        layout_close(&ctx, NULL);
+
+        if (layout_open(&ctx, n_gils, 1) != 0)
+            return 1;
+        t_group = run_layout(&ctx, num_threads);
+        failed |= ctx.violations != 0;
+        layout_close(&ctx, &info);
+
+        if (t_separate <= 0 || t_group <= 0)
+            return 1;
+        printf("%5d | %14.0f %14.0f | %9zu %9zu | %10d %10d\n", n_gils, ops / t_separate,
+               ops / t_group, sizeof(struct fastcond_gil), info.slot_size, n_gils,
+               info.park_nodes);
+    }
+
+    printf("\nconds grp = park nodes allocated (peak parked threads, rounded up to a chunk)\n");
+
+    if (max_gils > 1) {
+        int handoffs = iterations < LATENCY_HANDOFFS ? iterations : LATENCY_HANDOFFS;
+
+        printf("\nHandoff latency on GIL 0 while the other GILs are busy, %d handoffs (μs)\n\n",
+               handoffs);
+        printf("%5s %5s | %10s %10s | %10s %10s\n", "GILs", "busy", "sep p50", "sep p99",
+               "grp p50", "grp p99");
+    }
+    for (int n_gils = 2; n_gils <= max_gils; n_gils *= 2) {
+        struct group_context ctx;
+        // At least one busy thread on every other GIL
+        int n_busy = num_threads - 2 > n_gils - 1 ? num_threads - 2 : n_gils - 1;
+        int handoffs = iterations < LATENCY_HANDOFFS ? iterations : LATENCY_HANDOFFS;
+        double p50[2], p99[2];
+
+        memset(&ctx, 0, sizeof(ctx));
+        ctx.work_cycles = work_cycles;
+        if (n_busy > MAX_GILS)
+            n_busy = MAX_GILS;
+        for (int grouped = 0; grouped < 2; grouped++) {
+            if (layout_open(&ctx, n_gils, grouped) != 0)
+                return 1;
+            if (run_latency(&ctx, n_busy, handoffs, &p50[grouped], &p99[grouped]) != 0)
+                return 1;
+            failed |= ctx.violations != 0;
+            layout_close(&ctx, NULL);
+        }
+        printf("%5d %5d | %10.1f %10.1f | %10.1f %10.1f\n", n_gils, n_busy, p50[0], p99[0],
+               p50[1], p99[1]);
+    }
+    if (failed) {
+        printf("❌ Mutual exclusion: FAILED\n");
+        return 1;
+    }
+    printf("✅ Mutual exclusion: PASSED\n");
+    return 0;
+}
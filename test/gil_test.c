@@ -7,11 +7,19 @@
 
 #include "gil.h"
 #include "test_portability.h"
+#include <errno.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+// Waiters currently registered with a GIL
+#if FASTCOND_GIL_USE_FUTEX
+#define GIL_N_WAITING(gil) ((gil).futex / FASTCOND_GIL_FUTEX_WAITER)
+#else
+#define GIL_N_WAITING(gil) ((gil).n_waiting)
+#endif
+
 /*
  * Comprehensive GIL correctness and fairness test with Python-like behavior simulation
  *
@@ -198,6 +206,12 @@ TEST_THREAD_FUNC_RETURN worker_thread(void *arg)
 
         // Do work while holding the GIL
         do_work_with_sleep(ctx->work_cycles, ctx->hold_time_us);
+#if FASTCOND_GIL_RECURSIVE
+        // A callback that takes the GIL again must neither block nor let anyone in
+        fastcond_gil_acquire(&ctx->gil);
+        do_work_with_sleep(ctx->work_cycles / 2, 0);
+        fastcond_gil_release(&ctx->gil);
+#endif
 
         // Check if we should stop before yielding/doing I/O
         if (acquisition_number >= ctx->total_acquisitions_target) {
@@ -238,7 +252,13 @@ TEST_THREAD_FUNC_RETURN worker_thread(void *arg)
         } else {
             // REGULAR YIELD: Cooperative yielding for fairness
             // yield() maintains GIL ownership but gives other threads a turn
+#if FASTCOND_GIL_RECURSIVE
+            fastcond_gil_acquire(&ctx->gil); // yield from a nested level must still let go
+#endif
             fastcond_gil_yield(&ctx->gil);
+#if FASTCOND_GIL_RECURSIVE
+            fastcond_gil_release(&ctx->gil);
+#endif
             // Next loop iteration will re-enter critical section with holder_count++
         }
     }
@@ -292,6 +312,18 @@ static void print_fairness_statistics(struct test_context *ctx, int num_threads)
     printf("  Min/Max acquisitions: %d/%d (ratio: %.2f)\n", min_acquisitions, max_acquisitions,
            (double) max_acquisitions / min_acquisitions);
 
+    // Jain's fairness index: J = (sum x)^2 / (n * sum x^2), ranging from 1/n (one thread got
+    // everything) to 1 (perfectly even).  Unlike the coefficient of variation it is bounded
+    // and independent of scale, which makes runs with different thread counts comparable.
+    // Jain, Chiu & Hawe (1984), DEC-TR-301.
+    double sum_sq = 0;
+    for (int i = 0; i < ctx->num_threads; i++) {
+        sum_sq += (double) ctx->thread_acquisitions[i] * ctx->thread_acquisitions[i];
+    }
+    double jain = sum_sq > 0 ? (sum * sum) / (ctx->num_threads * sum_sq) : 1.0;
+    printf("  Jain's fairness index: %.4f (1.0 = perfectly fair, %.4f = one thread only)\n", jain,
+           1.0 / ctx->num_threads);
+
     // Acquisition sequence analysis
     printf("\nAcquisition sequence analysis:\n");
     if (ctx->sequence_index > 0) {
@@ -507,6 +539,41 @@ static void print_fairness_statistics(struct test_context *ctx, int num_threads)
     }
 }
 
+#if FASTCOND_GIL_STATS
+// Cross-check the GIL's built-in statistics for internal consistency: every acquisition
+// shows up exactly once in the wait histogram and the per-thread table, and every
+// acquisition has been matched by a release in the hold histogram once all threads are done
+static void check_gil_stats(struct fastcond_gil *gil)
+{
+    struct fastcond_gil_stats st;
+    unsigned long long per_thread = 0;
+
+    if (fastcond_gil_get_stats(gil, &st) != 0) {
+        printf("❌ GIL stats: fastcond_gil_get_stats() failed\n");
+        return;
+    }
+    for (int i = 0; i < st.n_threads; i++) {
+        per_thread += st.threads[i].acquisitions;
+    }
+    per_thread += st.untracked_acquisitions;
+
+    printf("GIL stats: %llu acquisitions (%llu contended) by %d threads, "
+           "mean hold %.1f μs, mean wait %.1f μs, mean handoff %.1f μs\n",
+           st.acquisitions, st.contended, st.n_threads,
+           st.hold.count ? st.hold.sum_ns / 1000.0 / st.hold.count : 0.0,
+           st.wait.count ? st.wait.sum_ns / 1000.0 / st.wait.count : 0.0,
+           st.handoff.count ? st.handoff.sum_ns / 1000.0 / st.handoff.count : 0.0);
+
+    if (st.wait.count == st.acquisitions && st.hold.count == st.acquisitions &&
+        per_thread == st.acquisitions && st.handoff.count <= st.contended) {
+        printf("✅ GIL stats: PASSED (histograms and per-thread counts agree)\n");
+    } else {
+        printf("❌ GIL stats: INCONSISTENT (wait %llu, hold %llu, per-thread %llu, total %llu)\n",
+               st.wait.count, st.hold.count, per_thread, st.acquisitions);
+    }
+}
+#endif
+
 int run_gil_test(int num_threads, int total_acquisitions, int hold_time_us, int work_cycles,
                  int release_delay_us, int release_delay_variance_us, int json_mode)
 {
@@ -521,9 +588,17 @@ int run_gil_test(int num_threads, int total_acquisitions, int hold_time_us, int
 
     if (!json_mode) {
         printf("=== GIL Correctness and Fairness Test ===\n");
-        printf("Backend: %s\n", FASTCOND_GIL_USE_NATIVE_COND ? "Native pthread" : "fastcond");
+        printf("Backend: %s\n", FASTCOND_GIL_BACKEND_NAME);
         printf("Fairness: %s\n",
                FASTCOND_GIL_DISABLE_FAIRNESS ? "DISABLED (plain mutex)" : "ENABLED");
+        if (FASTCOND_GIL_MODE_TICKET)
+            printf("Mode: TICKET (strict FIFO)\n");
+        if (FASTCOND_GIL_RECURSIVE)
+            printf("Mode: RECURSIVE (owner depth tracking)\n");
+        if (FASTCOND_GIL_SPIN)
+            printf("Spin-before-park: ENABLED (%d CPUs)\n", native_cpu_count());
+        if (FASTCOND_GIL_NUMA)
+            printf("NUMA handoff: ENABLED (current node %d)\n", native_current_node());
         printf("Configuration: %d threads competing for %d total acquisitions\n", num_threads,
                total_acquisitions);
         printf("Hold time: %d μs, Work cycles: %d, Release delay: %d±%d μs", hold_time_us,
@@ -614,6 +689,10 @@ int run_gil_test(int num_threads, int total_acquisitions, int hold_time_us, int
             printf("✅ Cleanup: PASSED (no threads holding GIL)\n");
         }
 
+#if FASTCOND_GIL_STATS
+        check_gil_stats(&ctx.gil);
+#endif
+
         // Print fairness statistics
         print_fairness_statistics(&ctx, num_threads);
 
@@ -627,7 +706,9 @@ int run_gil_test(int num_threads, int total_acquisitions, int hold_time_us, int
 
     /* Determine variant based on compile-time configuration */
     const char *variant;
-#if FASTCOND_GIL_USE_NATIVE_COND
+#if FASTCOND_GIL_USE_FUTEX
+    variant = "futex_gil";
+#elif FASTCOND_GIL_USE_NATIVE_COND
     variant = "native_gil";
 #else
     variant = "fastcond_gil";
@@ -703,6 +784,18 @@ void test_gil_yield()
     fastcond_gil_yield(&gil);
     printf("  ✅ Yielded GIL (no waiters)\n");
 
+#if FASTCOND_GIL_RECURSIVE
+    // Nested acquires count depth; yield keeps it; only the outermost release lets go
+    fastcond_gil_acquire(&gil);
+    fastcond_gil_acquire(&gil);
+    fastcond_gil_yield(&gil);
+    int nested_ok = gil.depth == 3;
+    fastcond_gil_release(&gil);
+    fastcond_gil_release(&gil);
+    nested_ok = nested_ok && gil.depth == 1;
+    printf("  %s Recursive acquire/yield/release (depth restored)\n", nested_ok ? "✅" : "❌");
+#endif
+
     // Release GIL
     fastcond_gil_release(&gil);
     printf("  ✅ Released GIL\n");
@@ -711,6 +804,462 @@ void test_gil_yield()
     printf("GIL yield API test completed successfully!\n");
 }
 
+// A second thread attempting the GIL with try_acquire (timeout_us < 0) or acquire_timeout
+struct timed_probe {
+    struct fastcond_gil *gil;
+    long long timeout_us;
+    int result;
+};
+
+static TEST_THREAD_FUNC_RETURN timed_probe_thread(void *arg)
+{
+    struct timed_probe *probe = (struct timed_probe *) arg;
+
+    if (probe->timeout_us < 0)
+        probe->result = fastcond_gil_try_acquire(probe->gil);
+    else
+        probe->result = fastcond_gil_acquire_timeout(probe->gil, probe->timeout_us);
+    if (probe->result == 0)
+        fastcond_gil_release(probe->gil);
+    TEST_THREAD_RETURN;
+}
+
+static int run_timed_probe(struct fastcond_gil *gil, long long timeout_us)
+{
+    struct timed_probe probe = {gil, timeout_us, -1};
+    test_thread_t thread;
+
+    if (test_thread_create(&thread, NULL, timed_probe_thread, &probe) != 0)
+        return -1;
+    test_thread_join(thread, NULL);
+    return probe.result;
+}
+
+// Verify fastcond_gil_try_acquire() and fastcond_gil_acquire_timeout()
+void test_gil_timed()
+{
+    int ok;
+
+    printf("\n=== GIL Try/Timed Acquire Test ===\n");
+
+    struct fastcond_gil gil;
+    fastcond_gil_init(&gil);
+
+    ok = fastcond_gil_try_acquire(&gil) == 0;
+    if (ok)
+        fastcond_gil_release(&gil);
+    printf("  %s try_acquire on a free GIL succeeds\n", ok ? "✅" : "❌");
+
+    fastcond_gil_acquire(&gil);
+    ok = run_timed_probe(&gil, -1) == EBUSY;
+    printf("  %s try_acquire on a held GIL returns EBUSY\n", ok ? "✅" : "❌");
+#if FASTCOND_GIL_MODE_NAIVE
+    printf("  ⏭️  acquire_timeout: not available in NAIVE mode\n");
+    fastcond_gil_release(&gil);
+#else
+    ok = run_timed_probe(&gil, 20000) == ETIMEDOUT && GIL_N_WAITING(gil) == 0;
+    printf("  %s acquire_timeout on a held GIL times out (n_waiting unwound)\n", ok ? "✅" : "❌");
+    fastcond_gil_release(&gil);
+
+    ok = run_timed_probe(&gil, 1000000) == 0;
+    printf("  %s acquire_timeout on a free GIL succeeds\n", ok ? "✅" : "❌");
+#endif
+
+    fastcond_gil_destroy(&gil);
+    printf("GIL try/timed acquire test completed!\n");
+}
+
+// A second thread blocking in acquire_ctx() with its own context
+struct ctx_probe {
+    struct fastcond_gil *gil;
+    fastcond_gil_thread_t thread;
+    volatile int started;
+};
+
+static TEST_THREAD_FUNC_RETURN ctx_probe_thread(void *arg)
+{
+    struct ctx_probe *probe = (struct ctx_probe *) arg;
+
+    fastcond_gil_thread_init(&probe->thread);
+    probe->started = 1;
+    fastcond_gil_acquire_ctx(probe->gil, &probe->thread);
+    fastcond_gil_release_ctx(probe->gil, &probe->thread);
+    TEST_THREAD_RETURN;
+}
+
+// Verify the per-thread context API and its counters
+void test_gil_thread_ctx()
+{
+    fastcond_gil_thread_t self;
+    int ok;
+
+    printf("\n=== GIL Thread Context Test ===\n");
+
+    struct fastcond_gil gil;
+    fastcond_gil_init(&gil);
+    fastcond_gil_thread_init(&self);
+
+    fastcond_gil_acquire_ctx(&gil, &self);
+    fastcond_gil_yield_ctx(&gil, &self);
+    fastcond_gil_release_ctx(&gil, &self);
+    ok = self.acquisitions == 2 && self.contended == 0;
+    printf("  %s acquire_ctx/yield_ctx/release_ctx counted (%llu acquisitions)\n",
+           ok ? "✅" : "❌", self.acquisitions);
+
+#if FASTCOND_GIL_MODE_NAIVE
+    printf("  ⏭️  contention count: NAIVE mode does not track waiters\n");
+#else
+    struct ctx_probe probe;
+    test_thread_t thread;
+
+    memset(&probe, 0, sizeof(probe));
+    probe.gil = &gil;
+    fastcond_gil_acquire_ctx(&gil, &self);
+    if (test_thread_create(&thread, NULL, ctx_probe_thread, &probe) == 0) {
+        while (!probe.started || GIL_N_WAITING(gil) == 0) {
+            usleep(1000);
+        }
+        fastcond_gil_release_ctx(&gil, &self);
+        test_thread_join(thread, NULL);
+        ok = probe.thread.acquisitions == 1 && probe.thread.contended == 1;
+    } else {
+        fastcond_gil_release_ctx(&gil, &self);
+        ok = 0;
+    }
+    printf("  %s Blocked acquire_ctx counted as contended\n", ok ? "✅" : "❌");
+#endif
+
+    fastcond_gil_destroy(&gil);
+    printf("GIL thread context test completed!\n");
+}
+
+#if !FASTCOND_GIL_USE_FUTEX
+// A thread waiting under the GIL for ready, the pattern of threading.Condition
+struct cond_probe {
+    struct fastcond_gil *gil;
+    fastcond_gil_cond_t cond;
+    volatile int waiting;
+    volatile int ready;
+    volatile int done;
+    volatile int holders; // threads that believe they hold the GIL
+    int overlap;          // the waiter returned while someone else held the GIL
+};
+
+static TEST_THREAD_FUNC_RETURN cond_probe_thread(void *arg)
+{
+    struct cond_probe *probe = (struct cond_probe *) arg;
+
+    fastcond_gil_acquire(probe->gil);
+    probe->waiting = 1;
+    while (!probe->ready) {
+        fastcond_gil_cond_wait(probe->gil, &probe->cond);
+    }
+    if (__sync_add_and_fetch(&probe->holders, 1) != 1)
+        probe->overlap = 1;
+    probe->done = 1;
+    __sync_sub_and_fetch(&probe->holders, 1);
+    fastcond_gil_release(probe->gil);
+    TEST_THREAD_RETURN;
+}
+
+// More signals and broadcasts before one release than the holder can queue, one waiter each
+#define COND_BURST (2 * FASTCOND_GIL_COND_DEFERRED + 1)
+
+struct cond_burst {
+    struct fastcond_gil *gil;
+    fastcond_gil_cond_t cond[COND_BURST];
+    volatile int next;
+    volatile int waiting;
+    volatile int ready;
+    volatile int done;
+    volatile int holders;
+    volatile int overlap;
+};
+
+static TEST_THREAD_FUNC_RETURN cond_burst_thread(void *arg)
+{
+    struct cond_burst *burst = (struct cond_burst *) arg;
+    int i = __sync_fetch_and_add(&burst->next, 1);
+
+    fastcond_gil_acquire(burst->gil);
+    burst->waiting++;
+    while (!burst->ready)
+        fastcond_gil_cond_wait(burst->gil, &burst->cond[i]);
+    if (__sync_add_and_fetch(&burst->holders, 1) != 1)
+        burst->overlap = 1;
+    burst->done++;
+    __sync_sub_and_fetch(&burst->holders, 1);
+    fastcond_gil_release(burst->gil);
+    TEST_THREAD_RETURN;
+}
+
+static void test_gil_cond_burst(struct fastcond_gil *gil)
+{
+    struct cond_burst burst;
+    test_thread_t threads[COND_BURST];
+    int i;
+
+    memset(&burst, 0, sizeof(burst));
+    burst.gil = gil;
+    for (i = 0; i < COND_BURST; i++) {
+#if FASTCOND_GIL_USE_NATIVE_COND
+        NATIVE_COND_INIT(&burst.cond[i]);
+#else
+        fastcond_cond_init(&burst.cond[i], NULL);
+#endif
+    }
+    for (i = 0; i < COND_BURST; i++)
+        test_thread_create(&threads[i], NULL, cond_burst_thread, &burst);
+
+    // Counted under the GIL before waiting, so once all have counted, all are waiting
+    for (;;) {
+        fastcond_gil_acquire(gil);
+        if (burst.waiting == COND_BURST)
+            break;
+        fastcond_gil_release(gil);
+        usleep(1000);
+    }
+    burst.ready = 1;
+    for (i = 0; i < COND_BURST; i++) {
+        if (i % 2)
+            fastcond_gil_cond_broadcast(gil, &burst.cond[i]);
+        else
+            fastcond_gil_cond_signal(gil, &burst.cond[i]);
+    }
+    fastcond_gil_release(gil);
+    for (i = 0; i < COND_BURST; i++)
+        test_thread_join(threads[i], NULL);
+
+    printf("  %s %d signals and broadcasts in one hold: every waiter returned holding the GIL\n",
+           burst.done == COND_BURST && !burst.overlap ? "✅" : "❌", COND_BURST);
+    for (i = 0; i < COND_BURST; i++) {
+#if FASTCOND_GIL_USE_NATIVE_COND
+        NATIVE_COND_DESTROY(&burst.cond[i]);
+#else
+        fastcond_cond_fini(&burst.cond[i]);
+#endif
+    }
+}
+#endif
+
+// Verify fastcond_gil_cond_wait() and deferred fastcond_gil_cond_signal()
+void test_gil_cond()
+{
+    printf("\n=== GIL Condition Variable Test ===\n");
+#if FASTCOND_GIL_USE_FUTEX
+    printf("  ⏭️  cond_wait: not available with the futex backend\n");
+#else
+    struct fastcond_gil gil;
+    struct cond_probe probe;
+    test_thread_t thread;
+    int deferred_ok;
+
+    fastcond_gil_init(&gil);
+    memset(&probe, 0, sizeof(probe));
+    probe.gil = &gil;
+#if FASTCOND_GIL_USE_NATIVE_COND
+    NATIVE_COND_INIT(&probe.cond);
+#else
+    fastcond_cond_init(&probe.cond, NULL);
+#endif
+    if (test_thread_create(&thread, NULL, cond_probe_thread, &probe) != 0) {
+        printf("  ❌ Could not create the waiting thread\n");
+        return;
+    }
+
+    // Getting the GIL after the waiter has announced itself means it is in cond_wait
+    for (;;) {
+        fastcond_gil_acquire(&gil);
+        if (probe.waiting)
+            break;
+        fastcond_gil_release(&gil);
+        usleep(1000);
+    }
+    __sync_add_and_fetch(&probe.holders, 1);
+    probe.ready = 1;
+    fastcond_gil_cond_signal(&gil, &probe.cond);
+    usleep(10000);
+    deferred_ok = !probe.done; // the signal must not take effect while we hold the GIL
+    __sync_sub_and_fetch(&probe.holders, 1);
+    fastcond_gil_release(&gil);
+    test_thread_join(thread, NULL);
+
+    printf("  %s cond_signal deferred until the signaller releases\n", deferred_ok ? "✅" : "❌");
+    printf("  %s cond_wait woken, returned holding the GIL\n",
+           probe.done && !probe.overlap ? "✅" : "❌");
+
+#if FASTCOND_GIL_USE_NATIVE_COND
+    NATIVE_COND_DESTROY(&probe.cond);
+#else
+    fastcond_cond_fini(&probe.cond);
+#endif
+    test_gil_cond_burst(&gil);
+    fastcond_gil_destroy(&gil);
+#endif
+    printf("GIL condition variable test completed!\n");
+}
+
+// Latency-critical threads acquiring in the top class against batch workers in class 0
+#define PRIO_URGENT 2
+#define PRIO_BATCH 4
+#define PRIO_ROUNDS 100
+
+struct prio_context {
+    struct fastcond_gil gil;
+    volatile int holders;
+    volatile int violations;
+    double wait_us[PRIO_URGENT + PRIO_BATCH][PRIO_ROUNDS];
+};
+
+struct prio_arg {
+    struct prio_context *ctx;
+    int index;
+    int level;
+};
+
+static TEST_THREAD_FUNC_RETURN prio_thread(void *arg)
+{
+    struct prio_arg *a = (struct prio_arg *) arg;
+    struct prio_context *ctx = a->ctx;
+    test_timespec_t start, end;
+
+    for (int i = 0; i < PRIO_ROUNDS; i++) {
+        test_clock_gettime(&start);
+        fastcond_gil_acquire_prio(&ctx->gil, a->level);
+        test_clock_gettime(&end);
+        ctx->wait_us[a->index][i] = test_timespec_diff(&end, &start) * 1e6;
+
+        if (__sync_add_and_fetch(&ctx->holders, 1) != 1)
+            __sync_add_and_fetch(&ctx->violations, 1);
+        do_work_with_sleep(100, 50);
+        __sync_sub_and_fetch(&ctx->holders, 1);
+        fastcond_gil_release(&ctx->gil);
+
+        // Batch workers come straight back; a reactor waits for its next event
+        if (a->level > 0)
+            usleep(200);
+    }
+    TEST_THREAD_RETURN;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+// Sort the waits of threads [first, first + n) and print their percentiles; returns the median
+static double print_prio_class(struct prio_context *ctx, int first, int n, int level)
+{
+    double waits[(PRIO_URGENT + PRIO_BATCH) * PRIO_ROUNDS];
+    int count = n * PRIO_ROUNDS;
+
+    memcpy(waits, ctx->wait_us[first], sizeof(double) * count);
+    qsort(waits, count, sizeof(double), compare_double);
+    printf("  Class %d (%d threads): p50 %.1f μs, p90 %.1f μs, p99 %.1f μs, max %.1f μs\n", level,
+           n, waits[count / 2], waits[count * 9 / 10], waits[count * 99 / 100], waits[count - 1]);
+    return waits[count / 2];
+}
+
+#if FASTCOND_GIL_PRIO && FASTCOND_GIL_RECURSIVE
+// A class 0 thread taking the GIL from a yielding holder notes the class the holder waits in
+struct prio_nested {
+    struct fastcond_gil gil;
+    volatile int top_waiting; // -1 until the other thread has had the GIL
+};
+
+static TEST_THREAD_FUNC_RETURN prio_nested_thread(void *arg)
+{
+    struct prio_nested *pn = (struct prio_nested *) arg;
+
+    fastcond_gil_acquire(&pn->gil);
+    pn->top_waiting = pn->gil.prio_waiting[FASTCOND_GIL_PRIO_LEVELS - 1];
+    fastcond_gil_release(&pn->gil);
+    TEST_THREAD_RETURN;
+}
+
+// A nested acquire_prio() must not change the class of the hold it nests in: a class 0
+// hold that yields after one still waits in class 0
+static void test_gil_prio_nested(void)
+{
+    struct prio_nested pn;
+    test_thread_t thread;
+
+    fastcond_gil_init(&pn.gil);
+    pn.top_waiting = -1;
+    fastcond_gil_acquire_prio(&pn.gil, 0);
+    fastcond_gil_acquire_prio(&pn.gil, FASTCOND_GIL_PRIO_LEVELS - 1);
+    fastcond_gil_release(&pn.gil);
+    if (test_thread_create(&thread, NULL, prio_nested_thread, &pn) != 0) {
+        fastcond_gil_release(&pn.gil);
+        fastcond_gil_destroy(&pn.gil);
+        printf("  ❌ Could not create the test thread\n");
+        return;
+    }
+    while (pn.top_waiting < 0) {
+        usleep(100);
+        fastcond_gil_yield(&pn.gil);
+    }
+    fastcond_gil_release(&pn.gil);
+    test_thread_join(thread, NULL);
+    fastcond_gil_destroy(&pn.gil);
+    printf("  %s Nested acquire_prio keeps the class of the hold\n",
+           pn.top_waiting == 0 ? "✅" : "❌");
+}
+#endif
+
+// Verify fastcond_gil_acquire_prio() and report wait percentiles per class
+void test_gil_prio()
+{
+    struct prio_context ctx;
+    struct prio_arg args[PRIO_URGENT + PRIO_BATCH];
+    test_thread_t threads[PRIO_URGENT + PRIO_BATCH];
+    int n = 0;
+    int ok;
+
+    printf("\n=== GIL Priority Class Test ===\n");
+
+    memset(&ctx, 0, sizeof(ctx));
+    fastcond_gil_init(&ctx.gil);
+    ok = fastcond_gil_acquire_prio(&ctx.gil, FASTCOND_GIL_PRIO_LEVELS) == EINVAL;
+    printf("  %s acquire_prio rejects a level out of range\n", ok ? "✅" : "❌");
+
+    // Urgent threads occupy the first PRIO_URGENT rows of wait_us
+    for (int i = 0; i < PRIO_URGENT + PRIO_BATCH; i++) {
+        args[i].ctx = &ctx;
+        args[i].index = i;
+        args[i].level = i < PRIO_URGENT ? FASTCOND_GIL_PRIO_LEVELS - 1 : 0;
+        if (test_thread_create(&threads[i], NULL, prio_thread, &args[i]) != 0)
+            break;
+        n++;
+    }
+    for (int i = 0; i < n; i++) {
+        test_thread_join(threads[i], NULL);
+    }
+    fastcond_gil_destroy(&ctx.gil);
+    if (n != PRIO_URGENT + PRIO_BATCH) {
+        printf("  ❌ Could not create the test threads\n");
+        return;
+    }
+
+    double urgent = print_prio_class(&ctx, 0, PRIO_URGENT, FASTCOND_GIL_PRIO_LEVELS - 1);
+    double batch = print_prio_class(&ctx, PRIO_URGENT, PRIO_BATCH, 0);
+    printf("  %s Priority classes: mutual exclusion held\n", ctx.violations == 0 ? "✅" : "❌");
+#if FASTCOND_GIL_PRIO
+    // Timing-dependent, so reported rather than required
+    printf("  %s Top class median wait below class 0 (%.1f vs %.1f μs)\n",
+           urgent < batch ? "✅" : "⚠️ ", urgent, batch);
+#else
+    (void) urgent;
+    (void) batch;
+    printf("  ⏭️  Classes not enforced: built without FASTCOND_GIL_PRIO\n");
+#endif
+#if FASTCOND_GIL_PRIO && FASTCOND_GIL_RECURSIVE
+    test_gil_prio_nested();
+#endif
+    printf("GIL priority class test completed!\n");
+}
+
 int main(int argc, char *argv[])
 {
     int num_threads = 8; // Increased for better statistical power (was 4)
@@ -773,6 +1322,10 @@ int main(int argc, char *argv[])
 
         // Run yield API test first
         test_gil_yield();
+        test_gil_timed();
+        test_gil_thread_ctx();
+        test_gil_cond();
+        test_gil_prio();
     }
 
     // Initialize random seed for release delay variance
@@ -0,0 +1,255 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#include "fastcond_pool.h"
+#include "fastcond_queue.h"
+#include "fastcond_sync.h"
+#include "test_portability.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Fork/Join Pool Benchmark
+ *
+ * Two task-parallel workloads on fastcond_pool_t, for 1, 2, 4 ... max_workers workers:
+ *
+ * 1. fib       - naive recursive Fibonacci, forking a task per call above a cutoff and
+ *                joining it with fastcond_pool_wait()
+ * 2. parallel-for - a loop over an array, split recursively in halves down to a grain size
+ *
+ * The parallel-for also runs on the design the pool replaces: the same number of threads
+ * taking grain-sized chunks from one mutex-protected queue (fastcond_queue_t), with a
+ * fastcond_latch_t for completion.  Results are checked against sequential runs.
+ *
+ * Usage: pool_benchmark [fib_n] [array_size] [grain] [max_workers]
+ */
+
+#define MAX_WORKERS 64
+#define FIB_CUTOFF 12 // below this, fib runs sequentially in its task
+
+struct fib_args {
+    fastcond_pool_t *pool;
+    int n;
+    long result;
+};
+
+static volatile long n_forks;
+
+static long fib_seq(int n)
+{
+    return n < 2 ? n : fib_seq(n - 1) + fib_seq(n - 2);
+}
+
+static void fib_task(void *arg)
+{
+    struct fib_args *a = (struct fib_args *) arg;
+    struct fib_args left, right;
+    fastcond_task_t task;
+
+    if (a->n < FIB_CUTOFF) {
+        a->result = fib_seq(a->n);
+        return;
+    }
+    __sync_fetch_and_add(&n_forks, 1);
+    left.pool = right.pool = a->pool;
+    left.n = a->n - 1;
+    right.n = a->n - 2;
+    fastcond_task_init(&task, fib_task, &left);
+    fastcond_pool_submit(a->pool, &task);
+    fib_task(&right);
+    fastcond_pool_wait(a->pool, &task);
+    a->result = left.result + right.result;
+}
+
+// The loop body: a little arithmetic per element
+static long pfor_range(long *data, int lo, int hi)
+{
+    long sum = 0;
+
+    for (int i = lo; i < hi; i++) {
+        data[i] = (data[i] * 31 + i) % 1000003;
+        sum += data[i];
+    }
+    return sum;
+}
+
+struct pfor_args {
+    fastcond_pool_t *pool;
+    long *data;
+    int lo, hi, grain;
+    long result;
+};
+
+static void pfor_task(void *arg)
+{
+    struct pfor_args *a = (struct pfor_args *) arg;
+    struct pfor_args left, right;
+    fastcond_task_t task;
+    int mid;
+
+    if (a->hi - a->lo <= a->grain) {
+        a->result = pfor_range(a->data, a->lo, a->hi);
+        return;
+    }
+    mid = a->lo + (a->hi - a->lo) / 2;
+    left = right = *a;
+    left.hi = mid;
+    right.lo = mid;
+    fastcond_task_init(&task, pfor_task, &left);
+    fastcond_pool_submit(a->pool, &task);
+    pfor_task(&right);
+    fastcond_pool_wait(a->pool, &task);
+    a->result = left.result + right.result;
+}
+
+// The global-queue baseline: chunk indices through one queue, completion on a latch
+struct global_context {
+    fastcond_queue_t queue;
+    fastcond_latch_t latch;
+    long *data;
+    int size, grain;
+    volatile long result;
+};
+
+TEST_THREAD_FUNC_RETURN global_worker(void *arg)
+{
+    struct global_context *ctx = (struct global_context *) arg;
+    void *item;
+
+    while (fastcond_queue_pop(&ctx->queue, &item) == 0) {
+        int lo = (int) ((size_t) item - 1) * ctx->grain;
+        int hi = lo + ctx->grain < ctx->size ? lo + ctx->grain : ctx->size;
+
+        __sync_fetch_and_add(&ctx->result, pfor_range(ctx->data, lo, hi));
+        fastcond_latch_count_down(&ctx->latch, 1);
+    }
+    TEST_THREAD_RETURN;
+}
+
+static double run_global(long *data, int size, int grain, int n_workers, long *result)
+{
+    struct global_context ctx;
+    test_thread_t threads[MAX_WORKERS];
+    test_timespec_t start, end;
+    int n_chunks = (size + grain - 1) / grain;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.data = data;
+    ctx.size = size;
+    ctx.grain = grain;
+    fastcond_queue_init(&ctx.queue, 1024);
+    fastcond_latch_init(&ctx.latch, n_chunks);
+    for (int t = 0; t < n_workers; t++)
+        test_thread_create(&threads[t], NULL, global_worker, &ctx);
+
+    test_clock_gettime(&start);
+    for (int c = 0; c < n_chunks; c++)
+        fastcond_queue_push(&ctx.queue, (void *) (size_t) (c + 1));
+    fastcond_latch_wait(&ctx.latch);
+    test_clock_gettime(&end);
+
+    fastcond_queue_close(&ctx.queue);
+    for (int t = 0; t < n_workers; t++)
+        test_thread_join(threads[t], NULL);
+    fastcond_latch_fini(&ctx.latch);
+    fastcond_queue_fini(&ctx.queue);
+    *result = ctx.result;
+    return test_timespec_diff(&end, &start);
+}
+
+// Submit one root task and wait for it; returns elapsed seconds
+static double run_root(fastcond_pool_t *pool, void (*fn)(void *), void *arg)
+{
+    fastcond_task_t root;
+    test_timespec_t start, end;
+
+    fastcond_task_init(&root, fn, arg);
+    test_clock_gettime(&start);
+    fastcond_pool_submit(pool, &root);
+    fastcond_pool_wait(pool, &root);
+    test_clock_gettime(&end);
+    return test_timespec_diff(&end, &start);
+}
+
+int main(int argc, char *argv[])
+{
+    int fib_n = 30;
+    int size = 1 << 22;
+    int grain = 4096;
+    int max_workers = 16;
+    long fib_expected, pfor_expected, result;
+    long *data;
+    int failed = 0;
+
+    if (argc > 1)
+        fib_n = atoi(argv[1]);
+    if (argc > 2)
+        size = atoi(argv[2]);
+    if (argc > 3)
+        grain = atoi(argv[3]);
+    if (argc > 4)
+        max_workers = atoi(argv[4]);
+    if (fib_n < FIB_CUTOFF || fib_n > 40 || size <= 0 || grain <= 0 || max_workers <= 0 ||
+        max_workers > MAX_WORKERS) {
+        fprintf(stderr, "Usage: %s [fib_n %d-40] [array_size] [grain] [max_workers 1-%d]\n",
+                argv[0], FIB_CUTOFF, MAX_WORKERS);
+        return 1;
+    }
+    data = calloc((size_t) size, sizeof(long));
+    if (!data) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    // Each parallel-for pass starts from zeroed data, so every pass has the same result
+    fib_expected = fib_seq(fib_n);
+    pfor_expected = pfor_range(data, 0, size);
+
+    printf("=== Fork/Join Pool Benchmark ===\n");
+    printf("Configuration: fib(%d) with cutoff %d, parallel-for over %d elements, grain %d\n\n",
+           fib_n, FIB_CUTOFF, size, grain);
+    printf("%7s | %10s %12s | %12s %14s\n", "workers", "fib ms", "forks/s", "pfor pool ms",
+           "pfor global ms");
+
+    for (int n_workers = 1; n_workers <= max_workers; n_workers *= 2) {
+        fastcond_pool_t pool;
+        struct fib_args fargs;
+        struct pfor_args pargs;
+        double t_fib, t_pfor, t_global;
+
+        if (fastcond_pool_init(&pool, n_workers) != 0) {
+            fprintf(stderr, "fastcond_pool_init failed\n");
+            return 1;
+        }
+        fargs.pool = &pool;
+        fargs.n = fib_n;
+        n_forks = 0;
+        t_fib = run_root(&pool, fib_task, &fargs);
+        failed |= fargs.result != fib_expected;
+
+        memset(data, 0, sizeof(long) * (size_t) size);
+        pargs.pool = &pool;
+        pargs.data = data;
+        pargs.lo = 0;
+        pargs.hi = size;
+        pargs.grain = grain;
+        t_pfor = run_root(&pool, pfor_task, &pargs);
+        failed |= pargs.result != pfor_expected;
+        fastcond_pool_fini(&pool);
+
+        memset(data, 0, sizeof(long) * (size_t) size);
+        t_global = run_global(data, size, grain, n_workers, &result);
+        failed |= result != pfor_expected;
+
+        printf("%7d | %10.1f %12.0f | %12.1f %14.1f\n", n_workers, t_fib * 1e3,
+               n_forks / t_fib, t_pfor * 1e3, t_global * 1e3);
+    }
+
+    free(data);
+    if (failed) {
+        printf("❌ Results: FAILED\n");
+        return 1;
+    }
+    printf("✅ Results: PASSED\n");
+    return 0;
+}
@@ -0,0 +1,117 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#include "fastcond_pool.h"
+#include "test_portability.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * fastcond_pool_t test
+ *
+ * 1. Argument checks
+ * 2. Tasks submitted from outside the pool all run, and fastcond_pool_wait() sees them done
+ * 3. Nested fork/join: fib computed by tasks that submit and wait on subtasks
+ * 4. fastcond_pool_fini() runs whatever is still queued before it stops the workers
+ *
+ * Usage: pool_test [workers] [tasks] [fib_n]
+ */
+
+static volatile int counter;
+
+static void count_task(void *arg)
+{
+    (void) arg;
+    __sync_fetch_and_add(&counter, 1);
+}
+
+struct fib_args {
+    fastcond_pool_t *pool;
+    int n;
+    long result;
+};
+
+static void fib_task(void *arg)
+{
+    struct fib_args *a = (struct fib_args *) arg;
+    struct fib_args left, right;
+    fastcond_task_t task;
+
+    if (a->n < 2) {
+        a->result = a->n;
+        return;
+    }
+    left.pool = right.pool = a->pool;
+    left.n = a->n - 1;
+    right.n = a->n - 2;
+    fastcond_task_init(&task, fib_task, &left);
+    fastcond_pool_submit(a->pool, &task);
+    fib_task(&right);
+    fastcond_pool_wait(a->pool, &task);
+    a->result = left.result + right.result;
+}
+
+static long fib(int n)
+{
+    return n < 2 ? n : fib(n - 1) + fib(n - 2);
+}
+
+int main(int argc, char *argv[])
+{
+    fastcond_pool_t pool;
+    fastcond_task_t *tasks;
+    fastcond_task_t root;
+    struct fib_args args;
+    int n_workers = 4;
+    int n_tasks = 10000;
+    int fib_n = 20;
+    int i;
+
+    if (argc > 1)
+        n_workers = atoi(argv[1]);
+    if (argc > 2)
+        n_tasks = atoi(argv[2]);
+    if (argc > 3)
+        fib_n = atoi(argv[3]);
+    if (n_workers <= 0 || n_tasks <= 0 || fib_n < 0 || fib_n > 30) {
+        fprintf(stderr, "Usage: %s [workers] [tasks] [fib_n 0-30]\n", argv[0]);
+        return 1;
+    }
+    tasks = malloc(sizeof(fastcond_task_t) * (size_t) n_tasks);
+    if (!tasks) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    printf("=== fastcond_pool_t test: %d workers ===\n", n_workers);
+    check(fastcond_pool_init(&pool, -1) == EINVAL, "init rejects a negative worker count");
+    check(fastcond_task_init(&root, NULL, NULL) == EINVAL, "task init rejects a NULL fn");
+
+    fastcond_pool_init(&pool, n_workers);
+    counter = 0;
+    for (i = 0; i < n_tasks; i++) {
+        fastcond_task_init(&tasks[i], count_task, NULL);
+        fastcond_pool_submit(&pool, &tasks[i]);
+    }
+    for (i = 0; i < n_tasks; i++)
+        fastcond_pool_wait(&pool, &tasks[i]);
+    check(counter == n_tasks, "external submits: every task runs once");
+
+    args.pool = &pool;
+    args.n = fib_n;
+    fastcond_task_init(&root, fib_task, &args);
+    fastcond_pool_submit(&pool, &root);
+    fastcond_pool_wait(&pool, &root);
+    check(args.result == fib(fib_n), "fork/join: fib by nested tasks");
+
+    counter = 0;
+    for (i = 0; i < n_tasks; i++) {
+        fastcond_task_init(&tasks[i], count_task, NULL);
+        fastcond_pool_submit(&pool, &tasks[i]);
+    }
+    fastcond_pool_fini(&pool);
+    check(counter == n_tasks, "fini runs the tasks still queued");
+
+    free(tasks);
+    return test_report("Pool");
+}
@@ -0,0 +1,180 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+/*
+ * Test for libfastcond_preload.so.  Written against plain pthreads and run with
+ *
+ *     LD_PRELOAD=libfastcond_preload.so ./preload_test
+ *
+ * It checks that:
+ * 1. Static (PTHREAD_COND_INITIALIZER) and zero-filled condition variables work
+ * 2. Signals and broadcasts sent without the mutex held are not lost
+ * 3. Timed waits time out, with both clocks
+ * 4. CLOCK_MONOTONIC condition variables and priority-inheriting mutexes fall back to
+ *    the real implementation
+ *
+ * The interposer's counters are looked up with dlsym(), so the test also runs (and
+ * reports that it is not interposed) without the library.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* RTLD_DEFAULT, pthread_cond_clockwait */
+#endif
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "test_portability.h"
+
+#define ITEMS 20000
+#define WAITERS 4
+
+static void deadline(clockid_t clock, long ms, struct timespec *ts)
+{
+    clock_gettime(clock, ts);
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+/* Producer/consumer counter with the signal sent after unlocking */
+struct channel {
+    pthread_mutex_t *mutex;
+    pthread_cond_t *cond;
+    int count;
+    int done;
+    long consumed;
+};
+
+static void *consumer(void *arg)
+{
+    struct channel *ch = arg;
+
+    pthread_mutex_lock(ch->mutex);
+    for (;;) {
+        while (ch->count == 0 && !ch->done)
+            pthread_cond_wait(ch->cond, ch->mutex);
+        if (ch->count == 0)
+            break;
+        ch->count--;
+        ch->consumed++;
+    }
+    pthread_mutex_unlock(ch->mutex);
+    return NULL;
+}
+
+static int run_channel(pthread_mutex_t *mutex, pthread_cond_t *cond)
+{
+    struct channel ch;
+    pthread_t threads[WAITERS];
+    struct timespec ts;
+    int i;
+
+    // One short wait first, so that the interposer settles on an implementation whether or
+    // not a consumer ever has to wait
+    pthread_mutex_lock(mutex);
+    deadline(CLOCK_MONOTONIC, 1, &ts);
+    pthread_cond_clockwait(cond, mutex, CLOCK_MONOTONIC, &ts);
+    pthread_mutex_unlock(mutex);
+
+    memset(&ch, 0, sizeof(ch));
+    ch.mutex = mutex;
+    ch.cond = cond;
+    for (i = 0; i < WAITERS; i++)
+        pthread_create(&threads[i], NULL, consumer, &ch);
+    for (i = 0; i < ITEMS; i++) {
+        pthread_mutex_lock(mutex);
+        ch.count++;
+        pthread_mutex_unlock(mutex);
+        pthread_cond_signal(cond);
+    }
+    pthread_mutex_lock(mutex);
+    ch.done = 1;
+    pthread_mutex_unlock(mutex);
+    pthread_cond_broadcast(cond);
+    for (i = 0; i < WAITERS; i++)
+        pthread_join(threads[i], NULL);
+    return ch.consumed == ITEMS;
+}
+
+static pthread_mutex_t static_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t static_cond = PTHREAD_COND_INITIALIZER;
+
+int main(void)
+{
+    void (*get_counts)(int *, int *);
+    int n_fastcond = 0, n_real = 0, interposed;
+    pthread_mutex_t mutex, pi_mutex;
+    pthread_mutexattr_t mattr;
+    pthread_condattr_t cattr;
+    pthread_cond_t cond, mono_cond, pi_cond, *heap_cond;
+    struct timespec ts;
+    int err;
+
+    *(void **) &get_counts = dlsym(RTLD_DEFAULT, "fastcond_preload_get_counts");
+    interposed = get_counts != NULL;
+    printf("=== fastcond preload test (%s) ===\n",
+           interposed ? "interposed" : "NOT interposed, real pthread_cond");
+
+    check(run_channel(&static_mutex, &static_cond), "Static condition variable");
+
+    heap_cond = calloc(1, sizeof(*heap_cond));
+    check(run_channel(&static_mutex, heap_cond), "Zero-filled condition variable");
+    pthread_cond_destroy(heap_cond);
+    free(heap_cond);
+
+    pthread_mutex_init(&mutex, NULL);
+    pthread_cond_init(&cond, NULL);
+    check(run_channel(&mutex, &cond), "Initialised condition variable");
+
+    pthread_mutex_lock(&mutex);
+    deadline(CLOCK_REALTIME, 20, &ts);
+    err = pthread_cond_timedwait(&cond, &mutex, &ts);
+    check(err == ETIMEDOUT, "pthread_cond_timedwait times out");
+    deadline(CLOCK_MONOTONIC, 20, &ts);
+    err = pthread_cond_clockwait(&cond, &mutex, CLOCK_MONOTONIC, &ts);
+    check(err == ETIMEDOUT, "pthread_cond_clockwait(CLOCK_MONOTONIC) times out");
+    err = pthread_mutex_trylock(&mutex);
+    check(err == EBUSY, "Timed-out waits return holding the mutex");
+    pthread_mutex_unlock(&mutex);
+    pthread_cond_destroy(&cond);
+
+    // CLOCK_MONOTONIC condition variable: real implementation
+    pthread_condattr_init(&cattr);
+    pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+    pthread_cond_init(&mono_cond, &cattr);
+    pthread_condattr_destroy(&cattr);
+    pthread_mutex_lock(&mutex);
+    deadline(CLOCK_MONOTONIC, 20, &ts);
+    err = pthread_cond_timedwait(&mono_cond, &mutex, &ts);
+    pthread_mutex_unlock(&mutex);
+    check(err == ETIMEDOUT, "CLOCK_MONOTONIC condition variable times out");
+    check(run_channel(&mutex, &mono_cond), "CLOCK_MONOTONIC condition variable");
+    pthread_cond_destroy(&mono_cond);
+
+    // Priority-inheriting mutex: real implementation
+    pthread_mutexattr_init(&mattr);
+    pthread_mutexattr_setprotocol(&mattr, PTHREAD_PRIO_INHERIT);
+    pthread_mutex_init(&pi_mutex, &mattr);
+    pthread_mutexattr_destroy(&mattr);
+    pthread_cond_init(&pi_cond, NULL);
+    check(run_channel(&pi_mutex, &pi_cond), "Priority-inheriting mutex");
+    pthread_cond_destroy(&pi_cond);
+    pthread_mutex_destroy(&pi_mutex);
+    pthread_mutex_destroy(&mutex);
+
+    if (interposed) {
+        get_counts(&n_fastcond, &n_real);
+        printf("Condition variables: %d fastcond, %d real\n", n_fastcond, n_real);
+        check(n_fastcond == 3 && n_real == 2, "Fallbacks chosen as expected");
+    }
+
+    return test_report("Preload");
+}
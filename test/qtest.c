@@ -6,6 +6,7 @@
 #include <string.h>
 
 #include "fastcond.h"
+#include "fastcond_queue.h"
 #include "native_primitives.h"
 #include "test_portability.h"
 
@@ -17,6 +18,10 @@
  *   (none)      - Use native condition variables (pthread_cond_t or CONDITION_VARIABLE)
  *   -DTEST_COND - Use fastcond strong condition variable
  *   -DTEST_WCOND - Use fastcond weak condition variable
+ *   -DTEST_MUTEX - With TEST_COND: use fastcond_mutex_t instead of the native mutex
+ *   -DTEST_QUEUE - Use the library fastcond_queue_t; receivers take up to QTEST_BATCH
+ *                  items per fastcond_queue_drain() call
+ *   -DNATIVE_MUTEX_KIND=n - Kind of the native mutex (see native_primitives.h)
  *
  * Environment variables:
  *   FASTCOND_CSV_OUTPUT - If set, output results in CSV format to specified file
@@ -32,6 +37,13 @@ typedef fastcond_wcond_t cond_t;
 #define COND_WAIT(c, m) fastcond_wcond_wait(&(c), &(m))
 #define COND_SIGNAL(c) fastcond_wcond_signal(&(c))
 #define COND_BROADCAST(c) fastcond_wcond_broadcast(&(c))
+#elif defined(TEST_COND) && defined(TEST_MUTEX)
+typedef fastcond_cond_t cond_t;
+#define COND_INIT(c) fastcond_cond_init(&(c), NULL)
+#define COND_DESTROY(c) fastcond_cond_fini(&(c))
+#define COND_WAIT(c, m) fastcond_cond_wait_fm(&(c), &(m))
+#define COND_SIGNAL(c) fastcond_cond_signal(&(c))
+#define COND_BROADCAST(c) fastcond_cond_broadcast(&(c))
 #elif defined(TEST_COND)
 typedef fastcond_cond_t cond_t;
 #define COND_INIT(c) fastcond_cond_init(&(c), NULL)
@@ -48,13 +60,53 @@ typedef native_cond_t cond_t;
 #define COND_BROADCAST(c) NATIVE_COND_BROADCAST(&(c))
 #endif
 
+#if defined(TEST_MUTEX)
+typedef fastcond_mutex_t mutex_t;
+#define MUTEX_INIT(m) fastcond_mutex_init((m), 0)
+#define MUTEX_DESTROY(m) fastcond_mutex_fini(m)
+#define MUTEX_LOCK(m) fastcond_mutex_lock(m)
+#define MUTEX_UNLOCK(m) fastcond_mutex_unlock(m)
+#else
+typedef native_mutex_t mutex_t;
+#define MUTEX_INIT(m) NATIVE_MUTEX_INIT(m)
+#define MUTEX_DESTROY(m) NATIVE_MUTEX_DESTROY(m)
+#define MUTEX_LOCK(m) NATIVE_MUTEX_LOCK(m)
+#define MUTEX_UNLOCK(m) NATIVE_MUTEX_UNLOCK(m)
+#endif
+
+/* Variant name suffix for a native mutex of a non-default kind (-DNATIVE_MUTEX_KIND=...) */
+#if defined(TEST_MUTEX) || NATIVE_MUTEX_KIND == NATIVE_MUTEX_KIND_DEFAULT
+#define MUTEX_SUFFIX ""
+#elif NATIVE_MUTEX_KIND == NATIVE_MUTEX_KIND_ADAPTIVE
+#define MUTEX_SUFFIX "_adaptive"
+#elif NATIVE_MUTEX_KIND == NATIVE_MUTEX_KIND_ERRORCHECK
+#define MUTEX_SUFFIX "_errorcheck"
+#else
+#define MUTEX_SUFFIX "_pi"
+#endif
+
 /*
  * This code tests parallelism by implementing a producer-consumer system
  * and push stuff through the queue
  */
 
+#if defined(TEST_QUEUE)
+#ifndef QTEST_BATCH
+#define QTEST_BATCH 16
+#endif
+
+/* Items are indices into stamps[], the times the items were sent */
 typedef struct _queue {
-    native_mutex_t mutex;
+    fastcond_queue_t fq;
+    test_timespec_t *stamps;
+    int max_send;
+    int n_senders;
+    volatile int n_claimed;      /* items claimed by senders */
+    volatile int n_senders_done; /* the last sender closes the queue */
+} queue_t;
+#else
+typedef struct _queue {
+    mutex_t mutex;
 
     test_timespec_t *queue; /* queue contains times when it was put in */
     int s_queue;            /* max size of queue */
@@ -66,6 +118,7 @@ typedef struct _queue {
     int max_send; /* how many packets to send? (termination test) */
     int n_sent;   /* total amount sent */
 } queue_t;
+#endif
 
 typedef struct _args {
     queue_t *queue;
@@ -81,19 +134,58 @@ typedef struct _args {
     float latency_max;
 } args_t;
 
+/* Compute, store and print a receiver's latency statistics */
+static void report_receiver(args_t *args, int n_got, int n_waits, int n_successful_waits,
+                            float sum_time, float sum_time2, float min_time, float max_time)
+{
+    float avg = 0.0f, variance = 0.0f, stdev = 0.0f;
+    if (n_got > 0) {
+        avg = sum_time / (float) n_got;
+        /* Correct variance formula: Var(X) = E[X²] - E[X]² */
+        if (n_got > 1) {
+            variance = (sum_time2 - (sum_time * sum_time) / (float) n_got) / (float) (n_got - 1);
+            stdev = sqrtf(variance);
+        }
+    } else {
+        /* No data collected - set min/max to 0 */
+        min_time = 0.0f;
+        max_time = 0.0f;
+    }
+
+    /* Store stats in args structure */
+    args->n_got = n_got;
+    args->n_waits = n_waits;
+    args->n_successful_waits = n_successful_waits;
+    args->latency_avg = avg;
+    args->latency_stdev = stdev;
+    args->latency_min = min_time;
+    args->latency_max = max_time;
+
+    /* Calculate spurious wakeups: waits that didn't result in data */
+    int spurious_wakeups = n_waits - n_successful_waits;
+
+    /* Only print if not in JSON mode */
+    const char *json_output = getenv("FASTCOND_JSON_OUTPUT");
+    if (!json_output || strcmp(json_output, "1") != 0) {
+        printf("receiver %d got %d latency avg %e stdev %e min %e max %e spurious %d\n",
+               args->id, n_got, avg, stdev, min_time, max_time, spurious_wakeups);
+    }
+}
+
+#if !defined(TEST_QUEUE)
 TEST_THREAD_FUNC_RETURN sender(void *arg)
 {
     args_t *args = (args_t *) arg;
     queue_t *q = args->queue;
     int n_sent = 0;
     int have_data = 0;
-    NATIVE_MUTEX_LOCK(&q->mutex);
+    MUTEX_LOCK(&q->mutex);
     while (q->n_sent < q->max_send) {
         if (!have_data) {
             /* simulate getting of the data */
-            NATIVE_MUTEX_UNLOCK(&q->mutex);
+            MUTEX_UNLOCK(&q->mutex);
             test_sched_yield();
-            NATIVE_MUTEX_LOCK(&q->mutex);
+            MUTEX_LOCK(&q->mutex);
             have_data = 1;
         }
         while (q->n_sent < q->max_send && q->n_queue >= q->s_queue)
@@ -116,7 +208,7 @@ TEST_THREAD_FUNC_RETURN sender(void *arg)
             }
         }
     }
-    NATIVE_MUTEX_UNLOCK(&q->mutex);
+    MUTEX_UNLOCK(&q->mutex);
     /* Only print if not in JSON mode */
     const char *json_output = getenv("FASTCOND_JSON_OUTPUT");
     if (!json_output || strcmp(json_output, "1") != 0) {
@@ -136,11 +228,11 @@ TEST_THREAD_FUNC_RETURN receiver(void *arg)
     float time, sum_time = 0.0, sum_time2 = 0.0; /* stats */
     float min_time = 1e9, max_time = 0.0;        /* min/max tracking */
     test_timespec_t data, now;
-    NATIVE_MUTEX_LOCK(&q->mutex);
+    MUTEX_LOCK(&q->mutex);
     while (q->n_sent < q->max_send || q->n_queue) {
         if (have_data) {
             /* simulate getting rid of the data */
-            NATIVE_MUTEX_UNLOCK(&q->mutex);
+            MUTEX_UNLOCK(&q->mutex);
             /* compute the delay */
             now.tv_sec -= data.tv_sec;
             now.tv_nsec -= data.tv_nsec;
@@ -157,7 +249,7 @@ TEST_THREAD_FUNC_RETURN receiver(void *arg)
             if (time > max_time)
                 max_time = time;
             test_sched_yield();
-            NATIVE_MUTEX_LOCK(&q->mutex);
+            MUTEX_LOCK(&q->mutex);
             have_data = 0;
         }
         while (q->n_sent < q->max_send && !q->n_queue) {
@@ -181,45 +273,68 @@ TEST_THREAD_FUNC_RETURN receiver(void *arg)
             COND_SIGNAL(q->not_full);
         }
     }
-    NATIVE_MUTEX_UNLOCK(&q->mutex);
-    /* compute stats */
-    {
-        float avg = 0.0f, variance = 0.0f, stdev = 0.0f;
-        if (n_got > 0) {
-            avg = sum_time / (float) n_got;
-            /* Correct variance formula: Var(X) = E[X²] - E[X]² */
-            if (n_got > 1) {
-                variance =
-                    (sum_time2 - (sum_time * sum_time) / (float) n_got) / (float) (n_got - 1);
-                stdev = sqrtf(variance);
-            }
-        } else {
-            /* No data collected - set min/max to 0 */
-            min_time = 0.0f;
-            max_time = 0.0f;
-        }
+    MUTEX_UNLOCK(&q->mutex);
+    report_receiver(args, n_got, n_waits, n_successful_waits, sum_time, sum_time2, min_time,
+                    max_time);
+    TEST_THREAD_RETURN;
+}
+#else /* TEST_QUEUE */
+TEST_THREAD_FUNC_RETURN sender(void *arg)
+{
+    args_t *args = (args_t *) arg;
+    queue_t *q = args->queue;
+    int n_sent = 0;
+    int i;
+    for (;;) {
+        /* simulate getting of the data */
+        test_sched_yield();
+        i = __sync_fetch_and_add(&q->n_claimed, 1);
+        if (i >= q->max_send)
+            break;
+        test_clock_gettime(&q->stamps[i]);
+        fastcond_queue_push(&q->fq, (void *) (size_t) i);
+        n_sent++;
+    }
+    if (__sync_add_and_fetch(&q->n_senders_done, 1) == q->n_senders)
+        fastcond_queue_close(&q->fq);
+    const char *json_output = getenv("FASTCOND_JSON_OUTPUT");
+    if (!json_output || strcmp(json_output, "1") != 0) {
+        printf("sender %d sent %d\n", args->id, n_sent);
+    }
+    TEST_THREAD_RETURN;
+}
 
-        /* Store stats in args structure */
-        args->n_got = n_got;
-        args->n_waits = n_waits;
-        args->n_successful_waits = n_successful_waits;
-        args->latency_avg = avg;
-        args->latency_stdev = stdev;
-        args->latency_min = min_time;
-        args->latency_max = max_time;
-
-        /* Calculate spurious wakeups: waits that didn't result in data */
-        int spurious_wakeups = n_waits - n_successful_waits;
-
-        /* Only print if not in JSON mode */
-        const char *json_output = getenv("FASTCOND_JSON_OUTPUT");
-        if (!json_output || strcmp(json_output, "1") != 0) {
-            printf("receiver %d got %d latency avg %e stdev %e min %e max %e spurious %d\n",
-                   args->id, n_got, avg, stdev, min_time, max_time, spurious_wakeups);
+TEST_THREAD_FUNC_RETURN receiver(void *arg)
+{
+    args_t *args = (args_t *) arg;
+    queue_t *q = args->queue;
+    void *items[QTEST_BATCH];
+    int active = 0;
+    int n_got = 0;
+    int n, k;
+    float time, sum_time = 0.0, sum_time2 = 0.0; /* stats */
+    float min_time = 1e9, max_time = 0.0;        /* min/max tracking */
+    test_timespec_t now;
+    while ((n = fastcond_queue_drain(&q->fq, items, QTEST_BATCH, &active)) > 0) {
+        test_clock_gettime(&now);
+        for (k = 0; k < n; k++) {
+            /* compute the delay, then simulate getting rid of the data */
+            time = (float) test_timespec_diff(&now, &q->stamps[(size_t) items[k]]);
+            sum_time += time;
+            sum_time2 += time * time;
+            if (time < min_time)
+                min_time = time;
+            if (time > max_time)
+                max_time = time;
+            test_sched_yield();
         }
+        n_got += n;
     }
+    /* Waits are counted by the queue, see main() */
+    report_receiver(args, n_got, 0, 0, sum_time, sum_time2, min_time, max_time);
     TEST_THREAD_RETURN;
 }
+#endif /* TEST_QUEUE */
 
 int main(int argc, char *argv[])
 {
@@ -233,6 +348,7 @@ int main(int argc, char *argv[])
     void *retval;
     test_timespec_t start_time, end_time;
     double elapsed_sec;
+    double wakeups_per_item = 0.0;
 
     /* Unbuffer stdout to ensure output appears immediately */
     setbuf(stdout, NULL);
@@ -255,15 +371,24 @@ int main(int argc, char *argv[])
     n_receivers = n_senders;
 
     /* init the queue */
+#if defined(TEST_QUEUE)
+    fastcond_queue_init(&q.fq, s_queue);
+    q.stamps = (test_timespec_t *) malloc(n_data * sizeof(test_timespec_t));
+    q.max_send = n_data;
+    q.n_senders = n_senders;
+    q.n_claimed = 0;
+    q.n_senders_done = 0;
+#else
     q.i_queue = q.n_queue = 0;
     q.s_queue = s_queue;
     q.queue = (test_timespec_t *) malloc(s_queue * sizeof(test_timespec_t));
 
     q.n_sent = 0;
     q.max_send = n_data;
-    NATIVE_MUTEX_INIT(&q.mutex);
+    MUTEX_INIT(&q.mutex);
     COND_INIT(q.not_empty);
     COND_INIT(q.not_full);
+#endif
 
     /* Start timing */
     test_clock_gettime(&start_time);
@@ -298,14 +423,31 @@ int main(int argc, char *argv[])
     /* Calculate elapsed time */
     elapsed_sec = test_timespec_diff(&end_time, &start_time);
 
+    /* Receiver wakeups (returns from a condition variable wait) per item */
+#if defined(TEST_QUEUE)
+    {
+        struct fastcond_queue_stats stats;
+        fastcond_queue_get_stats(&q.fq, &stats);
+        wakeups_per_item = (double) stats.pop_wakeups / n_data;
+    }
+#else
+    for (i = 0; i < n_receivers; i++)
+        wakeups_per_item += receivers[i].n_waits;
+    wakeups_per_item /= n_data;
+#endif
+
     /* Determine variant name */
     const char *variant;
-#if defined(TEST_WCOND)
-    variant = "fastcond_wcond";
+#if defined(TEST_QUEUE)
+    variant = "fastcond_queue";
+#elif defined(TEST_WCOND)
+    variant = "fastcond_wcond" MUTEX_SUFFIX;
+#elif defined(TEST_COND) && defined(TEST_MUTEX)
+    variant = "fastcond_cond_mutex";
 #elif defined(TEST_COND)
-    variant = "fastcond_cond";
+    variant = "fastcond_cond" MUTEX_SUFFIX;
 #else
-    variant = "native";
+    variant = "native" MUTEX_SUFFIX;
 #endif
 
     /* Check if JSON output is requested and output JSON format */
@@ -314,8 +456,9 @@ int main(int argc, char *argv[])
         printf("{\"test\":\"qtest\",\"variant\":\"%s\",", variant);
         printf("\"config\":{\"n_data\":%d,\"n_senders\":%d,\"n_receivers\":%d,\"queue_size\":%d},",
                n_data, n_senders, n_receivers, s_queue);
-        printf("\"timing\":{\"elapsed_sec\":%.9f,\"throughput\":%.2f},", elapsed_sec,
-               n_data / elapsed_sec);
+        printf("\"timing\":{\"elapsed_sec\":%.9f,\"throughput\":%.2f,"
+               "\"wakeups_per_item\":%.4f},",
+               elapsed_sec, n_data / elapsed_sec, wakeups_per_item);
         printf("\"per_thread\":[");
         for (i = 0; i < n_receivers; i++) {
             int spurious_wakeups = receivers[i].n_waits - receivers[i].n_successful_waits;
@@ -378,6 +521,7 @@ int main(int argc, char *argv[])
         printf("Queue size: %d\n", s_queue);
         printf("Total time: %.6f seconds\n", elapsed_sec);
         printf("Throughput: %.2f items/sec\n", n_data / elapsed_sec);
+        printf("Wakeups per item: %.3f\n", wakeups_per_item);
         printf("==========================\n");
 
         printf("All threads completed, cleaning up\n");
@@ -385,10 +529,15 @@ int main(int argc, char *argv[])
     }
 
     /* Cleanup */
+#if defined(TEST_QUEUE)
+    fastcond_queue_fini(&q.fq);
+    free(q.stamps);
+#else
     COND_DESTROY(q.not_empty);
     COND_DESTROY(q.not_full);
-    NATIVE_MUTEX_DESTROY(&q.mutex);
+    MUTEX_DESTROY(&q.mutex);
     free(q.queue);
+#endif
     free(receivers);
     free(senders);
 
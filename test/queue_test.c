@@ -0,0 +1,223 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#include "fastcond_queue.h"
+#include "test_portability.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * fastcond_queue_t test
+ *
+ * Single-threaded checks of the try, timed and close semantics, then an MPMC run: producers
+ * push tagged sequence numbers (half one at a time, half with push_n), consumers take them
+ * with pop, pop_n and drain in turn until the queue is closed.  Every item must arrive once,
+ * and each producer's items in the order it pushed them.
+ *
+ * Usage: queue_test [producers] [consumers] [items_per_producer] [capacity] [batch]
+ */
+
+#define MAX_THREADS 32
+
+struct queue_context {
+    fastcond_queue_t queue;
+    int items;
+    int batch;
+    unsigned char *seen; // per item: times received
+    volatile int order_violations;
+    volatile long long n_pops; // pop/pop_n calls that returned items
+};
+
+struct queue_thread_args {
+    struct queue_context *ctx;
+    int id;
+    long received;
+};
+
+TEST_THREAD_FUNC_RETURN producer(void *arg)
+{
+    struct queue_thread_args *args = (struct queue_thread_args *) arg;
+    struct queue_context *ctx = args->ctx;
+    void *batch[64];
+    int seq = 0;
+
+    while (seq < ctx->items) {
+        if (args->id % 2 == 0) {
+            fastcond_queue_push(&ctx->queue, test_make_item(args->id, ctx->items, seq++));
+        } else {
+            int n = 0;
+            while (n < ctx->batch && seq < ctx->items)
+                batch[n++] = test_make_item(args->id, ctx->items, seq++);
+            fastcond_queue_push_n(&ctx->queue, batch, n);
+        }
+    }
+    TEST_THREAD_RETURN;
+}
+
+TEST_THREAD_FUNC_RETURN consumer(void *arg)
+{
+    struct queue_thread_args *args = (struct queue_thread_args *) arg;
+    struct queue_context *ctx = args->ctx;
+    int last[MAX_THREADS];
+    void *batch[64];
+    int active = 0;
+    int i, n;
+
+    for (i = 0; i < MAX_THREADS; i++)
+        last[i] = -1;
+    for (;;) {
+        if (args->id % 3 == 0)
+            n = fastcond_queue_pop(&ctx->queue, &batch[0]) == 0 ? 1 : 0;
+        else if (args->id % 3 == 1)
+            n = fastcond_queue_pop_n(&ctx->queue, batch, ctx->batch);
+        else
+            n = fastcond_queue_drain(&ctx->queue, batch, ctx->batch, &active);
+        if (n == 0)
+            break;
+        __sync_fetch_and_add(&ctx->n_pops, 1);
+        for (i = 0; i < n; i++) {
+            size_t v = test_item_index(batch[i]);
+            int p = (int) (v / (size_t) ctx->items);
+            int seq = (int) (v % (size_t) ctx->items);
+            // seen[] entries are distinct per item, so no two consumers write the same one
+            ctx->seen[v]++;
+            if (seq <= last[p])
+                __sync_fetch_and_add(&ctx->order_violations, 1);
+            last[p] = seq;
+        }
+        args->received += n;
+    }
+    TEST_THREAD_RETURN;
+}
+
+static void test_single_threaded(void)
+{
+    fastcond_queue_t q;
+    void *items[4] = {(void *) 1, (void *) 2, (void *) 3, (void *) 4};
+    void *out[4];
+    void *item = NULL;
+    struct timespec ts;
+    int active = 0;
+    int ok;
+
+    check(fastcond_queue_init(&q, 0) == EINVAL, "init rejects capacity 0");
+    fastcond_queue_init(&q, 3);
+
+    check(fastcond_queue_trypop(&q, &item) == EAGAIN, "trypop on an empty queue: EAGAIN");
+    native_deadline_us(&ts, 10000);
+    check(fastcond_queue_timedpop(&q, &item, &ts) == ETIMEDOUT, "timedpop times out when empty");
+
+    check(fastcond_queue_push_n(&q, items, 3) == 3, "push_n fills the queue");
+    check(fastcond_queue_trypush(&q, items[3]) == EAGAIN, "trypush on a full queue: EAGAIN");
+    native_deadline_us(&ts, 10000);
+    check(fastcond_queue_timedpush(&q, items[3], &ts) == ETIMEDOUT,
+          "timedpush times out when full");
+    ok = fastcond_queue_pop(&q, &item) == 0 && item == items[0];
+    ok = ok && fastcond_queue_trypush(&q, items[3]) == 0; // wraps around
+    ok = ok && fastcond_queue_pop_n(&q, out, 4) == 3;
+    ok = ok && out[0] == items[1] && out[1] == items[2] && out[2] == items[3];
+    check(ok, "FIFO order across the wrap-around");
+
+    fastcond_queue_push(&q, items[0]);
+    fastcond_queue_close(&q);
+    check(fastcond_queue_push(&q, items[1]) == EPIPE, "push after close: EPIPE");
+    ok = fastcond_queue_pop(&q, &item) == 0 && item == items[0];
+    check(ok && fastcond_queue_pop(&q, &item) == EPIPE, "close drains, then pop: EPIPE");
+    check(fastcond_queue_pop_n(&q, out, 4) == 0, "pop_n on a closed, empty queue returns 0");
+    fastcond_queue_fini(&q);
+
+    // drain() leaves the caller active until its next call, and clears the flag at the end
+    fastcond_queue_init(&q, 4);
+    fastcond_queue_push_n(&q, items, 4);
+    ok = fastcond_queue_drain(&q, out, 3, &active) == 3 && active && q.n_active == 1;
+    ok = ok && fastcond_queue_drain(&q, out, 3, &active) == 1 && out[0] == items[3];
+    fastcond_queue_close(&q);
+    ok = ok && fastcond_queue_drain(&q, out, 3, &active) == 0 && !active && q.n_active == 0;
+    check(ok, "drain tracks the active consumer");
+    fastcond_queue_fini(&q);
+}
+
+int main(int argc, char *argv[])
+{
+    int n_producers = 4;
+    int n_consumers = 4;
+    int items = 50000;
+    int capacity = 64;
+    int batch = 16;
+    struct queue_context ctx;
+    struct fastcond_queue_stats stats;
+    test_thread_t producers[MAX_THREADS], consumers[MAX_THREADS];
+    struct queue_thread_args pargs[MAX_THREADS], cargs[MAX_THREADS];
+    test_timespec_t start, end;
+    long total = 0, missing = 0;
+    double elapsed;
+    int i;
+
+    if (argc > 1)
+        n_producers = atoi(argv[1]);
+    if (argc > 2)
+        n_consumers = atoi(argv[2]);
+    if (argc > 3)
+        items = atoi(argv[3]);
+    if (argc > 4)
+        capacity = atoi(argv[4]);
+    if (argc > 5)
+        batch = atoi(argv[5]);
+    if (n_producers <= 0 || n_producers > MAX_THREADS || n_consumers <= 0 ||
+        n_consumers > MAX_THREADS || items <= 0 || capacity <= 0 || batch <= 0 || batch > 64) {
+        fprintf(stderr,
+                "Usage: %s [producers 1-%d] [consumers 1-%d] [items] [capacity] [batch 1-64]\n",
+                argv[0], MAX_THREADS, MAX_THREADS);
+        return 1;
+    }
+
+    printf("=== fastcond_queue_t test ===\n");
+    test_single_threaded();
+
+    printf("\nMPMC: %d producers x %d items, %d consumers, capacity %d, batch %d\n", n_producers,
+           items, n_consumers, capacity, batch);
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.items = items;
+    ctx.batch = batch;
+    ctx.seen = calloc((size_t) n_producers * items, 1);
+    if (!ctx.seen || fastcond_queue_init(&ctx.queue, capacity) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    test_clock_gettime(&start);
+    for (i = 0; i < n_consumers; i++) {
+        cargs[i].ctx = &ctx;
+        cargs[i].id = i;
+        cargs[i].received = 0;
+        test_thread_create(&consumers[i], NULL, consumer, &cargs[i]);
+    }
+    for (i = 0; i < n_producers; i++) {
+        pargs[i].ctx = &ctx;
+        pargs[i].id = i;
+        test_thread_create(&producers[i], NULL, producer, &pargs[i]);
+    }
+    for (i = 0; i < n_producers; i++)
+        test_thread_join(producers[i], NULL);
+    fastcond_queue_close(&ctx.queue);
+    for (i = 0; i < n_consumers; i++) {
+        test_thread_join(consumers[i], NULL);
+        total += cargs[i].received;
+    }
+    test_clock_gettime(&end);
+    elapsed = test_timespec_diff(&end, &start);
+
+    for (i = 0; i < n_producers * items; i++)
+        missing += ctx.seen[i] != 1;
+    fastcond_queue_get_stats(&ctx.queue, &stats);
+    printf("Throughput: %.0f items/s, %.2f items per pop call, %.3f wakeups per item\n",
+           total / elapsed, ctx.n_pops ? (double) total / ctx.n_pops : 0.0,
+           total ? (double) stats.pop_wakeups / total : 0.0);
+    check(total == (long) n_producers * items && missing == 0, "MPMC: every item received once");
+    check(ctx.order_violations == 0, "MPMC: per-producer FIFO order");
+
+    fastcond_queue_fini(&ctx.queue);
+    free(ctx.seen);
+    return test_report("Queue");
+}
@@ -54,6 +54,13 @@ echo ""
 echo "--- Native pthread Backend (Unfair) ---"
 ${EXEC_PREFIX}gil_test_native_unfair $THREADS $TOTAL_ACQUISITIONS $HOLD_TIME_US $WORK_CYCLES
 
+# The futex backend is built on Linux only
+if [ -f "${EXEC_PREFIX}gil_test_futex" ]; then
+    echo ""
+    echo "--- futex Backend (Fair) ---"
+    ${EXEC_PREFIX}gil_test_futex $THREADS $TOTAL_ACQUISITIONS $HOLD_TIME_US $WORK_CYCLES
+fi
+
 echo ""
 echo ">>> Running Performance Benchmarks <<<"
 echo ""
@@ -75,6 +82,12 @@ echo ""
 echo "--- Native pthread Backend (Unfair) Performance ---"
 ${EXEC_PREFIX}gil_benchmark_native_unfair $THREADS $BENCH_ITERATIONS
 
+if [ -f "${EXEC_PREFIX}gil_benchmark_futex" ]; then
+    echo ""
+    echo "--- futex Backend (Fair) Performance ---"
+    ${EXEC_PREFIX}gil_benchmark_futex $THREADS $BENCH_ITERATIONS
+fi
+
 echo ""
 echo "======================================================================"
 echo "Comprehensive Comparative Testing Complete"
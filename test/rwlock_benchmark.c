@@ -0,0 +1,202 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#include "fastcond_rwlock.h"
+#include "test_portability.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Read-Mostly Reader-Writer Lock Benchmark
+ *
+ * Models a routing table: T threads look entries up under a read lock and, for a small
+ * fraction of operations, rewrite the whole table under a write lock.  For the 95/5 and
+ * 99/1 read/write mixes and T = 1, 2, 4 ... max_threads it runs
+ *
+ * 1. fc-writer - fastcond_rwlock_t preferring writers
+ * 2. fc-reader - fastcond_rwlock_t preferring readers
+ * 3. pthread   - pthread_rwlock_t (POSIX only)
+ *
+ * and reports operations per second.  Writers stamp every entry with the same version and
+ * readers check that the entries they see agree, so a reader overlapping a writer is caught.
+ *
+ * Usage: rwlock_benchmark [ops_per_thread] [max_threads] [table_size]
+ */
+
+#define MAX_THREADS 64
+#define MAX_TABLE 4096
+#define LOOKUPS 4 // entries read per read lock
+
+enum bench_lock { LOCK_FC_WRITER, LOCK_FC_READER, LOCK_PTHREAD, N_LOCKS };
+
+static const char *lock_names[N_LOCKS] = {"fc-writer", "fc-reader", "pthread"};
+
+struct bench_context {
+    enum bench_lock kind;
+    int ops;
+    int write_permille;
+    int table_size;
+    fastcond_rwlock_t fc;
+#if !TEST_USE_WINDOWS
+    pthread_rwlock_t pt;
+#endif
+    volatile long table[MAX_TABLE];
+    volatile int violations;
+};
+
+static void bench_rdlock(struct bench_context *ctx)
+{
+#if !TEST_USE_WINDOWS
+    if (ctx->kind == LOCK_PTHREAD) {
+        pthread_rwlock_rdlock(&ctx->pt);
+        return;
+    }
+#endif
+    fastcond_rwlock_rdlock(&ctx->fc);
+}
+
+static void bench_wrlock(struct bench_context *ctx)
+{
+#if !TEST_USE_WINDOWS
+    if (ctx->kind == LOCK_PTHREAD) {
+        pthread_rwlock_wrlock(&ctx->pt);
+        return;
+    }
+#endif
+    fastcond_rwlock_wrlock(&ctx->fc);
+}
+
+static void bench_unlock(struct bench_context *ctx)
+{
+#if !TEST_USE_WINDOWS
+    if (ctx->kind == LOCK_PTHREAD) {
+        pthread_rwlock_unlock(&ctx->pt);
+        return;
+    }
+#endif
+    fastcond_rwlock_unlock(&ctx->fc);
+}
+
+TEST_THREAD_FUNC_RETURN table_worker(void *arg)
+{
+    struct bench_context *ctx = (struct bench_context *) arg;
+    unsigned seed = (unsigned) (size_t) &seed;
+
+    for (int i = 0; i < ctx->ops; i++) {
+        seed = seed * 1103515245u + 12345u;
+        if ((int) ((seed >> 16) % 1000) < ctx->write_permille) {
+            bench_wrlock(ctx);
+            long version = ctx->table[0] + 1;
+            for (int e = 0; e < ctx->table_size; e++)
+                ctx->table[e] = version;
+            bench_unlock(ctx);
+        } else {
+            bench_rdlock(ctx);
+            long version = ctx->table[0];
+            for (int k = 0; k < LOOKUPS; k++) {
+                int e = (int) ((seed >> (k * 4)) % (unsigned) ctx->table_size);
+                if (ctx->table[e] != version)
+                    __sync_add_and_fetch(&ctx->violations, 1);
+            }
+            bench_unlock(ctx);
+        }
+    }
+    TEST_THREAD_RETURN;
+}
+
+// Run one lock; returns elapsed seconds, or a negative value on error
+static double run_lock(struct bench_context *ctx, int n_threads)
+{
+    test_thread_t threads[MAX_THREADS];
+    test_timespec_t start, end;
+
+    memset((void *) ctx->table, 0, sizeof(ctx->table));
+    test_clock_gettime(&start);
+    for (int t = 0; t < n_threads; t++) {
+        if (test_thread_create(&threads[t], NULL, table_worker, ctx) != 0) {
+            fprintf(stderr, "Error creating thread %d\n", t);
+            return -1.0;
+        }
+    }
+    for (int t = 0; t < n_threads; t++) {
+        test_thread_join(threads[t], NULL);
+    }
+    test_clock_gettime(&end);
+    return test_timespec_diff(&end, &start);
+}
+
+int main(int argc, char *argv[])
+{
+    static const int write_permille[] = {50, 10}; // the 95/5 and 99/1 mixes
+    static struct bench_context ctx;
+    int ops = 200000;
+    int max_threads = 16;
+    int table_size = 256;
+    int violations = 0;
+
+    if (argc > 1)
+        ops = atoi(argv[1]);
+    if (argc > 2)
+        max_threads = atoi(argv[2]);
+    if (argc > 3)
+        table_size = atoi(argv[3]);
+    if (ops <= 0 || max_threads <= 0 || max_threads > MAX_THREADS || table_size <= 0 ||
+        table_size > MAX_TABLE) {
+        fprintf(stderr, "Usage: %s [ops_per_thread] [max_threads 1-%d] [table_size 1-%d]\n",
+                argv[0], MAX_THREADS, MAX_TABLE);
+        return 1;
+    }
+
+    printf("=== Read-Mostly Reader-Writer Lock Benchmark ===\n");
+    printf("Configuration: %d ops per thread, table of %d entries\n", ops, table_size);
+
+    for (int m = 0; m < 2; m++) {
+        printf("\nMix %d/%d (reads/writes), ops/s:\n", 100 - write_permille[m] / 10,
+               write_permille[m] / 10);
+        printf("%7s", "threads");
+        for (int k = 0; k < N_LOCKS; k++)
+            printf(" | %12s", lock_names[k]);
+        printf("\n");
+
+        for (int n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+            printf("%7d", n_threads);
+            for (int k = 0; k < N_LOCKS; k++) {
+                double elapsed;
+
+                ctx.kind = (enum bench_lock) k;
+                ctx.ops = ops;
+                ctx.write_permille = write_permille[m];
+                ctx.table_size = table_size;
+                ctx.violations = 0;
+                if (k == LOCK_PTHREAD) {
+#if !TEST_USE_WINDOWS
+                    pthread_rwlock_init(&ctx.pt, NULL);
+                    elapsed = run_lock(&ctx, n_threads);
+                    pthread_rwlock_destroy(&ctx.pt);
+#else
+                    printf(" | %12s", "-");
+                    continue;
+#endif
+                } else {
+                    fastcond_rwlock_init(&ctx.fc, k == LOCK_FC_WRITER
+                                                      ? FASTCOND_RWLOCK_PREFER_WRITER
+                                                      : FASTCOND_RWLOCK_PREFER_READER);
+                    elapsed = run_lock(&ctx, n_threads);
+                    fastcond_rwlock_fini(&ctx.fc);
+                }
+                if (elapsed <= 0)
+                    return 1;
+                violations += ctx.violations;
+                printf(" | %12.0f", (double) ops * n_threads / elapsed);
+            }
+            printf("\n");
+        }
+    }
+
+    if (violations) {
+        printf("❌ Reader-writer exclusion: FAILED (%d torn reads)\n", violations);
+        return 1;
+    }
+    printf("✅ Reader-writer exclusion: PASSED\n");
+    return 0;
+}
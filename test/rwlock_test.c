@@ -0,0 +1,148 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#include "fastcond_rwlock.h"
+#include "test_portability.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * fastcond_rwlock_t test
+ *
+ * Single-threaded checks of the try operations, a check that a blocked writer holds off new
+ * readers only when writers are preferred, then a mixed run for each preference: readers
+ * and writers take the lock at random, and inside it count themselves, so that a writer
+ * alongside anyone else is caught.
+ *
+ * Usage: rwlock_test [threads] [iterations]
+ */
+
+#define MAX_THREADS 64
+#define WRITE_EVERY 8 // one write lock per this many locks, per thread
+
+struct rwlock_context {
+    fastcond_rwlock_t lock;
+    int iterations;
+    volatile int readers;
+    volatile int writers;
+    volatile int violations;
+};
+
+TEST_THREAD_FUNC_RETURN mixed_worker(void *arg)
+{
+    struct rwlock_context *ctx = (struct rwlock_context *) arg;
+    unsigned seed = (unsigned) (size_t) &seed;
+
+    for (int i = 0; i < ctx->iterations; i++) {
+        seed = seed * 1103515245u + 12345u;
+        if ((seed >> 16) % WRITE_EVERY == 0) {
+            fastcond_rwlock_wrlock(&ctx->lock);
+            if (__sync_add_and_fetch(&ctx->writers, 1) != 1 || ctx->readers != 0)
+                __sync_add_and_fetch(&ctx->violations, 1);
+            __sync_sub_and_fetch(&ctx->writers, 1);
+        } else {
+            fastcond_rwlock_rdlock(&ctx->lock);
+            __sync_add_and_fetch(&ctx->readers, 1);
+            if (ctx->writers != 0)
+                __sync_add_and_fetch(&ctx->violations, 1);
+            __sync_sub_and_fetch(&ctx->readers, 1);
+        }
+        fastcond_rwlock_unlock(&ctx->lock);
+    }
+    TEST_THREAD_RETURN;
+}
+
+TEST_THREAD_FUNC_RETURN blocked_writer(void *arg)
+{
+    struct rwlock_context *ctx = (struct rwlock_context *) arg;
+
+    fastcond_rwlock_wrlock(&ctx->lock);
+    fastcond_rwlock_unlock(&ctx->lock);
+    TEST_THREAD_RETURN;
+}
+
+static void test_single_threaded(void)
+{
+    fastcond_rwlock_t lock;
+    int ok;
+
+    check(fastcond_rwlock_init(&lock, 2) == EINVAL, "init rejects an unknown preference");
+    fastcond_rwlock_init(&lock, FASTCOND_RWLOCK_PREFER_WRITER);
+    ok = fastcond_rwlock_tryrdlock(&lock) == 0 && fastcond_rwlock_tryrdlock(&lock) == 0;
+    check(ok && fastcond_rwlock_trywrlock(&lock) == EBUSY, "readers share, and keep writers out");
+    fastcond_rwlock_unlock(&lock);
+    fastcond_rwlock_unlock(&lock);
+    ok = fastcond_rwlock_trywrlock(&lock) == 0;
+    ok = ok && fastcond_rwlock_tryrdlock(&lock) == EBUSY;
+    ok = ok && fastcond_rwlock_trywrlock(&lock) == EBUSY;
+    check(ok, "a writer excludes readers and writers");
+    fastcond_rwlock_unlock(&lock);
+    check(lock.state == 0, "unlock leaves the lock free");
+    fastcond_rwlock_fini(&lock);
+}
+
+// With a read lock held and a writer blocked behind it, may another reader enter?
+static int reader_enters_past_writer(int prefer)
+{
+    struct rwlock_context ctx = {0};
+    test_thread_t writer;
+    int entered;
+
+    fastcond_rwlock_init(&ctx.lock, prefer);
+    fastcond_rwlock_rdlock(&ctx.lock);
+    test_thread_create(&writer, NULL, blocked_writer, &ctx);
+    while (native_atomic_load(&ctx.lock.n_writers_waiting) == 0)
+        usleep(1000);
+    entered = fastcond_rwlock_tryrdlock(&ctx.lock) == 0;
+    if (entered)
+        fastcond_rwlock_unlock(&ctx.lock);
+    fastcond_rwlock_unlock(&ctx.lock);
+    test_thread_join(writer, NULL);
+    fastcond_rwlock_fini(&ctx.lock);
+    return entered;
+}
+
+static void test_mixed(int prefer, int n_threads, int iterations, const char *what)
+{
+    struct rwlock_context ctx = {0};
+    test_thread_t threads[MAX_THREADS];
+    int i;
+
+    fastcond_rwlock_init(&ctx.lock, prefer);
+    ctx.iterations = iterations;
+    for (i = 0; i < n_threads; i++)
+        test_thread_create(&threads[i], NULL, mixed_worker, &ctx);
+    for (i = 0; i < n_threads; i++)
+        test_thread_join(threads[i], NULL);
+    check(ctx.violations == 0 && ctx.lock.state == 0, what);
+    fastcond_rwlock_fini(&ctx.lock);
+}
+
+int main(int argc, char *argv[])
+{
+    int n_threads = 8;
+    int iterations = 20000;
+
+    if (argc > 1)
+        n_threads = atoi(argv[1]);
+    if (argc > 2)
+        iterations = atoi(argv[2]);
+    if (n_threads <= 0 || n_threads > MAX_THREADS || iterations <= 0) {
+        fprintf(stderr, "Usage: %s [threads 1-%d] [iterations]\n", argv[0], MAX_THREADS);
+        return 1;
+    }
+
+    printf("=== fastcond_rwlock_t test: %d threads, %d iterations ===\n", n_threads,
+           iterations);
+    test_single_threaded();
+    check(!reader_enters_past_writer(FASTCOND_RWLOCK_PREFER_WRITER),
+          "prefer writer: a waiting writer holds off new readers");
+    check(reader_enters_past_writer(FASTCOND_RWLOCK_PREFER_READER),
+          "prefer reader: new readers enter past a waiting writer");
+    test_mixed(FASTCOND_RWLOCK_PREFER_WRITER, n_threads, iterations,
+               "prefer writer: mutual exclusion under a mixed load");
+    test_mixed(FASTCOND_RWLOCK_PREFER_READER, n_threads, iterations,
+               "prefer reader: mutual exclusion under a mixed load");
+
+    return test_report("Rwlock");
+}
@@ -0,0 +1,171 @@
+/* Copyright (c) 2017-2025 Kristján Valur Jónsson */
+
+#include "fastcond_sync.h"
+#include "test_portability.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Tests for fastcond_sem_t, fastcond_barrier_t and fastcond_latch_t
+ *
+ * 1. Semaphore: try and timed waits on zero; producers post, consumers wait, every post
+ *    is consumed exactly once and the count ends at zero
+ * 2. Latch: nobody passes before the last count-down; try_wait; a zero latch is open
+ * 3. Barrier: over many phases no thread leaves a phase before all have arrived, and
+ *    exactly one thread per phase is the serial thread
+ *
+ * Usage: sync_test [threads] [iterations]
+ */
+
+#define MAX_THREADS 64
+
+struct sync_context {
+    int n_threads;
+    int iterations;
+    fastcond_sem_t sem;
+    fastcond_latch_t latch;
+    fastcond_barrier_t barrier;
+    volatile int consumed;
+    volatile int released;
+    volatile int arrived;
+    volatile int early; // barrier: left a phase before every thread arrived
+    volatile int serial;
+};
+
+TEST_THREAD_FUNC_RETURN sem_producer(void *arg)
+{
+    struct sync_context *ctx = (struct sync_context *) arg;
+    for (int i = 0; i < ctx->iterations; i++)
+        fastcond_sem_post(&ctx->sem);
+    TEST_THREAD_RETURN;
+}
+
+TEST_THREAD_FUNC_RETURN sem_consumer(void *arg)
+{
+    struct sync_context *ctx = (struct sync_context *) arg;
+    for (int i = 0; i < ctx->iterations; i++) {
+        fastcond_sem_wait(&ctx->sem);
+        __sync_fetch_and_add(&ctx->consumed, 1);
+    }
+    TEST_THREAD_RETURN;
+}
+
+TEST_THREAD_FUNC_RETURN latch_waiter(void *arg)
+{
+    struct sync_context *ctx = (struct sync_context *) arg;
+    fastcond_latch_wait(&ctx->latch);
+    __sync_fetch_and_add(&ctx->released, 1);
+    TEST_THREAD_RETURN;
+}
+
+TEST_THREAD_FUNC_RETURN barrier_worker(void *arg)
+{
+    struct sync_context *ctx = (struct sync_context *) arg;
+    for (int phase = 0; phase < ctx->iterations; phase++) {
+        __sync_fetch_and_add(&ctx->arrived, 1);
+        if (fastcond_barrier_wait(&ctx->barrier) == FASTCOND_BARRIER_SERIAL_THREAD)
+            __sync_fetch_and_add(&ctx->serial, 1);
+        if (__sync_fetch_and_add(&ctx->arrived, 0) < (phase + 1) * ctx->n_threads)
+            __sync_fetch_and_add(&ctx->early, 1);
+    }
+    TEST_THREAD_RETURN;
+}
+
+static void test_sem(struct sync_context *ctx)
+{
+    test_thread_t producers[MAX_THREADS], consumers[MAX_THREADS];
+    struct timespec ts;
+    int i;
+
+    fastcond_sem_init(&ctx->sem, 0);
+    check(fastcond_sem_trywait(&ctx->sem) == EAGAIN, "sem: trywait on zero gives EAGAIN");
+    native_deadline_us(&ts, 10000);
+    check(fastcond_sem_timedwait(&ctx->sem, &ts) == ETIMEDOUT, "sem: timedwait times out");
+    fastcond_sem_post(&ctx->sem);
+    native_deadline_us(&ts, 10000);
+    check(fastcond_sem_timedwait(&ctx->sem, &ts) == 0 && fastcond_sem_getvalue(&ctx->sem) == 0,
+          "sem: timedwait takes a posted count");
+
+    ctx->consumed = 0;
+    for (i = 0; i < ctx->n_threads; i++) {
+        test_thread_create(&consumers[i], NULL, sem_consumer, ctx);
+        test_thread_create(&producers[i], NULL, sem_producer, ctx);
+    }
+    for (i = 0; i < ctx->n_threads; i++) {
+        test_thread_join(producers[i], NULL);
+        test_thread_join(consumers[i], NULL);
+    }
+    check(ctx->consumed == ctx->n_threads * ctx->iterations &&
+              fastcond_sem_getvalue(&ctx->sem) == 0,
+          "sem: every post consumed once");
+    fastcond_sem_fini(&ctx->sem);
+}
+
+static void test_latch(struct sync_context *ctx)
+{
+    test_thread_t threads[MAX_THREADS];
+    int i, early;
+
+    fastcond_latch_init(&ctx->latch, 0);
+    check(fastcond_latch_try_wait(&ctx->latch) == 0, "latch: a zero latch is open");
+    fastcond_latch_fini(&ctx->latch);
+
+    fastcond_latch_init(&ctx->latch, 3);
+    ctx->released = 0;
+    for (i = 0; i < ctx->n_threads; i++)
+        test_thread_create(&threads[i], NULL, latch_waiter, ctx);
+    fastcond_latch_count_down(&ctx->latch, 1);
+    usleep(10000);
+    fastcond_latch_count_down(&ctx->latch, 1);
+    usleep(10000);
+    early = __sync_fetch_and_add(&ctx->released, 0);
+    check(early == 0 && fastcond_latch_try_wait(&ctx->latch) == EAGAIN,
+          "latch: nobody passes before the count reaches zero");
+    fastcond_latch_arrive_and_wait(&ctx->latch, 1);
+    for (i = 0; i < ctx->n_threads; i++)
+        test_thread_join(threads[i], NULL);
+    check(ctx->released == ctx->n_threads, "latch: every waiter released");
+    fastcond_latch_fini(&ctx->latch);
+}
+
+static void test_barrier(struct sync_context *ctx)
+{
+    test_thread_t threads[MAX_THREADS];
+    int i;
+
+    check(fastcond_barrier_init(&ctx->barrier, 0) == EINVAL, "barrier: count 0 is rejected");
+    fastcond_barrier_init(&ctx->barrier, ctx->n_threads);
+    ctx->arrived = ctx->early = ctx->serial = 0;
+    for (i = 0; i < ctx->n_threads; i++)
+        test_thread_create(&threads[i], NULL, barrier_worker, ctx);
+    for (i = 0; i < ctx->n_threads; i++)
+        test_thread_join(threads[i], NULL);
+    check(ctx->early == 0, "barrier: no thread leaves a phase early");
+    check(ctx->serial == ctx->iterations, "barrier: one serial thread per phase");
+    fastcond_barrier_fini(&ctx->barrier);
+}
+
+int main(int argc, char *argv[])
+{
+    struct sync_context ctx;
+
+    ctx.n_threads = 4;
+    ctx.iterations = 10000;
+    if (argc > 1)
+        ctx.n_threads = atoi(argv[1]);
+    if (argc > 2)
+        ctx.iterations = atoi(argv[2]);
+    if (ctx.n_threads <= 0 || ctx.n_threads > MAX_THREADS || ctx.iterations <= 0) {
+        fprintf(stderr, "Usage: %s [threads 1-%d] [iterations]\n", argv[0], MAX_THREADS);
+        return 1;
+    }
+
+    printf("=== fastcond sem/latch/barrier test: %d threads, %d iterations ===\n",
+           ctx.n_threads, ctx.iterations);
+    test_sem(&ctx);
+    test_latch(&ctx);
+    test_barrier(&ctx);
+
+    return test_report("Sync");
+}
@@ -12,6 +12,8 @@
 #ifndef TEST_PORTABILITY_H
 #define TEST_PORTABILITY_H
 
+#include <stdio.h> /* check(), test_report() */
+
 #ifdef _WIN32
 #define TEST_USE_WINDOWS 1
 #include <process.h> /* For _beginthread */
@@ -269,4 +271,43 @@ static inline double test_timespec_diff(const test_timespec_t *end, const test_t
     return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
 }
 
+/*
+ * Items for producer/consumer tests
+ * Item seq of producer p, with items per producer, is the pointer value p * items + seq + 1,
+ * so that none is NULL; test_item_index() turns it back into p * items + seq.
+ */
+static inline void *test_make_item(int producer, int items, int seq)
+{
+    return (void *) (size_t) ((size_t) producer * (size_t) items + (size_t) seq + 1);
+}
+
+static inline size_t test_item_index(void *item)
+{
+    return (size_t) item - 1;
+}
+
+/*
+ * Test results
+ * check() prints one result line and counts the failures; test_report() prints the
+ * closing line that ctest matches ("✅ <name> test PASSED") and returns main()'s status.
+ */
+static int test_failures;
+
+static inline void check(int ok, const char *what)
+{
+    printf("%s %s\n", ok ? "✅" : "❌", what);
+    if (!ok)
+        test_failures++;
+}
+
+static inline int test_report(const char *name)
+{
+    if (test_failures) {
+        printf("❌ %s test FAILED (%d)\n", name, test_failures);
+        return 1;
+    }
+    printf("✅ %s test PASSED\n", name);
+    return 0;
+}
+
 #endif /* TEST_PORTABILITY_H */